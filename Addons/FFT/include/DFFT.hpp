@@ -34,6 +34,11 @@
 
 #include <fftw3.h>
 
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+
 namespace smil
 {
   /**
@@ -42,104 +47,591 @@ namespace smil
    * @{
    */
 
+#ifndef SWIG
+  /** @cond */
+  /*
+   * Smallest size not below n whose prime factors are 2, 3, 5 or 7, for
+   * which FFTW is the fastest
+   */
+  inline size_t fftSize(size_t n)
+  {
+    for (;; n++) {
+      size_t m = n;
+      for (size_t p = 2; p <= 7; p++)
+        while (m % p == 0)
+          m /= p;
+      if (m == 1)
+        return n;
+    }
+  }
+
+  /*
+   * The FFTW planner isn't thread safe : plans are created by the calling
+   * thread, with as many FFTW threads as Smil uses when FFTW has been built
+   * with them
+   */
+  inline void fftwPlannerThreads()
+  {
+#ifdef USE_FFTW_THREADS
+    static bool initialized = false;
+    if (!initialized) {
+      fftw_init_threads();
+      initialized = true;
+    }
+    fftw_plan_with_nthreads(Core::getInstance()->getNumberOfThreads());
+#endif // USE_FFTW_THREADS
+  }
+
+  /*
+   * Integer results are rounded and saturated
+   */
+  template <class T>
+  ENABLE_IF(!IS_FLOAT(T), T) fftValue(double v)
+  {
+    v = std::floor(v + 0.5);
+    v = std::max(v, double(ImDtTypes<T>::min()));
+    return T(std::min(v, double(ImDtTypes<T>::max())));
+  }
+
+  template <class T>
+  ENABLE_IF(IS_FLOAT(T), T) fftValue(double v)
+  {
+    return T(v);
+  }
+
+  /*
+   * Buffers of a real image and of its half spectrum
+   */
+  class FFTBuffers
+  {
+  public:
+    FFTBuffers(size_t pixNbr = 0, size_t specNbr = 0)
+        : real(NULL), spectrum(NULL)
+    {
+      resize(pixNbr, specNbr);
+    }
+    ~FFTBuffers()
+    {
+      resize(0, 0);
+    }
+
+    void resize(size_t pixNbr, size_t specNbr)
+    {
+      fftw_free(real);
+      fftw_free(spectrum);
+      real     = pixNbr ? fftw_alloc_real(pixNbr) : NULL;
+      spectrum = specNbr ? fftw_alloc_complex(specNbr) : NULL;
+    }
+
+    double       *real;
+    fftw_complex *spectrum;
+
+  private:
+    FFTBuffers(const FFTBuffers &);
+    FFTBuffers &operator=(const FFTBuffers &);
+  };
+  /** @endcond */
+#endif // SWIG
+
   /**
-   * 2D image (normalized) cross correlation using FFT.
+   * FFT context
    *
-   * Input images must have same size.
+   * Keeps the FFTW plans and buffers of each image size, and the spectrum of
+   * a template image, so that correlating or convolving many images with the
+   * same template only costs one forward and one backward transform per
+   * image. Plans are created at the first use of a size, and are executed
+   * by several threads when FFTW has been built with threads support.
    *
-   * Can be used to find a template image within a larger one:
+   * @b Example:
+   * @code{.py}
+   * import smilPython as sp
    *
-   * \code
-   * correlation(sourceImg, templateImg, corrImg)
-   * pt = IntPoint()
-   * maxVal(corrImg, pt)
-   * # gives the position of the template image within the source image
-   * print pt.x, pt.y
-   * \endcode
+   * ctx = sp.FFTContext(True, "fftw.wisdom")
+   * ctx.setTemplate(imTpl)
+   * for im, out in zip(tiles, outs):
+   *   ctx.correlation(im, out)
+   * @endcode
+   *
+   * @note
+   * Contexts must not be created or used concurrently by several threads,
+   * the FFTW planner not being thread safe.
    */
-  template <class T1, class T2>
-  RES_T correlation(Image<T1> &imIn1, Image<T1> &imIn2, Image<T2> &imOut)
+  class FFTContext
   {
-    ASSERT_SAME_SIZE(&imIn1, &imIn2);
+  public:
+    /**
+     * @param[in] measure : plan transforms with @b FFTW_MEASURE (slower
+     * planning, faster transforms) instead of @b FFTW_ESTIMATE. Worth it
+     * when many images of the same size are processed.
+     * @param[in] wisdomFile : file the FFTW wisdom is read from at
+     * construction, if it exists, and saved to at destruction. Empty to
+     * disable.
+     */
+    FFTContext(bool measure = true, const std::string &wisdomFile = "")
+        : flags(measure ? FFTW_MEASURE : FFTW_ESTIMATE),
+          wisdomFile(wisdomFile), tplWidth(0), tplHeight(0), tplSum(0.)
+    {
+      if (!wisdomFile.empty())
+        fftw_import_wisdom_from_filename(wisdomFile.c_str());
+    }
+
+    ~FFTContext()
+    {
+      clear();
+      if (!wisdomFile.empty())
+        fftw_export_wisdom_to_filename(wisdomFile.c_str());
+    }
+
+    /**
+     * clear() - Destroy the plans and buffers of all image sizes
+     */
+    void clear()
+    {
+      clearTransforms(corrTransforms);
+      clearTransforms(convTransforms);
+    }
+
+    /**
+     * setTemplate() - Set the template (or kernel) image
+     *
+     * Its spectrum is computed once per image size, then kept.
+     *
+     * @param[in] imTpl : 2D template image
+     */
+    template <class T>
+    RES_T setTemplate(const Image<T> &imTpl)
+    {
+      ASSERT_ALLOCATED(&imTpl);
+      ASSERT(imTpl.getDepth() == 1, "Only 2D images are supported",
+             RES_ERR_BAD_SIZE);
+
+      tplWidth  = imTpl.getWidth();
+      tplHeight = imTpl.getHeight();
+      tplPixels.resize(tplWidth * tplHeight);
+      tplSum = 0.;
+
+      const T *pixels = imTpl.getPixels();
+      for (size_t i = 0; i < tplPixels.size(); i++) {
+        tplPixels[i] = double(pixels[i]);
+        tplSum += tplPixels[i];
+      }
+
+      std::map<ImageSize, Transform>::iterator it;
+      for (it = corrTransforms.begin(); it != corrTransforms.end(); it++)
+        setTemplateSpectrum(it->second, false);
+      for (it = convTransforms.begin(); it != convTransforms.end(); it++)
+        setTemplateSpectrum(it->second, true);
+
+      return RES_OK;
+    }
+
+    /**
+     * correlation() - Normalized cross correlation with the template
+     *
+     * Same as the correlation() function, the template being zero padded up
+     * to the size of @b imIn.
+     *
+     * @param[in] imIn : 2D input image, not smaller than the template
+     * @param[out] imOut : output image, resized as @b imIn
+     */
+    template <class T1, class T2>
+    RES_T correlation(const Image<T1> &imIn, Image<T2> &imOut)
+    {
+      ASSERT_ALLOCATED(&imIn);
+      ASSERT(imIn.getDepth() == 1, "Only 2D images are supported",
+             RES_ERR_BAD_SIZE);
+
+      Transform *t = getTransform(imIn, false);
+      ASSERT(t != NULL, "Template not set or larger than the input image",
+             RES_ERR_BAD_SIZE);
+
+      imOut.setSize(imIn);
+      correlateImage(*t, imIn.getPixels(), imOut.getPixels(),
+                     t->buffers.real, t->buffers.spectrum);
+      imOut.modified();
+
+      return RES_OK;
+    }
+
+    /**
+     * convolve() - Convolution with the template, as kernel
+     *
+     * The kernel center is the template pixel (width / 2, height / 2).
+     * Images are zero padded, so that they don't wrap around, and border
+     * pixels are normalized by the weight of the part of the kernel inside
+     * the image, as in the convolve() function of the @b Base module,
+     * unless kernel weights, or the ones of this part, sum up to zero.
+     * Integer results are rounded and saturated.
+     *
+     * @note
+     * The cost doesn't depend on the size of the kernel : for kernels of
+     * more than a few tens of pixels, this is faster than direct
+     * convolution.
+     *
+     * @param[in] imIn : 2D input image
+     * @param[out] imOut : output image, resized as @b imIn
+     */
+    template <class T1, class T2>
+    RES_T convolve(const Image<T1> &imIn, Image<T2> &imOut)
+    {
+      ASSERT_ALLOCATED(&imIn);
+      ASSERT(imIn.getDepth() == 1, "Only 2D images are supported",
+             RES_ERR_BAD_SIZE);
 
-    size_t ncols = imIn1.getWidth();
-    // complex data column nbr
-    size_t nccols = ncols;
-    size_t nrows  = imIn2.getHeight();
+      Transform *t = getTransform(imIn, true);
+      ASSERT(t != NULL, "Template not set", RES_ERR_BAD_SIZE);
 
-    imOut.setSize(ncols, nrows);
+      imOut.setSize(imIn);
+      convolveImage(*t, imIn.getPixels(), imOut.getPixels(), t->buffers.real,
+                    t->buffers.spectrum);
+      imOut.modified();
 
-    size_t pixNbr = ncols * nrows;
+      return RES_OK;
+    }
+
+#ifndef SWIG
+    /**
+     * correlation() - Batched correlation with the template
+     *
+     * Same as above for a list of images, which may have different sizes.
+     * Images are processed in parallel, unless transforms already are.
+     *
+     * @param[in] imIns : 2D input images
+     * @param[out] imOuts : output images, as many as @b imIns
+     */
+    template <class T1, class T2>
+    RES_T correlation(const std::vector<Image<T1> *> &imIns,
+                      std::vector<Image<T2> *>       &imOuts)
+    {
+      return batch(imIns, imOuts, false);
+    }
 
-    // Allocate arrays for FFT of src and tpl
-    double       *src1_real  = fftw_alloc_real(pixNbr);
-    fftw_complex *src1_compl = fftw_alloc_complex(nccols * nrows);
-    double       *src2_real  = fftw_alloc_real(pixNbr);
-    fftw_complex *src2_compl = fftw_alloc_complex(nccols * nrows);
+    /**
+     * convolve() - Batched convolution with the template
+     *
+     * Same as above for a list of images, which may have different sizes.
+     * Images are processed in parallel, unless transforms already are.
+     *
+     * @param[in] imIns : 2D input images
+     * @param[out] imOuts : output images, as many as @b imIns
+     */
+    template <class T1, class T2>
+    RES_T convolve(const std::vector<Image<T1> *> &imIns,
+                   std::vector<Image<T2> *>       &imOuts)
+    {
+      return batch(imIns, imOuts, true);
+    }
+#endif // SWIG
 
-    double       *res_real  = fftw_alloc_real(pixNbr);
-    fftw_complex *res_compl = fftw_alloc_complex(nccols * nrows);
+  private:
+    /** @cond */
+    typedef std::pair<size_t, size_t> ImageSize;
 
-    T1 *src1_data = imIn1.getPixels();
-    T1 *src2_data = imIn2.getPixels();
-    T2 *out_data  = imOut.getPixels();
+    /*
+     * Plans and buffers of an imWidth x imHeight image size. Transforms are
+     * padded to width x height. Convolutions also keep the normalization
+     * factor of the image pixels, empty when borders aren't normalized.
+     */
+    struct Transform
+    {
+      size_t              imWidth, imHeight, width, height, specNbr;
+      fftw_plan           forward, backward;
+      FFTBuffers          buffers, tplSpectrum;
+      std::vector<double> normalization;
+    };
 
-    // Copy image pixel values
-    for (size_t i = 0; i < pixNbr; i++) {
-      src1_real[i] = (double) src1_data[i];
-      src2_real[i] = (double) src2_data[i];
+    void clearTransforms(std::map<ImageSize, Transform> &transforms)
+    {
+      std::map<ImageSize, Transform>::iterator it;
+      for (it = transforms.begin(); it != transforms.end(); it++) {
+        fftw_destroy_plan(it->second.forward);
+        fftw_destroy_plan(it->second.backward);
+      }
+      transforms.clear();
     }
 
-    // Create FFTW plans
-    fftw_plan forward1 = fftw_plan_dft_r2c_2d(nrows, ncols, src1_real,
-                                              src1_compl, FFTW_ESTIMATE);
-    fftw_plan forward2 = fftw_plan_dft_r2c_2d(nrows, ncols, src2_real,
-                                              src2_compl, FFTW_ESTIMATE);
-    fftw_plan backward = fftw_plan_dft_c2r_2d(nrows, ncols, res_compl, res_real,
-                                              FFTW_BACKWARD | FFTW_ESTIMATE);
+    /*
+     * Transform of the size of im, created at the first call. NULL if the
+     * template isn't set, or if it is larger than im for correlations.
+     */
+    template <class T>
+    Transform *getTransform(const Image<T> &im, bool conv)
+    {
+      if (tplPixels.empty())
+        return NULL;
 
-    // Compute the FFT of the images
-    fftw_execute(forward1);
-    fftw_execute(forward2);
+      ImageSize size(im.getWidth(), im.getHeight());
+      if (!conv && (size.first < tplWidth || size.second < tplHeight))
+        return NULL;
 
-    // Compute the cross-correlation
-    for (size_t i = 0; i < pixNbr; i++) {
-      res_compl[i][0] = (src1_compl[i][0] * src2_compl[i][0] +
-                         src1_compl[i][1] * src2_compl[i][1]);
-      res_compl[i][1] = (src1_compl[i][1] * src2_compl[i][0] -
-                         src1_compl[i][0] * src2_compl[i][1]);
+      std::map<ImageSize, Transform> &transforms =
+          conv ? convTransforms : corrTransforms;
+      std::map<ImageSize, Transform>::iterator it = transforms.find(size);
+      if (it != transforms.end())
+        return &it->second;
+
+      Transform &t = transforms[size];
+      t.imWidth    = t.width  = size.first;
+      t.imHeight   = t.height = size.second;
+      if (conv) {
+        // Enough to avoid wrapping around on both sides of the kernel center
+        t.width  = fftSize(t.width + tplWidth / 2);
+        t.height = fftSize(t.height + tplHeight / 2);
+      }
+      t.specNbr = t.height * (t.width / 2 + 1);
+      t.buffers.resize(t.width * t.height, t.specNbr);
+      t.tplSpectrum.resize(0, t.specNbr);
+
+      // Planning with FFTW_MEASURE overwrites the buffers
+      fftwPlannerThreads();
+      t.forward  = fftw_plan_dft_r2c_2d(t.height, t.width, t.buffers.real,
+                                        t.buffers.spectrum, flags);
+      t.backward = fftw_plan_dft_c2r_2d(t.height, t.width, t.buffers.spectrum,
+                                        t.buffers.real, flags);
+
+      setTemplateSpectrum(t, conv);
+      return &t;
+    }
+
+    /*
+     * Spectrum of the template zero padded to the transform size. Kernels
+     * are centered on the origin, wrapping around.
+     */
+    void setTemplateSpectrum(Transform &t, bool conv)
+    {
+      double *real = t.buffers.real;
+      std::fill(real, real + t.width * t.height, 0.);
+
+      size_t cx = conv ? tplWidth / 2 : 0, cy = conv ? tplHeight / 2 : 0;
+      for (size_t y = 0; y < tplHeight; y++) {
+        size_t ty = (y + t.height - cy) % t.height;
+        for (size_t x = 0; x < tplWidth; x++) {
+          size_t tx = (x + t.width - cx) % t.width;
+          real[ty * t.width + tx] = tplPixels[y * tplWidth + x];
+        }
+      }
+      fftw_execute_dft_r2c(t.forward, real, t.tplSpectrum.spectrum);
+
+      t.normalization.clear();
+      if (!conv || std::abs(tplSum) <= 1e-12 * tplAbsSum())
+        return;
+
+      // Weight of the kernel part inside the image, by convolving the
+      // image support
+      std::fill(real, real + t.width * t.height, 0.);
+      for (size_t y = 0; y < t.imHeight; y++)
+        std::fill(real + y * t.width, real + y * t.width + t.imWidth, 1.);
+      fftw_execute_dft_r2c(t.forward, real, t.buffers.spectrum);
+      multiplySpectra(t, t.buffers.spectrum, false);
+      fftw_execute_dft_c2r(t.backward, t.buffers.spectrum, real);
+
+      // With mixed sign kernels, this weight may vanish : such pixels are
+      // left unnormalized, as when the whole kernel sums up to zero. The
+      // transform scales the weight by the number of samples.
+      double scale   = 1. / double(t.width * t.height);
+      double epsilon = 1e-9 * tplAbsSum();
+
+      t.normalization.resize(t.imWidth * t.imHeight);
+      for (size_t y = 0, i = 0; y < t.imHeight; y++)
+        for (size_t x = 0; x < t.imWidth; x++, i++) {
+          double weight = real[y * t.width + x] * scale;
+          t.normalization[i] =
+              std::abs(weight) > epsilon ? scale * tplSum / weight : scale;
+        }
+    }
 
-      double norm = std::sqrt(std::pow(res_compl[i][0], 2) +
-                              std::pow(res_compl[i][1], 2));
-      res_compl[i][0] /= norm;
-      res_compl[i][1] /= norm;
+    double tplAbsSum() const
+    {
+      double sum = 0.;
+      for (size_t i = 0; i < tplPixels.size(); i++)
+        sum += std::abs(tplPixels[i]);
+      return sum;
     }
 
-    // Compute result inverse fft
-    fftw_execute(backward);
+    /*
+     * spectrum = spectrum * template spectrum, or its conjugate
+     */
+    void multiplySpectra(const Transform &t, fftw_complex *spectrum,
+                         bool conjugate) const
+    {
+      const fftw_complex *tpl = t.tplSpectrum.spectrum;
+      double              s   = conjugate ? -1. : 1.;
+      for (size_t i = 0; i < t.specNbr; i++) {
+        double a = spectrum[i][0], b = spectrum[i][1];
+        double c = tpl[i][0], d = s * tpl[i][1];
+        spectrum[i][0] = a * c - b * d;
+        spectrum[i][1] = b * c + a * d;
+      }
+    }
+
+    /*
+     * The transform buffers of the calling thread are real and spectrum
+     */
+    template <class T1, class T2>
+    void correlateImage(const Transform &t, const T1 *in, T2 *out, double *real,
+                   fftw_complex *spectrum) const
+    {
+      size_t pixNbr = t.width * t.height;
+
+      for (size_t i = 0; i < pixNbr; i++)
+        real[i] = double(in[i]);
+      fftw_execute_dft_r2c(t.forward, real, spectrum);
+
+      multiplySpectra(t, spectrum, true);
+      for (size_t i = 0; i < t.specNbr; i++) {
+        double norm = std::sqrt(spectrum[i][0] * spectrum[i][0] +
+                                spectrum[i][1] * spectrum[i][1]);
+        if (norm > 0.) {
+          spectrum[i][0] /= norm;
+          spectrum[i][1] /= norm;
+        }
+      }
+      fftw_execute_dft_c2r(t.backward, spectrum, real);
+
+      // Base results are between -1 and 1. We stretch/translate values to
+      // the output type value range.
+      for (size_t i = 0; i < pixNbr; i++) {
+        double v = ImDtTypes<T2>::min() + (real[i] / pixNbr + 1) *
+                                              ImDtTypes<T2>::cardinal() / 2;
+        out[i] = T2(std::min(v, double(ImDtTypes<T2>::max())));
+      }
+    }
+
+    template <class T1, class T2>
+    void convolveImage(const Transform &t, const T1 *in, T2 *out,
+                       double *real, fftw_complex *spectrum) const
+    {
+      std::fill(real, real + t.width * t.height, 0.);
+      for (size_t y = 0, i = 0; y < t.imHeight; y++)
+        for (size_t x = 0; x < t.imWidth; x++, i++)
+          real[y * t.width + x] = double(in[i]);
+      fftw_execute_dft_r2c(t.forward, real, spectrum);
+
+      multiplySpectra(t, spectrum, false);
+      fftw_execute_dft_c2r(t.backward, spectrum, real);
+
+      double scale = 1. / double(t.width * t.height);
+      for (size_t y = 0, i = 0; y < t.imHeight; y++)
+        for (size_t x = 0; x < t.imWidth; x++, i++) {
+          double v = real[y * t.width + x];
+          v *= t.normalization.empty() ? scale : t.normalization[i];
+          out[i] = fftValue<T2>(v);
+        }
+    }
+
+#ifndef SWIG
+    template <class T1, class T2>
+    RES_T batch(const std::vector<Image<T1> *> &imIns,
+                std::vector<Image<T2> *> &imOuts, bool conv)
+    {
+      ASSERT(imIns.size() == imOuts.size(),
+             "Expected as many output images as input ones", RES_ERR);
+
+      // Plans are created first, the planner not being thread safe
+      std::vector<Transform *> transforms(imIns.size());
+      for (size_t k = 0; k < imIns.size(); k++) {
+        ASSERT_ALLOCATED(imIns[k]);
+        ASSERT(imIns[k]->getDepth() == 1, "Only 2D images are supported",
+               RES_ERR_BAD_SIZE);
+        transforms[k] = getTransform(*imIns[k], conv);
+        ASSERT(transforms[k] != NULL,
+               "Template not set or larger than an input image",
+               RES_ERR_BAD_SIZE);
+        imOuts[k]->setSize(*imIns[k]);
+      }
+
+      int nImages = int(imIns.size());
+#if defined USE_OPEN_MP && !defined USE_FFTW_THREADS
+      int nthreads = Core::getInstance()->getNumberOfThreads();
+#pragma omp parallel num_threads(nthreads)
+#endif // USE_OPEN_MP && !USE_FFTW_THREADS
+      {
+        // Buffers of the thread, reallocated when the image size changes
+        FFTBuffers       buffers;
+        const Transform *current = NULL;
+
+#if defined USE_OPEN_MP && !defined USE_FFTW_THREADS
+#pragma omp for schedule(dynamic)
+#endif // USE_OPEN_MP && !USE_FFTW_THREADS
+        for (int k = 0; k < nImages; k++) {
+          const Transform &t = *transforms[k];
+          if (&t != current) {
+            buffers.resize(t.width * t.height, t.specNbr);
+            current = &t;
+          }
+          if (conv)
+            convolveImage(t, imIns[k]->getPixels(), imOuts[k]->getPixels(),
+                          buffers.real, buffers.spectrum);
+          else
+            correlateImage(t, imIns[k]->getPixels(), imOuts[k]->getPixels(),
+                           buffers.real, buffers.spectrum);
+        }
+      }
 
-    // Copy results to imOut
-    // Base results are between -1 and 1. We stretch/translate values to the
-    // output type value range.
-    for (size_t i = 0; i < pixNbr; i++) {
-      out_data[i] = ImDtTypes<T2>::min() +
-                    (res_real[i] / pixNbr + 1) * ImDtTypes<T2>::cardinal() / 2;
+      for (size_t k = 0; k < imOuts.size(); k++)
+        imOuts[k]->modified();
+      return RES_OK;
     }
+#endif // SWIG
 
-    // Clear memory
-    fftw_destroy_plan(forward1);
-    fftw_destroy_plan(forward2);
-    fftw_destroy_plan(backward);
-    fftw_free(src1_real);
-    fftw_free(src1_compl);
-    fftw_free(src2_real);
-    fftw_free(src2_compl);
-    fftw_free(res_real);
-    fftw_free(res_compl);
+    unsigned            flags;
+    std::string         wisdomFile;
+    size_t              tplWidth, tplHeight;
+    double              tplSum;
+    std::vector<double> tplPixels;
 
-    imOut.modified();
+    std::map<ImageSize, Transform> corrTransforms, convTransforms;
+    /** @endcond */
+  };
 
-    return RES_OK;
+  /**
+   * 2D image (normalized) cross correlation using FFT.
+   *
+   * Input images must have same size.
+   *
+   * Can be used to find a template image within a larger one:
+   *
+   * \code
+   * correlation(sourceImg, templateImg, corrImg)
+   * pt = IntPoint()
+   * maxVal(corrImg, pt)
+   * # gives the position of the template image within the source image
+   * print pt.x, pt.y
+   * \endcode
+   *
+   * @see FFTContext, to correlate many images with the same template
+   */
+  template <class T1, class T2>
+  RES_T correlation(const Image<T1> &imIn1, const Image<T1> &imIn2,
+                    Image<T2> &imOut)
+  {
+    ASSERT_SAME_SIZE(&imIn1, &imIn2);
+
+    FFTContext context(false);
+    ASSERT(context.setTemplate(imIn2) == RES_OK);
+    return context.correlation(imIn1, imOut);
+  }
+
+  /**
+   * 2D convolution with a kernel image using FFT
+   *
+   * See FFTContext::convolve() for borders and rounding.
+   *
+   * @param[in] imIn : input image
+   * @param[in] imKernel : kernel, centered on its pixel (width / 2,
+   * height / 2). Its type doesn't need to be the one of the images, e.g. a
+   * floating point kernel may be used on 8 bits images.
+   * @param[out] imOut : output image
+   *
+   * @see FFTContext, to convolve many images with the same kernel
+   */
+  template <class T1, class T2, class T3>
+  RES_T fftConvolve(const Image<T1> &imIn, const Image<T2> &imKernel,
+                    Image<T3> &imOut)
+  {
+    FFTContext context(false);
+    ASSERT(context.setTemplate(imKernel) == RES_OK);
+    return context.convolve(imIn, imOut);
   }
 
   /**@}*/
@@ -41,3 +41,8 @@ SMIL_MODULE(smilFFT)
 
 %include "DFFT.hpp"
 TEMPLATE_WRAP_FUNC_2T_CROSS(correlation);
+TEMPLATE_WRAP_FUNC_3T_CROSS(fftConvolve);
+
+TEMPLATE_WRAP_CLASS_MEMBER_FUNC(FFTContext, setTemplate);
+TEMPLATE_WRAP_CLASS_MEMBER_FUNC_2T_CROSS(FFTContext, correlation);
+TEMPLATE_WRAP_CLASS_MEMBER_FUNC_2T_CROSS(FFTContext, convolve);
@@ -53,11 +53,120 @@ class Test_Correlation : public TestCase
     }
 };
 
+class Test_FFTContext : public TestCase
+{
+    virtual void run()
+    {
+        Image<UINT8> im1(7, 5);
+        Image<UINT8> im2(im1);
+        Image<UINT8> im3(im1);
+
+        for (size_t i = 0; i < im1.getPixelCount(); i++)
+          im1.getPixels()[i] = (i * 37) % 101;
+        fill(im2, UINT8(0));
+        im2.setPixel(1, 2, 100);
+
+        correlation(im1, im2, im3);
+
+        // Same results, plans and template spectrum being reused
+        FFTContext context(false);
+        context.setTemplate(im2);
+
+        Image<UINT8> im4, im5;
+        context.correlation(im1, im4);
+        context.correlation(im1, im5);
+        TEST_ASSERT(im4==im3);
+        TEST_ASSERT(im5==im3);
+
+        vector<Image<UINT8> *> imIns(2, &im1), imOuts;
+        imOuts.push_back(&im4);
+        imOuts.push_back(&im5);
+        fill(im4, UINT8(0));
+        fill(im5, UINT8(0));
+        context.correlation(imIns, imOuts);
+        TEST_ASSERT(im4==im3);
+        TEST_ASSERT(im5==im3);
+    }
+};
+
+class Test_FFTConvolve : public TestCase
+{
+    virtual void run()
+    {
+        UINT8 vec1[15] = 
+        {
+          10, 20, 30, 40, 50,
+          60, 70, 80, 90, 100,
+          10, 10, 10, 10, 10,
+        };
+        Image<UINT8> im1(5, 3);
+        im1 << vec1;
+
+        // Borders are normalized
+        float vecKern[3] = { 0.25, 0.5, 0.25 };
+        Image<float> imKern(3, 1);
+        imKern << vecKern;
+
+        Image<float> im2;
+        fftConvolve(im1, imKern, im2);
+
+        float vecTruth[15] = 
+        {
+          13.3333333f, 20, 30, 40, 46.6666667f,
+          63.3333333f, 70, 80, 90, 96.6666667f,
+          10, 10, 10, 10, 10,
+        };
+        Image<float> imTruth(5, 3);
+        imTruth << vecTruth;
+
+        for (size_t i = 0; i < imTruth.getPixelCount(); i++)
+          TEST_ASSERT(std::abs(im2.getPixels()[i] - imTruth.getPixels()[i])
+                      < 1e-3);
+
+        // 8 bits images with a floating point kernel : rounded results
+        UINT8 vecTruth8[15] = 
+        {
+          13, 20, 30, 40, 47,
+          63, 70, 80, 90, 97,
+          10, 10, 10, 10, 10,
+        };
+        Image<UINT8> im3, imTruth8(5, 3);
+        imTruth8 << vecTruth8;
+
+        fftConvolve(im1, imKern, im3);
+        TEST_ASSERT(im3==imTruth8);
+
+        // Mixed sign kernel : the part inside the image weighs 2 on the left
+        // border, and nothing on the right one, left unnormalized
+        float vecKern2[3] = { 1, 1, -1 };
+        Image<float> imKern2(3, 1);
+        imKern2 << vecKern2;
+
+        fftConvolve(im1, imKern2, im2);
+
+        float vecTruth2[15] = 
+        {
+          15, 40, 50, 60, 10,
+          65, 90, 100, 110, 10,
+          10, 10, 10, 10, 0,
+        };
+        imTruth << vecTruth2;
+
+        for (size_t i = 0; i < imTruth.getPixelCount(); i++)
+          TEST_ASSERT(std::abs(im2.getPixels()[i] - imTruth.getPixels()[i])
+                      < 1e-3);
+        if (retVal!=RES_OK)
+          im2.printSelf(1);
+    }
+};
+
 
 int main(int, char *[])
 {
       TestSuite ts;
       ADD_TEST(ts, Test_Correlation);
+      ADD_TEST(ts, Test_FFTContext);
+      ADD_TEST(ts, Test_FFTConvolve);
 
       return ts.run();
   
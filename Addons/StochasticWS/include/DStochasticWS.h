@@ -66,11 +66,40 @@ namespace smil
    * @param[out] out
    * @param[in] n_seeds
    * @param[in] se
+   * @param[in] seed : seed of the random markers. Results only depend on
+   * this seed, not on the number of threads
    */
   template <class labelT, class T>
   void stochasticWatershedParallel(const Image<labelT> &primary,
                                    const Image<T> &gradient, Image<labelT> &out,
-                                   const size_t &n_seeds, const StrElt &se);
+                                   const size_t &n_seeds, const StrElt &se,
+                                   const size_t &seed = 0);
+
+  /**
+   * exactStochasticWatershed
+   *
+   * Probability of each boundary of the mosaic to be cut by the watershed of
+   * random markers, as estimated by stochasticWatershedParallel(), but
+   * computed exactly instead of by Monte Carlo sampling.
+   *
+   * @note
+   * The probability of an edge of the minimum spanning tree only depends on
+   * the masses of the two regions it joins in the Kruskal order. They are
+   * gathered in one pass over the tree, so the cost doesn't depend on any
+   * number of realizations.
+   *
+   * @param[in] primary
+   * @param[in] gradient
+   * @param[out] out
+   * @param[in] se
+   * @param[in] distribution : distribution of the markers over the regions,
+   * @b uniform or proportional to their @b area
+   */
+  template <class labelT, class T>
+  RES_T exactStochasticWatershed(const Image<labelT> &primary,
+                                 const Image<T> &gradient, Image<labelT> &out,
+                                 const StrElt &se,
+                                 const string &distribution = "uniform");
 
   /**
    * stochasticWatershed
@@ -80,11 +109,14 @@ namespace smil
    * @param[out] out
    * @param[in] n_seeds
    * @param[in] se
+   * @param[in] seed : seed of the random markers. Results only depend on
+   * this seed, not on the number of threads
    */
   template <class labelT, class T>
   void stochasticWatershed(const Image<labelT> &primary,
                            const Image<T> &gradient, Image<labelT> &out,
-                           const size_t &n_seeds, const StrElt &se);
+                           const size_t &n_seeds, const StrElt &se,
+                           const size_t &seed = 0);
 
   /**
    * stochasticFlatZonesParallel
@@ -95,12 +127,15 @@ namespace smil
    * @param[in] n_seeds
    * @param[in] t0
    * @param[in] se
+   * @param[in] seed : seed of the random markers. Results only depend on
+   * this seed, not on the number of threads
    */
   template <class labelT, class T>
   size_t stochasticFlatZonesParallel(const Image<labelT> &primary,
                                      const Image<T>      &gradient,
                                      Image<labelT> &out, const size_t &n_seeds,
-                                     const double &t0, const StrElt &se);
+                                     const double &t0, const StrElt &se,
+                                     const size_t &seed = 0);
 
   /**
    *  Over Segmentation Correction
@@ -111,12 +146,14 @@ namespace smil
    * @param[in] n_seeds
    * @param[in] t0
    * @param[in] se
+   * @param[in] seed : seed of the random markers. Results only depend on
+   * this seed, not on the number of threads
    */
   template <class labelT, class T>
   size_t stochasticFlatZones(const Image<labelT> &primary,
                              const Image<T> &gradient, Image<labelT> &out,
                              const size_t &n_seeds, const double &t0,
-                             const StrElt &se);
+                             const StrElt &se, const size_t &seed = 0);
 
   /**
    *  Over Segmentation Correction
@@ -127,12 +164,15 @@ namespace smil
    * @param[in] n_seeds
    * @param[in] r0
    * @param[in] se
+   * @param[in] seed : seed of the random markers. Results only depend on
+   * this seed, not on the number of threads
    */
   template <class labelT, class T>
   size_t overSegmentationCorrection(const Image<labelT> &primary,
                                     const Image<T>      &gradient,
                                     Image<labelT> &out, const size_t &n_seeds,
-                                    const double &r0, const StrElt &se);
+                                    const double &r0, const StrElt &se,
+                                    const size_t &seed = 0);
 
   /** @} */
 
@@ -33,8 +33,10 @@
 #include "Morpho/include/DMorpho.h"
 #include "DUtils.h"
 #include <math.h>
-#include <random>
-#include <chrono>
+
+#ifdef USE_OPEN_MP
+#include <omp.h>
+#endif // USE_OPEN_MP
 
 namespace smil
 {
@@ -506,32 +508,23 @@ namespace smil
                                                   graph.nodes[i].dist_max));
     }
 
-    vector<stochastic_edge<labelT, T>> edges = graph.edges;
-    std::sort(edges.begin(), edges.end(), compAltitude<labelT, T>);
-    vector<stochastic_edge<labelT, T>> mst_edges;
-
-    struct subset subsets[graph.nodes.size()];
-    // Initialise subsets for union-find.
-    for (uint32_t i = 0; i < graph.nodes.size(); ++i) {
-      subsets[i].parent = i;
-      subsets[i].rank   = 0;
-    }
+    // Tree of the lowest altitudes, computed by graphMSTEdges() on a CSR
+    // copy of the graph. Edges come in Kruskal order.
+    typedef CSRGraph<size_t, T> csrGraphT;
 
-    uint32_t nbr_of_edges = 0;
-    uint32_t i            = 0;
-    while (nbr_of_edges != graph.nodes.size() - 2) {
-      stochastic_edge<labelT, T> e = edges[i];
-      ++i;
+    typename csrGraphT::EdgeListType edges(graph.edges.size());
+    for (uint32_t i = 0; i < graph.edges.size(); ++i)
+      edges[i] = typename csrGraphT::EdgeType(
+          graph.edges[i].source, graph.edges[i].dest, graph.edges[i].altitude);
 
-      int x = Find(subsets, e.source);
-      int y = Find(subsets, e.dest);
+    csrGraphT csrGraph;
+    csrGraph.build(edges);
+    std::vector<size_t> mst_indexes = graphMSTEdges(csrGraph);
 
-      if (x != y) {
-        mst_edges.push_back(e);
-        ++nbr_of_edges;
-        Union(subsets, x, y);
-      }
-    }
+    vector<stochastic_edge<labelT, T>> mst_edges;
+    mst_edges.reserve(mst_indexes.size());
+    for (uint32_t i = 0; i < mst_indexes.size(); ++i)
+      mst_edges.push_back(graph.edges[mst_indexes[i]]);
 
     out.edges = mst_edges;
 
@@ -544,10 +537,11 @@ namespace smil
   }
 
   template <class labelT, class T>
-  std::vector<double> areaDistribution(stochastic_graph<labelT, T> graph)
+  std::vector<double>
+  areaDistribution(const stochastic_graph<labelT, T> &graph)
   {
     std::vector<double> out;
-    double              total_area;
+    double              total_area = 0.;
 
     for (uint32_t i = 0; i < graph.nodes.size(); ++i) {
       out.push_back(double(graph.nodes[i].area));
@@ -559,7 +553,8 @@ namespace smil
     return out;
   }
   template <class labelT, class T>
-  std::vector<double> uniformDistribution(stochastic_graph<labelT, T> graph)
+  std::vector<double>
+  uniformDistribution(const stochastic_graph<labelT, T> &graph)
   {
     std::vector<double> out;
     double              total_nodes = graph.nodes.size() - 1;
@@ -572,27 +567,217 @@ namespace smil
     return out;
   }
 
-  std::vector<int> generateMarkers(const std::vector<double>  &prob_dist,
-                                   std::default_random_engine &generator)
+  /*
+   * Counter based random numbers (SplitMix64) : the n-th number of the
+   * stream (seed, key) only depends on these three values. Each realization
+   * has its own stream, so results don't depend on which thread runs it.
+   */
+  class stochastic_rng
   {
-    std::vector<int> markers = std::vector<int>(prob_dist.size(), 0);
-
-    std::uniform_real_distribution<double> distribution(0.0, 1.0);
-    std::uniform_int_distribution<int>     dist2(1, prob_dist.size());
-    //        size_t nbr_markers = prob_dist.size();
-    size_t nbr_markers = dist2(generator);
-
-    for (uint32_t n = 0; n < nbr_markers; ++n) {
-      double number   = distribution(generator);
-      double cumulate = prob_dist[0];
-      int    i        = 0;
-      while (number > cumulate) {
-        i += 1;
-        cumulate += prob_dist[i];
+  public:
+    stochastic_rng(const UINT64 &seed, const UINT64 &key)
+        : state(mix(seed ^ mix(key + 0x9E3779B97F4A7C15ULL))), counter(0)
+    {
+    }
+
+    UINT64 next()
+    {
+      return mix(state + (++counter) * 0x9E3779B97F4A7C15ULL);
+    }
+
+    // Uniform in [0, 1)
+    double uniform()
+    {
+      return double(next() >> 11) * (1. / 9007199254740992.);
+    }
+
+    // Uniform in [0, n)
+    size_t uniformInt(const size_t &n)
+    {
+      return std::min(size_t(uniform() * double(n)), n - 1);
+    }
+
+  private:
+    static UINT64 mix(UINT64 z)
+    {
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+      return z ^ (z >> 31);
+    }
+
+    UINT64 state;
+    UINT64 counter;
+  };
+
+  inline std::vector<double>
+  cumulativeDistribution(const std::vector<double> &prob_dist)
+  {
+    std::vector<double> out(prob_dist.size());
+    double              cumulate = 0.;
+    for (size_t i = 0; i < prob_dist.size(); ++i) {
+      cumulate += prob_dist[i];
+      out[i] = cumulate;
+    }
+    return out;
+  }
+
+  /*
+   * Markers of one realization : a random number of markers in
+   * [1, cumulative.size()], each one drawn by a binary search in the
+   * cumulative distribution.
+   */
+  inline void generateMarkers(const std::vector<double> &cumulative,
+                              stochastic_rng &rng, std::vector<int> &markers)
+  {
+    size_t n = cumulative.size();
+    markers.assign(n, 0);
+
+    size_t nbr_markers = 1 + rng.uniformInt(n);
+    for (size_t m = 0; m < nbr_markers; ++m) {
+      double number = rng.uniform() * cumulative.back();
+      size_t i =
+          std::upper_bound(cumulative.begin(), cumulative.end(), number) -
+          cumulative.begin();
+      ++markers[std::min(i, n - 1)];
+    }
+  }
+
+  /*
+   * Watershed cut of a tree whose edges are sorted by altitude, as given by
+   * KruskalMST() : regions grow along the edges by increasing altitude and an
+   * edge joining two regions which both hold a marker is cut. The count of
+   * each cut edge is incremented. parent and marked are work buffers.
+   */
+  template <class labelT, class T>
+  void watershedMST(const stochastic_graph<labelT, T> &mst,
+                    const std::vector<int>            &markers,
+                    std::vector<size_t> &parent, std::vector<char> &marked,
+                    std::vector<size_t> &counts)
+  {
+    size_t nbr_nodes = mst.nodes.size();
+    parent.resize(nbr_nodes);
+    marked.resize(nbr_nodes);
+    for (size_t i = 0; i < nbr_nodes; ++i) {
+      parent[i] = i;
+      marked[i] = markers[i] > 0;
+    }
+
+    for (size_t k = 0; k < mst.edges.size(); ++k) {
+      size_t a = mst.edges[k].source, b = mst.edges[k].dest;
+      while (parent[a] != a)
+        a = parent[a] = parent[parent[a]];
+      while (parent[b] != b)
+        b = parent[b] = parent[parent[b]];
+
+      if (marked[a] && marked[b]) {
+        ++counts[k];
+        continue;
+      }
+      parent[b] = a;
+      marked[a] = marked[a] || marked[b];
+    }
+  }
+
+  /*
+   * Probability of each edge of the tree to be on the boundary of the
+   * watershed of uniformly drawn markers, estimated on n_seeds realizations.
+   * Realizations are shared between the threads, realization j of the tree
+   * key using the random stream (seed, key * n_seeds + j). Cut counts are
+   * integers, so the result doesn't depend on the number of threads.
+   */
+  template <class labelT, class T>
+  void stochasticMSTWeights(stochastic_graph<labelT, T> &mst,
+                            const size_t &n_seeds, const UINT64 &seed,
+                            const UINT64 &key)
+  {
+    std::vector<double> cumulative =
+        cumulativeDistribution(uniformDistribution(mst));
+    size_t nbr_edges = mst.edges.size();
+
+    int nthreads = 1;
+#ifdef USE_OPEN_MP
+    nthreads = Core::getInstance()->getNumberOfThreads();
+    if (size_t(nthreads) > n_seeds)
+      nthreads = std::max<int>(int(n_seeds), 1);
+#endif // USE_OPEN_MP
+
+    std::vector<std::vector<size_t>> counts(
+        nthreads, std::vector<size_t>(nbr_edges, 0));
+
+#ifdef USE_OPEN_MP
+#pragma omp parallel num_threads(nthreads)
+#endif // USE_OPEN_MP
+    {
+      int tid = 0;
+#ifdef USE_OPEN_MP
+      tid = omp_get_thread_num();
+#endif // USE_OPEN_MP
+      std::vector<int>    markers;
+      std::vector<size_t> parent;
+      std::vector<char>   marked;
+
+#ifdef USE_OPEN_MP
+#pragma omp for schedule(dynamic, 16)
+#endif // USE_OPEN_MP
+      for (size_t j = 0; j < n_seeds; ++j) {
+        stochastic_rng rng(seed, key * n_seeds + j);
+        generateMarkers(cumulative, rng, markers);
+        watershedMST(mst, markers, parent, marked, counts[tid]);
       }
-      ++markers[i];
     }
-    return markers;
+
+    for (size_t k = 0; k < nbr_edges; ++k) {
+      size_t count = 0;
+      for (int t = 0; t < nthreads; ++t)
+        count += counts[t][k];
+      mst.edges[k].weight = double(count) / double(n_seeds);
+    }
+  }
+
+  /*
+   * Mean of (1 - p)^N for N uniform in [1, n] : probability that the markers
+   * of a realization all miss a set of mass p.
+   */
+  inline double markersMissProbability(const double &p, const size_t &n)
+  {
+    if (p <= 0.)
+      return 1.;
+    if (p >= 1.)
+      return 0.;
+    return (1. - p) * -expm1(double(n) * log1p(-p)) / (double(n) * p);
+  }
+
+  /*
+   * Exact probability of each edge of the tree to be cut, with markers drawn
+   * as in stochasticMSTWeights() from the node masses prob_dist. An edge of
+   * the Kruskal order is cut when both regions it joins hold a marker, which
+   * only depends on the masses of these two regions.
+   */
+  template <class labelT, class T>
+  void exactMSTWeights(stochastic_graph<labelT, T> &mst,
+                       const std::vector<double>   &prob_dist)
+  {
+    size_t              nbr_nodes = mst.nodes.size();
+    std::vector<size_t> parent(nbr_nodes);
+    std::vector<double> mass(prob_dist);
+    for (size_t i = 0; i < nbr_nodes; ++i)
+      parent[i] = i;
+
+    for (size_t k = 0; k < mst.edges.size(); ++k) {
+      size_t a = mst.edges[k].source, b = mst.edges[k].dest;
+      while (parent[a] != a)
+        a = parent[a] = parent[parent[a]];
+      while (parent[b] != b)
+        b = parent[b] = parent[parent[b]];
+
+      double p = 1. - markersMissProbability(mass[a], nbr_nodes) -
+                 markersMissProbability(mass[b], nbr_nodes) +
+                 markersMissProbability(mass[a] + mass[b], nbr_nodes);
+      mst.edges[k].weight = std::min(std::max(p, 0.), 1.);
+
+      parent[b] = a;
+      mass[a] += mass[b];
+    }
   }
 
   template <class labelT, class T>
@@ -861,7 +1046,8 @@ namespace smil
   template <class labelT, class T>
   void stochasticWatershedParallel(const Image<labelT> &primary,
                                    const Image<T> &gradient, Image<labelT> &out,
-                                   const size_t &n_seeds, const StrElt &se)
+                                   const size_t &n_seeds, const StrElt &se,
+                                   const size_t &seed)
   {
     fill<labelT>(out, ImDtTypes<labelT>::max());
 
@@ -878,33 +1064,66 @@ namespace smil
       it->weight = 0.;
     }
 
-    std::default_random_engine generator;
-    generator.seed(std::chrono::system_clock::now().time_since_epoch().count());
-
-#pragma omp parallel for
+    // Realizations of each subgraph are run in parallel
     for (uint32_t i = 1; i < nbr_subgraphs + 1; ++i) {
       vector<labelT>              originals;
       stochastic_graph<labelT, T> sub =
           getSubStochasticGraph(graph, i, labels, originals);
       stochastic_graph<labelT, T> mst = KruskalMST(sub);
 
-      for (uint32_t j = 0; j < n_seeds; ++j) {
-        std::vector<double> prob_dist = uniformDistribution(mst);
-        std::vector<int>    markers   = generateMarkers(prob_dist, generator);
-
-        std::vector<size_t> ws = watershedGraph(mst, markers);
-
-        for (typename std::vector<size_t>::iterator it = ws.begin();
-             it != ws.end(); ++it) {
-          mst.edges[*it].weight += 1.;
-        }
-      }
+      stochasticMSTWeights(mst, n_seeds, seed, i);
 
+      // Copy the weights of the subgraph into the graph.
       for (typename std::vector<stochastic_edge<labelT, T>>::iterator it =
                mst.edges.begin();
            it != mst.edges.end(); ++it) {
-        it->weight /= n_seeds;
+        graph
+            .edges[graph.nodes[originals[it->source]]
+                       .edges[originals[it->dest]]]
+            .weight = it->weight;
       }
+    }
+
+    stochasticGraphToPDF(primary, graph, out, se);
+  }
+
+  /**
+   *  Exact Stochastic Watershed
+   *
+   */
+  template <class labelT, class T>
+  RES_T exactStochasticWatershed(const Image<labelT> &primary,
+                                 const Image<T> &gradient, Image<labelT> &out,
+                                 const StrElt &se, const string &distribution)
+  {
+    ASSERT(distribution == "uniform" || distribution == "area",
+           "Unknown distribution (uniform or area)", RES_ERR);
+
+    fill<labelT>(out, ImDtTypes<labelT>::max());
+
+    stochastic_graph<labelT, T> graph;
+    mosaicToStochasticGraph(primary, gradient, graph, se);
+
+    std::vector<labelT> labels;
+    size_t nbr_subgraphs = CCLUnionFind_stochasticGraph(graph, labels);
+
+    // Cutting all edges...
+    for (typename std::vector<stochastic_edge<labelT, T>>::iterator it =
+             graph.edges.begin();
+         it != graph.edges.end(); ++it) {
+      it->weight = 0.;
+    }
+
+    for (uint32_t i = 1; i < nbr_subgraphs + 1; ++i) {
+      vector<labelT>              originals;
+      stochastic_graph<labelT, T> sub =
+          getSubStochasticGraph(graph, i, labels, originals);
+      stochastic_graph<labelT, T> mst = KruskalMST(sub);
+
+      if (distribution == "area")
+        exactMSTWeights(mst, areaDistribution(mst));
+      else
+        exactMSTWeights(mst, uniformDistribution(mst));
 
       // Copy the weights of the subgraph into the graph.
       for (typename std::vector<stochastic_edge<labelT, T>>::iterator it =
@@ -918,6 +1137,7 @@ namespace smil
     }
 
     stochasticGraphToPDF(primary, graph, out, se);
+    return RES_OK;
   }
 
   /**
@@ -927,7 +1147,8 @@ namespace smil
   template <class labelT, class T>
   void stochasticWatershed(const Image<labelT> &primary,
                            const Image<T> &gradient, Image<labelT> &out,
-                           const size_t &n_seeds, const StrElt &se)
+                           const size_t &n_seeds, const StrElt &se,
+                           const size_t &seed)
   {
     fill<labelT>(out, ImDtTypes<labelT>::max());
 
@@ -944,12 +1165,13 @@ namespace smil
       it->weight = 0.;
     }
 
-    std::default_random_engine generator;
-    generator.seed(std::chrono::system_clock::now().time_since_epoch().count());
+    std::vector<double> cumulative =
+        cumulativeDistribution(uniformDistribution(graph));
+    std::vector<int> markers;
 
     for (uint32_t j = 0; j < n_seeds; ++j) {
-      std::vector<double> prob_dist = uniformDistribution(graph);
-      std::vector<int>    markers   = generateMarkers(prob_dist, generator);
+      stochastic_rng rng(seed, j);
+      generateMarkers(cumulative, rng, markers);
 
       std::vector<size_t> ws = watershedGraph(graph, markers);
 
@@ -977,7 +1199,8 @@ namespace smil
   size_t stochasticFlatZonesParallel(const Image<labelT> &primary,
                                      const Image<T>      &gradient,
                                      Image<labelT> &out, const size_t &n_seeds,
-                                     const double &t0, const StrElt &se)
+                                     const double &t0, const StrElt &se,
+                                     const size_t &seed)
   {
     fill<labelT>(out, ImDtTypes<labelT>::max());
 
@@ -994,32 +1217,18 @@ namespace smil
       it->weight = 0.;
     }
 
-    std::default_random_engine generator;
-    generator.seed(std::chrono::system_clock::now().time_since_epoch().count());
-
-#pragma omp parallel for
+    // Realizations of each subgraph are run in parallel
     for (uint32_t i = 1; i < nbr_subgraphs + 1; ++i) {
       vector<labelT>              originals;
       stochastic_graph<labelT, T> sub =
           getSubStochasticGraph(graph, i, labels, originals);
       stochastic_graph<labelT, T> mst = KruskalMST(sub);
 
-      for (uint32_t j = 0; j < n_seeds; ++j) {
-        std::vector<double> prob_dist = uniformDistribution(mst);
-        std::vector<int>    markers   = generateMarkers(prob_dist, generator);
-
-        std::vector<size_t> ws = watershedGraph(mst, markers);
-
-        for (typename std::vector<size_t>::iterator it = ws.begin();
-             it != ws.end(); ++it) {
-          mst.edges[*it].weight += 1.;
-        }
-      }
+      stochasticMSTWeights(mst, n_seeds, seed, i);
 
       for (typename std::vector<stochastic_edge<labelT, T>>::iterator it =
                mst.edges.begin();
            it != mst.edges.end(); ++it) {
-        it->weight /= n_seeds;
         if (it->weight < t0) {
           it->weight = 1.;
         } else {
@@ -1051,7 +1260,7 @@ namespace smil
   size_t stochasticFlatZones(const Image<labelT> &primary,
                              const Image<T> &gradient, Image<labelT> &out,
                              const size_t &n_seeds, const double &t0,
-                             const StrElt &se)
+                             const StrElt &se, const size_t &seed)
   {
     fill<labelT>(out, ImDtTypes<labelT>::max());
 
@@ -1068,12 +1277,13 @@ namespace smil
       it->weight = 0.;
     }
 
-    std::default_random_engine generator;
-    generator.seed(std::chrono::system_clock::now().time_since_epoch().count());
+    std::vector<double> cumulative =
+        cumulativeDistribution(uniformDistribution(graph));
+    std::vector<int> markers;
 
     for (uint32_t j = 0; j < n_seeds; ++j) {
-      std::vector<double> prob_dist = uniformDistribution(graph);
-      std::vector<int>    markers   = generateMarkers(prob_dist, generator);
+      stochastic_rng rng(seed, j);
+      generateMarkers(cumulative, rng, markers);
 
       std::vector<size_t> ws = watershedGraph(graph, markers);
 
@@ -1108,7 +1318,8 @@ namespace smil
   size_t overSegmentationCorrection(const Image<labelT> &primary,
                                     const Image<T>      &gradient,
                                     Image<labelT> &out, const size_t &n_seeds,
-                                    const double &r0, const StrElt &se)
+                                    const double &r0, const StrElt &se,
+                                    const size_t &seed)
   {
     fill<labelT>(out, labelT(0));
 
@@ -1125,10 +1336,7 @@ namespace smil
       it->weight = 0.;
     }
 
-    std::default_random_engine generator;
-    generator.seed(std::chrono::system_clock::now().time_since_epoch().count());
-
-    //        #pragma omp parallel for
+    // Realizations of each subgraph are run in parallel
     for (uint32_t i = 1; i < nbr_subgraphs + 1; ++i) {
       vector<labelT>              originals;
       stochastic_graph<labelT, T> sub =
@@ -1137,22 +1345,7 @@ namespace smil
       if (sub.edges.size() != 0) {
         stochastic_graph<labelT, T> mst = KruskalMST(sub);
 
-        for (uint32_t j = 0; j < n_seeds; ++j) {
-          std::vector<double> prob_dist = uniformDistribution(mst);
-          std::vector<int>    markers   = generateMarkers(prob_dist, generator);
-
-          std::vector<size_t> ws = watershedGraph(mst, markers);
-          for (typename std::vector<size_t>::iterator it = ws.begin();
-               it != ws.end(); ++it) {
-            mst.edges[*it].weight += 1.0;
-          }
-        }
-
-        for (typename std::vector<stochastic_edge<labelT, T>>::iterator it =
-                 mst.edges.begin();
-             it != mst.edges.end(); ++it) {
-          it->weight /= n_seeds;
-        }
+        stochasticMSTWeights(mst, n_seeds, seed, i);
 
         std::vector<hierarchy> d       = getHierarchy(mst);
         std::vector<double>    weights = weightHierarchy(d, mst);
@@ -19,6 +19,7 @@ SMIL_MODULE(smilStochasticWS)
 
 TEMPLATE_WRAP_FUNC_2T_CROSS(stochasticWatershed);
 TEMPLATE_WRAP_FUNC_2T_CROSS(stochasticWatershedParallel);
+TEMPLATE_WRAP_FUNC_2T_CROSS(exactStochasticWatershed);
 TEMPLATE_WRAP_FUNC_2T_CROSS(stochasticFlatZones);
 TEMPLATE_WRAP_FUNC_2T_CROSS(stochasticFlatZonesParallel);
 TEMPLATE_WRAP_FUNC_2T_CROSS(overSegmentationCorrection);
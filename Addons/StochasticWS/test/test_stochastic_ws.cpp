@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2011-2016, Matthieu FAESSEL and ARMINES
+ * Copyright (c) 2017-2024, Centre de Morphologie Mathematique
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of Matthieu FAESSEL, or ARMINES nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Core/include/DCore.h"
+#include "Addons/StochasticWS/include/DStochasticWS.h"
+
+using namespace smil;
+
+/*
+ * Mosaic of 20 rectangular tiles of various areas, split in two connected
+ * components by a column of zero pixels, and a random gradient
+ */
+static void stochasticTestImages(Image<UINT16> &imMosaic,
+                                 Image<UINT8>  &imGrad)
+{
+  const size_t xs[] = {0, 5, 17, 24, 25, 33, 48};
+  const size_t ys[] = {0, 9, 20, 36, 48};
+
+  imMosaic.setSize(48, 48);
+  imGrad.setSize(48, 48);
+
+  UINT16 lbl = 0;
+  for (size_t j = 0; j < 4; j++)
+    for (size_t i = 0; i < 6; i++) {
+      if (i == 3)
+        continue;
+      lbl++;
+      for (size_t y = ys[j]; y < ys[j + 1]; y++)
+        for (size_t x = xs[i]; x < xs[i + 1]; x++)
+          imMosaic.setPixel(x, y, lbl);
+    }
+  for (size_t y = 0; y < 48; y++)
+    imMosaic.setPixel(24, y, UINT16(0));
+
+  UINT8 *pixels = imGrad.getPixels();
+  srand(7);
+  for (size_t i = 0; i < imGrad.getPixelCount(); i++)
+    pixels[i] = UINT8(rand() % 200);
+}
+
+class TestStochasticWSDeterminism : public TestCase
+{
+  virtual void run()
+  {
+    Image<UINT16> imMosaic;
+    Image<UINT8>  imGrad;
+    stochasticTestImages(imMosaic, imGrad);
+
+    Image<UINT16> imOut1(imMosaic);
+    Image<UINT16> imOut2(imMosaic);
+    Core         *core     = Core::getInstance();
+    UINT          nthreads = core->getNumberOfThreads();
+
+    // Same seed, same result
+    stochasticWatershedParallel(imMosaic, imGrad, imOut1, 500, CrossSE(), 3);
+    stochasticWatershedParallel(imMosaic, imGrad, imOut2, 500, CrossSE(), 3);
+    TEST_ASSERT(imOut1 == imOut2);
+
+    // Whatever the number of threads
+    core->setNumberOfThreads(1);
+    stochasticWatershedParallel(imMosaic, imGrad, imOut1, 500, CrossSE(), 3);
+    core->setNumberOfThreads(core->getMaxNumberOfThreads());
+    stochasticWatershedParallel(imMosaic, imGrad, imOut2, 500, CrossSE(), 3);
+    TEST_ASSERT(imOut1 == imOut2);
+    core->setNumberOfThreads(nthreads);
+
+    // Another seed gives another realization
+    stochasticWatershedParallel(imMosaic, imGrad, imOut2, 500, CrossSE(), 4);
+    TEST_ASSERT(!(imOut1 == imOut2));
+  }
+};
+
+/*
+ * Exact edge probabilities against Monte Carlo estimates, on each connected
+ * component of the mosaic graph. With 20000 realizations, the standard
+ * deviation of an estimate is below 0.004.
+ */
+class TestExactStochasticWS : public TestCase
+{
+  virtual void run()
+  {
+    Image<UINT16> imMosaic;
+    Image<UINT8>  imGrad;
+    stochasticTestImages(imMosaic, imGrad);
+
+    typedef stochastic_graph<UINT16, UINT8> graphT;
+
+    graphT graph;
+    mosaicToStochasticGraph(imMosaic, imGrad, graph, CrossSE());
+    std::vector<UINT16> labels;
+    size_t nbr_subgraphs = CCLUnionFind_stochasticGraph(graph, labels);
+    TEST_ASSERT(nbr_subgraphs == 2);
+
+    const size_t n_seeds = 20000;
+    double       errUniform = 0., errArea = 0.;
+    for (size_t i = 1; i < nbr_subgraphs + 1; i++) {
+      std::vector<UINT16> originals;
+      graphT sub = getSubStochasticGraph(graph, i, labels, originals);
+      graphT mst = KruskalMST(sub);
+      graphT exact(mst);
+
+      // Uniform distribution of the markers
+      stochasticMSTWeights(mst, n_seeds, 1, i);
+      exactMSTWeights(exact, uniformDistribution(exact));
+      for (size_t k = 0; k < mst.edges.size(); k++)
+        errUniform = std::max(
+            errUniform, std::fabs(mst.edges[k].weight - exact.edges[k].weight));
+
+      // Markers proportional to the area of the regions
+      std::vector<double> cumulative =
+          cumulativeDistribution(areaDistribution(mst));
+      std::vector<size_t> counts(mst.edges.size(), 0);
+      std::vector<int>    markers;
+      std::vector<size_t> parent;
+      std::vector<char>   marked;
+      for (size_t j = 0; j < n_seeds; j++) {
+        stochastic_rng rng(2, j);
+        generateMarkers(cumulative, rng, markers);
+        watershedMST(mst, markers, parent, marked, counts);
+      }
+      exactMSTWeights(exact, areaDistribution(exact));
+      for (size_t k = 0; k < mst.edges.size(); k++)
+        errArea = std::max(errArea,
+                           std::fabs(double(counts[k]) / double(n_seeds) -
+                                     exact.edges[k].weight));
+    }
+    TEST_ASSERT(errUniform < 0.02);
+    TEST_ASSERT(errArea < 0.02);
+
+    // Same agreement on the output images
+    Image<UINT16> imExact(imMosaic);
+    Image<UINT16> imMC(imMosaic);
+    TEST_ASSERT(exactStochasticWatershed(imMosaic, imGrad, imExact,
+                                         CrossSE()) == RES_OK);
+    stochasticWatershedParallel(imMosaic, imGrad, imMC, n_seeds, CrossSE(),
+                                5);
+    UINT16 *pExact = imExact.getPixels(), *pMC = imMC.getPixels();
+    double  errImage = 0.;
+    for (size_t p = 0; p < imExact.getPixelCount(); p++)
+      errImage = std::max(errImage, std::fabs(double(pExact[p]) - pMC[p]));
+    TEST_ASSERT(errImage < 0.02 * ImDtTypes<UINT16>::max());
+
+    // The area distribution changes the boundary probabilities
+    Image<UINT16> imArea(imMosaic);
+    TEST_ASSERT(exactStochasticWatershed(imMosaic, imGrad, imArea, CrossSE(),
+                                         "area") == RES_OK);
+    TEST_ASSERT(!(imArea == imExact));
+
+    TEST_ASSERT(exactStochasticWatershed(imMosaic, imGrad, imArea, CrossSE(),
+                                         "volume") == RES_ERR);
+  }
+};
+
+int main(void)
+{
+  TestSuite ts;
+  ADD_TEST(ts, TestStochasticWSDeterminism);
+  ADD_TEST(ts, TestExactStochasticWS);
+
+  return ts.run();
+}
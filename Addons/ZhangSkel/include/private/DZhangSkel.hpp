@@ -319,207 +319,177 @@ namespace smil
   /** @endcond */
 #endif
 
-  /**
-   * zhangSkeleton() - Zhang @b 2D skeleton
+  /** @cond */
+  /*
+   * Zhang and Suen deletion test of a foreground pixel, for the first
+   * (phase 0) or the second (phase 1) sub-iteration.
    *
-   * Implementation corresponding to the algorithm described in
-   * @cite zhang_suen_1984, @cite Chen_Hsu_1988 and
-   * @cite khanyile_comparative_2011.
+   * 0  1  2 OUR DEF  ->  9  2  3 PAPER
+   * 7     3          ->  8  1  4
+   * 6  5  4          ->  7  6  5
    *
-   * @param[in] imIn : input image
-   * @param[out] imOut : output image
+   * PHASE 1
+   * 2  4  6 (zhang) -> 1 3 5 (our)
+   * 4  6  8 (zhang) -> 3 5 7 (our)
    *
-   * @note
-   * - @b 2D only
+   * PHASE 2
+   * 2  4  8 (zhang) -> 1 3 7 (our)
+   * 2  6  8 (zhang) -> 1 5 7 (our)
    */
   template <class T>
-  RES_T zhangSkeleton(const Image<T> &imIn, Image<T> &imOut)
+  inline bool zhangDeletable(const T *pix, const int ngbOffsets[8], int phase)
   {
-    size_t w = imIn.getWidth();
-    size_t h = imIn.getHeight();
-
-    // Create a copy image with a border to avoid border checks
-    size_t   width = w + 2, height = h + 2;
-    Image<T> tmpIm(width, height);
-    Image<T> modifiedIm(width, height);
-
-    fill(tmpIm, ImDtTypes<T>::min());
-    fill(modifiedIm, ImDtTypes<T>::min());
-
-    copy(imIn, tmpIm, 1, 1);
-    copy(imIn, modifiedIm, 1, 1);
-
-    typedef typename Image<T>::sliceType sliceType;
-    typedef typename Image<T>::lineType  lineType;
-
-    const sliceType lines         = tmpIm.getLines();
-    const sliceType modifiedLines = modifiedIm.getLines();
-    lineType        curLine, modifiedLine;
-    lineType        curPix, modifiedPix;
-
-    bool ptsDeleted1, ptsDeleted2;
-
-    UINT nbrTrans, nbrNonZero;
-    int  iteration;
-
-    int iWidth        = width;
-    int ngbOffsets[8] = {-iWidth - 1, -iWidth, -iWidth + 1, 1,
-                         iWidth + 1,  iWidth,  iWidth - 1,  -1};
-    T   ngbs[8];
-
-    // 0  1  2 OUR DEF  ->  9  2  3 PAPER
-    // 7     3          ->  8  1  4
-    // 6  5  4          ->  7  6  5
-
-    // PHASE 1
-    // 2  4  6 (zhang) -> 1 3 5 (our)
-    // 4  6  8 (zhang) -> 3 5 7 (our)
+    bool ngbs[8];
+    UINT nbrNonZero = 0;
+    for (int n = 0; n < 8; n++) {
+      ngbs[n] = pix[ngbOffsets[n]] != 0;
+      nbrNonZero += ngbs[n];
+    }
+    if (nbrNonZero < 2 || nbrNonZero > 6)
+      return false;
+
+    // Number of transitions in clockwise direction from point (-1,-1) back
+    // to itself
+    UINT nbrTrans = 0;
+    for (int n = 0; n < 8; n++)
+      if (!ngbs[n] && ngbs[(n + 1) % 8])
+        nbrTrans++;
+    if (nbrTrans != 1)
+      return false;
+
+    if (phase == 0)
+      return !(ngbs[1] && ngbs[3] && ngbs[5]) &&
+             !(ngbs[3] && ngbs[5] && ngbs[7]);
+    return !(ngbs[1] && ngbs[3] && ngbs[7]) && !(ngbs[1] && ngbs[5] && ngbs[7]);
+  }
 
-    // PHASE 2
-    // 2  4  8 (zhang) -> 1 3 7 (our) PHASE 2
-    // 2  6  8 (zhang) -> 1 5 7 (our)
+  /*
+   * Zhang and Suen thinning of a 2D buffer surrounded by a one pixel wide
+   * border of zeros.
+   *
+   * A pixel can only become deletable when one of its neighbors was
+   * deleted, so each sub-iteration only tests the pixels around the last
+   * deletions, starting from the contour of the input set. The tests only
+   * read the state left by the previous sub-iteration and are done in
+   * parallel, the deletions are done afterwards.
+   */
+  template <class T>
+  void zhangThinBuffer(T *buf, int width, int height)
+  {
+    int ngbOffsets[8] = {-width - 1, -width, -width + 1, 1,
+                         width + 1,  width,  width - 1,  -1};
+
+    // Candidates of each sub-iteration : the contour pixels at first
+    std::vector<size_t> candidates[2];
+    for (int y = 1; y < height - 1; y++) {
+      for (int x = 1; x < width - 1; x++) {
+        size_t o = size_t(y) * width + x;
+        if (buf[o] == 0)
+          continue;
+        for (int n = 0; n < 8; n++)
+          if (buf[o + ngbOffsets[n]] == 0) {
+            candidates[0].push_back(o);
+            break;
+          }
+      }
+    }
+    candidates[1] = candidates[0];
 
-    iteration = 0;
+    std::vector<UINT32> stamp(size_t(width) * height, 0);
+    std::vector<UINT8>  toDelete;
+    std::vector<size_t> active;
+    UINT32              tag = 0;
 
-    int n;
+    size_t nbrDeleted;
     do {
-      iteration += 1;
-      ptsDeleted1 = false;
-      ptsDeleted2 = false;
-
-      // PHASE 1 south-east boundary and  north-west corner
-      for (size_t y = 1; y < height - 1; y++) {
-        curLine      = lines[y];
-        curPix       = curLine + 1;
-        modifiedLine = modifiedLines[y];
-        modifiedPix  = modifiedLine + 1;
-
-        for (size_t x = 1; x < width; x++, curPix++, modifiedPix++) {
-          if (*curPix == 0)
-            continue;
-
-          for (n = 0; n < 8; n++) {
-            ngbs[n] = curPix[ngbOffsets[n]];
+      nbrDeleted = 0;
+      for (int phase = 0; phase < 2; phase++) {
+        tag++;
+        active.clear();
+        for (size_t i = 0; i < candidates[phase].size(); i++) {
+          size_t o = candidates[phase][i];
+          if (stamp[o] != tag && buf[o] != 0) {
+            stamp[o] = tag;
+            active.push_back(o);
           }
+        }
+        candidates[phase].clear();
 
-          // ----------------------------------------
-          // Calculate the number of non-zero neighbors
-          // ----------------------------------------
-          nbrNonZero = 0;
-          for (n = 0; n < 8; n++) {
-            if (ngbs[n] != 0) {
-              nbrNonZero++;
-            }
-          }
-          if (nbrNonZero < 2 || nbrNonZero > 6)
-            continue;
-
-          // --------------------------------------------------
-          // Calculate the number of transitions in clockwise
-          // direction from point (-1,-1) back to itself
-          // --------------------------------------------------
-          nbrTrans = 0;
-          for (n = 0; n < 7; n++)
-            if (ngbs[n] == 0 && ngbs[n + 1] != 0)
-              nbrTrans++;
-          if (ngbs[7] == 0 && ngbs[0] != 0)
-            nbrTrans++;
-
-          if (nbrTrans != 1)
-            continue;
+        int nActive = active.size();
+        toDelete.assign(nActive, 0);
 
-          // --------------------------------------------------
-          // P 1, 3, 5
-          // --------------------------------------------------
-          if (ngbs[1] * ngbs[3] * ngbs[5] != 0) // phase 1
-            continue;
+#ifdef USE_OPEN_MP
+        int nthreads = Core::getInstance()->getNumberOfThreads();
+#pragma omp parallel for num_threads(nthreads)
+#endif // USE_OPEN_MP
+        for (int i = 0; i < nActive; i++)
+          toDelete[i] = zhangDeletable(buf + active[i], ngbOffsets, phase);
 
-          // --------------------------------------------------
-          // P 3, 5, 7
-          // --------------------------------------------------
-          if (ngbs[3] * ngbs[5] * ngbs[7] != 0) // phase 1
+        // Delete, and schedule the neighbors for both sub-iterations
+        for (int i = 0; i < nActive; i++) {
+          if (!toDelete[i])
             continue;
-
-          // --------------------------------------------------
-          // All conditions verified, remove the point
-          // --------------------------------------------------
-          *modifiedPix = 0;
-          ptsDeleted1  = true;
-
-        } // for x
-      } // for y
-
-      // Delete pixels satisfying all previous conditions (phase 1)
-      if (ptsDeleted1) {
-        copy(modifiedIm, tmpIm);
+          size_t o = active[i];
+          buf[o]   = 0;
+          nbrDeleted++;
+          for (int n = 0; n < 8; n++) {
+            candidates[0].push_back(o + ngbOffsets[n]);
+            candidates[1].push_back(o + ngbOffsets[n]);
+          }
+        }
       }
+    } while (nbrDeleted > 0);
+  }
+  /** @endcond */
 
-      // PHASE 2 north-west boundary  south-east corner
-      for (size_t y = 1; y < height - 1; y++) {
-        curLine      = lines[y];
-        curPix       = curLine + 1;
-        modifiedLine = modifiedLines[y];
-        modifiedPix  = modifiedLine + 1;
-
-        for (size_t x = 1; x < width; x++, curPix++, modifiedPix++) {
-          if (*curPix == 0)
-            continue;
-
-          for (n = 0; n < 8; n++) {
-            ngbs[n] = curPix[ngbOffsets[n]];
-          }
+  /**
+   * zhangSkeleton() - Zhang @b 2D skeleton
+   *
+   * Implementation corresponding to the algorithm described in
+   * @cite zhang_suen_1984, @cite Chen_Hsu_1988 and
+   * @cite khanyile_comparative_2011.
+   *
+   * Each sub-iteration only visits the pixels next to the ones deleted by the
+   * previous one, so the cost follows the number of deleted pixels.
+   *
+   * @param[in] imIn : input image
+   * @param[out] imOut : output image
+   *
+   * @note
+   * - @b 3D images are thinned slice by slice
+   */
+  template <class T>
+  RES_T zhangSkeleton(const Image<T> &imIn, Image<T> &imOut)
+  {
+    ASSERT_ALLOCATED(&imIn, &imOut);
+    ASSERT_SAME_SIZE(&imIn, &imOut);
 
-          // --------------------------------------------------
-          // Calculate the number of non-zero neighbors
-          // --------------------------------------------------
-          nbrNonZero = 0;
-          for (n = 0; n < 8; n++) {
-            if (ngbs[n] != 0)
-              nbrNonZero++;
-          }
-          if (nbrNonZero < 2 || nbrNonZero > 6)
-            continue;
+    ImageFreezer freezer(imOut);
 
-          // --------------------------------------------------
-          // Calculate the number of transitions in clockwise
-          // direction from point (-1,-1) back to itself
-          // --------------------------------------------------
-          nbrTrans = 0;
-          for (n = 0; n < 7; n++)
-            if (ngbs[n] == 0 && ngbs[n + 1] != 0)
-              nbrTrans++;
-          if (ngbs[7] == 0 && ngbs[0] != 0)
-            nbrTrans++;
-          if (nbrTrans != 1)
-            continue;
+    size_t w = imIn.getWidth();
+    size_t h = imIn.getHeight();
+    size_t d = imIn.getDepth();
 
-          // --------------------------------------------------
-          // P 1, 3, 7
-          // --------------------------------------------------
-          if (ngbs[1] * ngbs[3] * ngbs[7] != 0) // phase 2
-            continue;
+    // Copy each slice with a border to avoid border checks
+    size_t         width = w + 2, height = h + 2;
+    std::vector<T> buf(width * height);
 
-          // --------------------------------------------------
-          // P 1, 5, 7
-          // --------------------------------------------------
-          if (ngbs[1] * ngbs[5] * ngbs[7] != 0) // phase 2
-            continue;
+    typename ImDtTypes<T>::lineType pixIn  = imIn.getPixels();
+    typename ImDtTypes<T>::lineType pixOut = imOut.getPixels();
 
-          // --------------------------------------------------
-          // All conditions verified, remove the point
-          // --------------------------------------------------
-          *modifiedPix = 0;
-          ptsDeleted2  = true;
-        } // for x
-      } // for y
+    for (size_t z = 0; z < d; z++) {
+      std::fill(buf.begin(), buf.end(), T(0));
+      for (size_t y = 0; y < h; y++)
+        std::copy(pixIn + (z * h + y) * w, pixIn + (z * h + y + 1) * w,
+                  buf.begin() + (y + 1) * width + 1);
 
-      // Delete pixels satisfying all previous conditions (phase 2)
-      if (ptsDeleted2) {
-        copy(modifiedIm, tmpIm);
-      }
-    } while (ptsDeleted1 || ptsDeleted2); // do
+      zhangThinBuffer(&buf[0], width, height);
 
-    copy(tmpIm, 1, 1, imOut);
+      for (size_t y = 0; y < h; y++)
+        std::copy(buf.begin() + (y + 1) * width + 1,
+                  buf.begin() + (y + 1) * width + 1 + w,
+                  pixOut + (z * h + y) * w);
+    }
 
     return RES_OK;
   }
@@ -535,7 +505,7 @@ namespace smil
    * @param[out] imOut : output image
    *
    * @note
-   * - @b 2D only
+   * - @b 3D images are thinned slice by slice
    * @see zhangSkeleton()
    * @overload
    */
@@ -797,8 +767,9 @@ namespace smil
    * @param[in] imIn : binary input image
    * @param[out] imOut : output image
    * @param[in] method : algorithm to use.
-   * - Zhang (default) - @cite zhang_suen_1984
-   * - DongLinHuang - @cite dong_lin_huang_2016
+   * - Zhang (default) - @cite zhang_suen_1984. @b 3D images are thinned slice
+   * by slice.
+   * - DongLinHuang - @cite dong_lin_huang_2016 (@b 2D only)
    */
   template <typename T>
   RES_T imageThinning(const Image<T> &imIn, Image<T> &imOut,
@@ -0,0 +1,118 @@
+/*
+ * Smil
+ * Copyright (c) 2011-2015 Matthieu Faessel
+ *
+ * This file is part of Smil.
+ *
+ * Smil is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Smil is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Smil.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/include/DCore.h"
+#include "Base/include/DBase.h"
+#include "DZhangSkel.hpp"
+
+using namespace smil;
+
+static UINT8 vecShape[] = {
+  0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+  0, 255, 255, 255, 255, 255, 255, 255, 255, 255,   0,   0,
+  0, 255, 255, 255, 255, 255, 255, 255, 255, 255,   0,   0,
+  0, 255, 255, 255, 255, 255, 255, 255, 255, 255,   0,   0,
+  0, 255, 255, 255, 255, 255, 255, 255, 255, 255,   0,   0,
+  0, 255, 255, 255, 255, 255, 255, 255, 255, 255,   0,   0,
+  0,   0,   0,   0, 255, 255, 255,   0,   0,   0,   0,   0,
+  0,   0,   0,   0, 255, 255, 255,   0,   0,   0,   0,   0,
+  0,   0,   0,   0, 255, 255, 255,   0,   0,   0,   0,   0,
+  0,   0,   0,   0, 255, 255, 255,   0,   0,   0,   0,   0,
+};
+
+static UINT8 vecSkeleton[] = {
+  0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+  0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+  0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+  0,   0,   0, 255, 255, 255,   0,   0,   0,   0,   0,   0,
+  0,   0,   0,   0,   0, 255,   0,   0,   0,   0,   0,   0,
+  0,   0,   0,   0,   0, 255,   0,   0,   0,   0,   0,   0,
+  0,   0,   0,   0,   0, 255,   0,   0,   0,   0,   0,   0,
+  0,   0,   0,   0,   0, 255,   0,   0,   0,   0,   0,   0,
+  0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+  0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+};
+
+class TestZhangSkeleton : public TestCase
+{
+  virtual void run()
+  {
+    Image<UINT8> imIn(12, 10);
+    Image<UINT8> imOut(imIn);
+    Image<UINT8> imTruth(imIn);
+
+    imIn << vecShape;
+    imTruth << vecSkeleton;
+
+    zhangSkeleton(imIn, imOut);
+    TEST_ASSERT(imOut == imTruth);
+    if (retVal != RES_OK)
+      imOut.printSelf(1);
+
+    zhangThinning(imIn, imOut);
+    TEST_ASSERT(imOut == imTruth);
+  }
+};
+
+/*
+ * Each slice of a 3D image is thinned as a 2D image
+ */
+class TestZhangSkeleton3D : public TestCase
+{
+  virtual void run()
+  {
+    Image<UINT8> imSlice(12, 10);
+    Image<UINT8> imTruth(imSlice);
+    Image<UINT8> imIn(12, 10, 3);
+    Image<UINT8> imOut(imIn);
+
+    // Slice 0 : the 2D shape, slice 1 : random blobs, slice 2 : empty
+    imSlice << vecShape;
+    copy(imSlice, imIn, 0, 0, 0);
+    srand(3);
+    for (size_t y = 0; y < 10; y++)
+      for (size_t x = 0; x < 12; x++)
+        imIn.setPixel(x, y, 1, (rand() % 4) == 0 ? 0 : 255);
+
+    zhangSkeleton(imIn, imOut);
+
+    imTruth << vecSkeleton;
+    copy(imOut, 0, 0, 0, 12, 10, 1, imSlice);
+    TEST_ASSERT(imSlice == imTruth);
+
+    for (size_t z = 1; z < 3; z++) {
+      copy(imIn, 0, 0, z, 12, 10, 1, imSlice);
+      zhangSkeleton(imSlice, imTruth);
+      copy(imOut, 0, 0, z, 12, 10, 1, imSlice);
+      TEST_ASSERT(imSlice == imTruth);
+    }
+  }
+};
+
+int main(void)
+{
+  TestSuite ts;
+  ADD_TEST(ts, TestZhangSkeleton);
+  ADD_TEST(ts, TestZhangSkeleton3D);
+
+  return ts.run();
+}
@@ -34,6 +34,7 @@
  * History :
  *   - 15/10/2020 - by Jose-Marcio Martins da Cruz
  *     Porting from xxx
+ *   - 19/10/2026 - areaClosing() without image inversion
  *
  * __HEAD__ - Stop here !
  */
@@ -101,15 +102,8 @@ namespace smil
     ASSERT_SAME_SIZE(&imIn, &imOut);
 
     if (method == "unionfind") {
-      Image<T> imTmp(imIn);
-      RES_T    res = inv(imIn, imTmp);
-      if (res == RES_OK) {
-        UnionFindFunctions<T> uff;
-        res = uff.areaOpen(imTmp, size, imOut, se);
-      }
-      if (res == RES_OK)
-        res = inv(imOut, imOut);
-      return res;
+      UnionFindFunctions<T> uff;
+      return uff.areaOpen(imIn, size, imOut, se, true);
     }
 
     std::cout << "This method isn't implemented : " << method << std::endl;
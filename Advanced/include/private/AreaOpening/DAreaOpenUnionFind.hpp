@@ -34,17 +34,22 @@
  * History :
  *   - 15/10/2020 - by Jose-Marcio Martins da Cruz
  *     Porting from xxx
+ *   - 19/10/2026 - pixels sorted by value instead of a std::map histogram,
+ *     so that 32 bits and floating point images can be handled. Closing
+ *     without image inversion.
+ *   - 19/10/2026 - union-find by slabs in parallel (MaxTreeUnionFind), areas
+ *     accumulated on the parent array of canonical pixels
  *
  * __HEAD__ - Stop here !
  */
 
+
 #ifndef _D_AREA_OPEN_UNION_FIND_HPP
 #define _D_AREA_OPEN_UNION_FIND_HPP
 
-#include <cmath>
-#include <cstring>
-#include <iomanip>
-#include <mutex>
+#include <algorithm>
+#include <limits>
+#include <vector>
 
 #include "Core/include/DCore.h"
 #include "Morpho/include/DMorpho.h"
@@ -66,21 +71,26 @@ namespace smil
   public:
     UnionFindFunctions()
     {
-      se = DEFAULT_SE;
-      // se = CrossSE();
+      se   = DEFAULT_SE;
+      dual = false;
     }
 
+    /*
+     * Area opening, or area closing with dual set. Both use the same order
+     * of pixels, from the top for the opening and from the bottom for the
+     * closing, so that no image inversion is needed.
+     */
     RES_T areaOpen(const Image<T> &imIn, size_t size, Image<T> &imOut,
-                   StrElt &se)
+                   StrElt &se, bool dual = false)
     {
-      _init(imIn);
-
-      this->se = se;
+      this->se   = se;
+      this->dual = dual;
 
-      fill(imOut, T(0));
       ImageFreezer freeze(imOut);
 
-      return _areaOpen(imIn, size, imOut);
+      if (imIn.getPixelCount() < size_t(std::numeric_limits<UINT32>::max()))
+        return _areaOpen<UINT32>(imIn, size, imOut);
+      return _areaOpen<size_t>(imIn, size, imOut);
     }
 
     //
@@ -90,251 +100,72 @@ namespace smil
     //
     // F I E L D S
     //
-    off_t width;
-    off_t height;
-    off_t depth;
-    off_t slice;
-
-    off_t lambda;
-
-    Image<T>                    imIn;
-    typename Image<T>::lineType bufIn;
-    typename Image<T>::lineType bufOut;
-
     StrElt se;
-
-    std::map<T, std::vector<off_t>> histoMap;
-    std::vector<off_t>              parent;
-
-    bool debug;
-
-    //
-    // M E T H O D S
-    //
-    void _init(const Image<T> &im)
-    {
-      imIn = im;
-
-      width  = imIn.getWidth();
-      height = imIn.getHeight();
-      depth  = imIn.getDepth();
-      slice  = height * width;
-
-      parent.resize(imIn.getPixelCount(), 0);
-
-      bufIn = (T *) imIn.getPixels();
-
-      debug = false;
-    }
-
-    //
-    // H I S T O G R A M    M A P
-    //
-    void mkHistogram(const Image<T> &im)
-    {
-      typename Image<T>::lineType pixels = im.getPixels();
-      std::mutex                  mtx;
-
-#ifdef USE_OPEN_MP
-#pragma omp for
-#endif
-      for (size_t i = 0; i < im.getPixelCount(); i++) {
-        T val = pixels[i];
-
-        mtx.lock();
-        size_t capacity = histoMap[val].capacity();
-        if ((capacity - histoMap[val].size()) < 512)
-          histoMap[val].reserve(capacity + 8192);
-
-        histoMap[val].push_back(i);
-        mtx.unlock();
-      }
-
-      if (debug)
-        dumpHistogram();
-    }
-
-    //
-    // U N I O N   F I N D
-    //
-    void MakeSet(off_t x)
-    {
-      parent[x] = -1;
-    }
-
-    off_t FindRoot(off_t x)
-    {
-      if (parent[x] >= 0 && parent[x] != x) {
-        parent[x] = FindRoot(parent[x]);
-        return parent[x];
-      } else
-        return x;
-    }
-
-    bool Criterion(off_t x, off_t y)
-    {
-      return (bufIn[x] == bufIn[y] || -parent[x] < lambda);
-    }
-
-    void Union(off_t n, off_t p)
-    {
-      off_t r = FindRoot(n);
-
-      if (r != p) {
-        if (Criterion(r, p)) {
-          parent[p] += parent[r];
-          parent[r] = p;
-        } else {
-          parent[p] = -lambda;
-        }
-      }
-    }
+    bool   dual;
 
     //
-    // D E B U G  : D U M P   D A T A
+    // A R E A   O P E N
     //
-
-    // vector
-    template <typename TD>
-    void dumpVector(std::vector<TD> &b, std::string head = "")
-    {
-      std::cout << std::endl;
-      std::cout << "=========================== " << head << std::endl;
-      for (auto i = 0; i < height; i++) {
-        std::cout << "Line " << std::setw(4) << i << " - ";
-        for (auto j = 0; j < width; j++) {
-          std::cout << " " << std::setw(4) << int(b[i * width + j]);
-        }
-        std::cout << std::endl;
-      }
-    }
-
-    // image
-    template <typename TI>
-    void dumpImage(TI *b, std::string head = "")
+    template <typename IndexT>
+    RES_T _areaOpen(const Image<T> &imIn, size_t size, Image<T> &imOut)
     {
-      std::cout << std::endl;
-      std::cout << "=========================== " << head << std::endl;
-      for (auto i = 0; i < height; i++) {
-        std::cout << "Line " << std::setw(4) << i << " - ";
-        for (auto j = 0; j < width; j++) {
-          std::cout << " " << std::setw(4) << int(b[i * width + j]);
-        }
-        std::cout << std::endl;
+      typename Image<T>::lineType bufIn  = imIn.getPixels();
+      typename Image<T>::lineType bufOut = imOut.getPixels();
+      size_t                      nPix   = imIn.getPixelCount();
+
+      // Union-find : each pixel points to the canonical pixel of its
+      // component, canonical pixels to the one of the enclosing component.
+      // Slabs of the image are processed in parallel, then merged along
+      // their boundaries.
+      std::vector<IndexT> parent;
+      {
+        MaxTreeUnionFind<T, IndexT> uf(imIn, se, dual);
+        uf.build(parent);
       }
-    }
 
-    // histogram
-    void dumpHistogram()
-    {
-      for (auto itk = histoMap.rbegin(); itk != histoMap.rend(); itk++) {
-        std::cout << "Level \t" << int(itk->first) << "\t" << itk->second.size()
-                  << std::endl;
+      // Canonical pixels, enclosing components first (counting sort for 8
+      // and 16 bits types)
+      std::vector<IndexT> nodes;
+      std::vector<IndexT> area(nPix, 0);
+      for (size_t p = 0; p < nPix; p++) {
+        if (parent[p] == p || bufIn[parent[p]] != bufIn[p]) {
+          nodes.push_back(p);
+          area[p]++;
+        } else
+          area[parent[p]]++;
       }
-      std::cout << std::endl;
-
-      for (auto itk = histoMap.begin(); itk != histoMap.end(); itk++) {
-        auto i = 0;
-        std::cout << std::endl;
-        std::cout << "* Histogram Level " << std::setw(4) << int(itk->first)
-                  << "\t" << itk->second.size() << std::endl;
-        for (auto itv = itk->second.begin(); itv != itk->second.end();
-             itv++, i++) {
-          if (i % 16 == 0)
-            std::cout << std::endl;
-          std::cout << " " << std::setw(4) << *itv;
-        }
-        std::cout << std::endl;
+      {
+        std::vector<IndexT> tmp(nodes.size());
+        sortOffsetsByValue(bufIn, nodes.data(), nodes.size(), tmp.data());
       }
-    }
-
-    //
-    // L I T T L E   T O O L S
-    //
-    void _pixel2coords(off_t pixel, off_t &x, off_t &y, off_t &z)
-    {
-      x = pixel % width;
-      if (depth > 1) {
-        y = (pixel % slice) / width;
-        z = pixel / slice;
-      } else {
-        y = pixel / width;
-        z = 0;
+      if (dual)
+        std::reverse(nodes.begin(), nodes.end());
+
+      // Areas, bottom-up
+      for (size_t i = nodes.size(); i-- > 0;) {
+        IndexT c = nodes[i];
+        if (parent[c] != c)
+          area[parent[c]] += area[c];
       }
-    }
-
-    off_t _coords2pixel(off_t &x, off_t &y, off_t &z)
-    {
-      if (depth > 1)
-        return x + y * width + z * slice;
-      else
-        return x + y * width;
-    }
-
-    bool _pixelInWindow(off_t x, off_t y, off_t z)
-    {
-      if (x < 0 || x >= width)
-        return false;
-      if (y < 0 || y >= height)
-        return false;
-      if (z < 0 || z >= depth)
-        return false;
-      return true;
-    }
-
-    //
-    // A R E A   O P E N
-    //
-    RES_T _areaOpen(const Image<T> &imIn, size_t size, Image<T> &imOut)
-    {
-      bufOut = (T *) imOut.getPixels();
-      lambda = size;
-
-      // build histogram as a map
-      mkHistogram(imIn);
-
-      // remove central pixel on the structuring element
-      se = se.noCenter();
-
-      // Tarjan algorithm
-      for (auto itk = histoMap.rbegin(); itk != histoMap.rend(); itk++) {
-        for (auto itv = itk->second.begin(); itv != itk->second.end(); itv++) {
-          off_t pix = *itv;
-          off_t nbg;
-
-          off_t x, y, z;
-          _pixel2coords(pix, x, y, z);
 
-          MakeSet(pix);
-
-          for (auto its = se.points.begin(); its != se.points.end(); its++) {
-            off_t dx = its->x;
-            off_t dy = its->y;
-            off_t dz = its->z;
-
-            if (!_pixelInWindow(x + dx, y + dy, z + dz))
-              continue;
-            nbg = pix + _coords2pixel(dx, dy, dz);
-
-            if ((bufIn[pix] < bufIn[nbg]) ||
-                ((bufIn[pix] == bufIn[nbg]) && (nbg < pix)))
-              Union(nbg, pix);
-          }
-        }
+      // Components smaller than size take the value of the enclosing one
+      for (size_t i = 0; i < nodes.size(); i++) {
+        IndexT c = nodes[i];
+        if (parent[c] == c || area[c] >= size)
+          bufOut[c] = bufIn[c];
+        else
+          bufOut[c] = bufOut[parent[c]];
       }
 
-      // Making output image
-      for (auto itk = histoMap.begin(); itk != histoMap.end(); itk++) {
-        for (auto itv = itk->second.rbegin(); itv != itk->second.rend();
-             itv++) {
-          off_t pix = *itv;
-
-          if (parent[pix] >= 0)
-            parent[pix] = parent[parent[pix]];
-          else
-            parent[pix] = bufIn[pix];
-          bufOut[pix] = T(parent[pix]);
-        }
+      size_t p;
+#ifdef USE_OPEN_MP
+      int nthreads = Core::getInstance()->getNumberOfThreads();
+#pragma omp parallel for num_threads(nthreads)
+#endif // USE_OPEN_MP
+      for (p = 0; p < nPix; p++) {
+        // Not canonical : bufIn may have been overwritten if imIn is imOut
+        if (area[p] == 0)
+          bufOut[p] = bufOut[parent[p]];
       }
 
       return RES_OK;
@@ -131,6 +131,168 @@ class TestAreaOpening30 : public TestCase
   }
 };
 
+class TestAreaOpeningFloat : public TestCase
+{
+  virtual void run()
+  {
+    // Same results on UINT8 and float images with the same order
+    Image<UINT8> im8(32, 24), out8(im8);
+    Image<float> imF(im8), outF(im8);
+
+    UINT32 seed = 12345;
+    for (size_t i = 0; i < im8.getPixelCount(); i++) {
+      seed               = seed * 1103515245 + 12345;
+      UINT8 v            = (seed >> 16) % 8 * 32;
+      im8.getPixels()[i] = v;
+      imF.getPixels()[i] = v * 0.25f - 20.f;
+    }
+
+    bool ok = true;
+    areaOpening(im8, 7, out8);
+    areaOpening(imF, 7, outF);
+    for (size_t i = 0; i < im8.getPixelCount(); i++)
+      ok = ok && outF.getPixels()[i] == out8.getPixels()[i] * 0.25f - 20.f;
+    areaClosing(im8, 7, out8);
+    areaClosing(imF, 7, outF);
+    for (size_t i = 0; i < im8.getPixelCount(); i++)
+      ok = ok && outF.getPixels()[i] == out8.getPixels()[i] * 0.25f - 20.f;
+    TEST_ASSERT(ok);
+
+    // Closing without image inversion
+    Image<UINT8> imInv(im8), out2(im8);
+    inv(im8, imInv);
+    areaOpening(imInv, 7, out2);
+    inv(out2, out2);
+    TEST_ASSERT(out2 == out8);
+  }
+};
+
+/*
+ * Plateaus and peaks spanning the boundaries of the slabs processed by each
+ * thread, at one thread and at the maximum number of threads, in place or
+ * not.
+ */
+class TestAreaOpeningSlabs : public TestCase
+{
+  virtual void run()
+  {
+    UINT8 vecIn[] = {
+      10, 50, 10, 10, 10, 10, 10, 10, 10, 10, 10,  10,
+      10, 50, 10, 10, 10, 10, 10, 10, 30, 30, 30,  10,
+      10, 50, 10, 10, 80, 80, 10, 10, 30, 30, 30,  10,
+       5, 50, 10, 10, 90, 80, 10, 10, 30,  0, 30,  10,
+       5, 50, 10, 10, 90, 80, 10, 10, 30, 30, 30,  10,
+      10, 50, 10, 10, 80, 80, 10, 10, 30, 30, 30,  10,
+      10, 50, 10, 10, 10, 10, 10, 10, 30, 30, 30,  10,
+      10, 50, 10, 10, 10, 10, 10, 10, 10, 10, 200, 10,
+    };
+    UINT8 vecOpen4[] = {
+      10, 50, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+      10, 50, 10, 10, 10, 10, 10, 10, 30, 30, 30, 10,
+      10, 50, 10, 10, 80, 80, 10, 10, 30, 30, 30, 10,
+       5, 50, 10, 10, 80, 80, 10, 10, 30,  0, 30, 10,
+       5, 50, 10, 10, 80, 80, 10, 10, 30, 30, 30, 10,
+      10, 50, 10, 10, 80, 80, 10, 10, 30, 30, 30, 10,
+      10, 50, 10, 10, 10, 10, 10, 10, 30, 30, 30, 10,
+      10, 50, 10, 10, 10, 10, 10, 10, 10, 10, 30, 10,
+    };
+    UINT8 vecOpen10[] = {
+      10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+      10, 10, 10, 10, 10, 10, 10, 10, 30, 30, 30, 10,
+      10, 10, 10, 10, 10, 10, 10, 10, 30, 30, 30, 10,
+       5, 10, 10, 10, 10, 10, 10, 10, 30,  0, 30, 10,
+       5, 10, 10, 10, 10, 10, 10, 10, 30, 30, 30, 10,
+      10, 10, 10, 10, 10, 10, 10, 10, 30, 30, 30, 10,
+      10, 10, 10, 10, 10, 10, 10, 10, 30, 30, 30, 10,
+      10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 30, 10,
+    };
+    UINT8 vecClose4[] = {
+      10, 50, 10, 10, 10, 10, 10, 10, 10, 10, 10,  10,
+      10, 50, 10, 10, 10, 10, 10, 10, 30, 30, 30,  10,
+      10, 50, 10, 10, 80, 80, 10, 10, 30, 30, 30,  10,
+      10, 50, 10, 10, 90, 80, 10, 10, 30, 30, 30,  10,
+      10, 50, 10, 10, 90, 80, 10, 10, 30, 30, 30,  10,
+      10, 50, 10, 10, 80, 80, 10, 10, 30, 30, 30,  10,
+      10, 50, 10, 10, 10, 10, 10, 10, 30, 30, 30,  10,
+      10, 50, 10, 10, 10, 10, 10, 10, 10, 10, 200, 10,
+    };
+
+    Image<UINT8> imIn(12, 8), imOut(imIn), imInPlace(imIn);
+    Image<UINT8> imOpen4(imIn), imOpen10(imIn), imClose4(imIn);
+    imIn << vecIn;
+    imOpen4 << vecOpen4;
+    imOpen10 << vecOpen10;
+    imClose4 << vecClose4;
+
+    StrElt se         = CrossSE();
+    Core  *core       = Core::getInstance();
+    UINT   nthreads   = core->getNumberOfThreads();
+    UINT   threads[2] = {1, core->getMaxNumberOfThreads()};
+    bool   ok         = true;
+    for (int t = 0; t < 2; t++) {
+      core->setNumberOfThreads(threads[t]);
+
+      areaOpening(imIn, 4, imOut, se);
+      ok = ok && imOut == imOpen4;
+      areaOpening(imIn, 10, imOut, se);
+      ok = ok && imOut == imOpen10;
+      areaClosing(imIn, 4, imOut, se);
+      ok = ok && imOut == imClose4;
+
+      copy(imIn, imInPlace);
+      areaOpening(imInPlace, 4, imInPlace, se);
+      ok = ok && imInPlace == imOpen4;
+      copy(imIn, imInPlace);
+      areaClosing(imInPlace, 4, imInPlace, se);
+      ok = ok && imInPlace == imClose4;
+    }
+    core->setNumberOfThreads(nthreads);
+    TEST_ASSERT(ok);
+  }
+};
+
+/*
+ * Random images with many plateaus, 2D and 3D : same results as the max-tree
+ * based attribute filters, whatever the number of threads
+ */
+class TestAreaOpeningRandom : public TestCase
+{
+  virtual void run()
+  {
+    Image<UINT8> im2D(41, 33), im3D(17, 13, 11);
+    Image<UINT8> *ims[2] = {&im2D, &im3D};
+    StrElt        ses[2] = {SquSE(), Cross3DSE()};
+
+    UINT32 seed = 321;
+    for (int k = 0; k < 2; k++)
+      for (size_t i = 0; i < ims[k]->getPixelCount(); i++) {
+        seed                   = seed * 1103515245 + 12345;
+        ims[k]->getPixels()[i] = (seed >> 16) % 5 * 60;
+      }
+
+    Core *core       = Core::getInstance();
+    UINT  nthreads   = core->getNumberOfThreads();
+    UINT  threads[2] = {1, core->getMaxNumberOfThreads()};
+    bool  ok         = true;
+    for (int t = 0; t < 2; t++) {
+      core->setNumberOfThreads(threads[t]);
+      for (int k = 0; k < 2; k++) {
+        Image<UINT8> imOut(*ims[k]), imTruth(*ims[k]);
+        for (size_t size = 2; size < 60; size *= 3) {
+          areaOpening(*ims[k], size, imOut, ses[k]);
+          areaOpen(*ims[k], size, imTruth, ses[k]);
+          ok = ok && imOut == imTruth;
+          areaClosing(*ims[k], size, imOut, ses[k]);
+          areaClose(*ims[k], size, imTruth, ses[k]);
+          ok = ok && imOut == imTruth;
+        }
+      }
+    }
+    core->setNumberOfThreads(nthreads);
+    TEST_ASSERT(ok);
+  }
+};
+
 int main()
 {
   TestSuite ts;
@@ -139,5 +301,8 @@ int main()
   ADD_TEST(ts, TestAreaOpening12);
   ADD_TEST(ts, TestAreaOpening20);
   ADD_TEST(ts, TestAreaOpening30);
+  ADD_TEST(ts, TestAreaOpeningFloat);
+  ADD_TEST(ts, TestAreaOpeningSlabs);
+  ADD_TEST(ts, TestAreaOpeningRandom);
   return ts.run();
 }
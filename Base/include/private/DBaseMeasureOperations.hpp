@@ -130,27 +130,39 @@ namespace smil
       return retVal;
     }
 
-    virtual retType processImage(const Image<T> &imIn, const Blob &blob)
+    virtual retType processSequences(const Image<T>      &imIn,
+                                     const PixelSequence *seqs, size_t seqNbr)
     {
       initialize(imIn);
 
       ASSERT(CHECK_ALLOCATED(&imIn), RES_ERR_BAD_ALLOCATION, retVal);
 
-      lineType                       pixels = imIn.getPixels();
-      Blob::sequences_const_iterator it     = blob.sequences.begin();
-      Blob::sequences_const_iterator it_end = blob.sequences.end();
-      for (; it != it_end; it++)
-        processSequence(pixels + (*it).offset, (*it).size);
+      lineType pixels = imIn.getPixels();
+      for (size_t i = 0; i < seqNbr; i++)
+        processSequence(pixels + seqs[i].offset, seqs[i].size);
       finalize(imIn);
       return retVal;
     }
 
+    virtual retType processImage(const Image<T> &imIn, const Blob &blob)
+    {
+      return processSequences(imIn, blob.sequences.data(),
+                              blob.sequences.size());
+    }
+
     virtual retType operator()(const Image<T> &imIn, const Blob &blob)
     {
       processImage(imIn, blob);
       return retVal;
     }
 
+    virtual retType operator()(const Image<T>      &imIn,
+                               const PixelSequence *seqs, size_t seqNbr)
+    {
+      processSequences(imIn, seqs, seqNbr);
+      return retVal;
+    }
+
     /*
      * To be tested - added by Joe in Aug 25, 2020
      */
@@ -223,19 +235,18 @@ namespace smil
       this->finalize(imIn);
       return RES_OK;
     }
-    virtual retType processImage(const Image<T> &imIn, const Blob &blob)
+    virtual retType processSequences(const Image<T>      &imIn,
+                                     const PixelSequence *seqs, size_t seqNbr)
     {
       this->initialize(imIn);
 
       ASSERT(CHECK_ALLOCATED(&imIn), RES_ERR_BAD_ALLOCATION, this->retVal);
 
-      lineType                       pixels = imIn.getPixels();
-      Blob::sequences_const_iterator it     = blob.sequences.begin();
-      Blob::sequences_const_iterator it_end = blob.sequences.end();
-      size_t                         x, y, z;
-      for (; it != it_end; it++) {
-        imIn.getCoordsFromOffset((*it).offset, x, y, z);
-        this->processSequence(pixels + (*it).offset, (*it).size, x, y, z);
+      lineType pixels = imIn.getPixels();
+      size_t   x, y, z;
+      for (size_t i = 0; i < seqNbr; i++) {
+        imIn.getCoordsFromOffset(seqs[i].offset, x, y, z);
+        this->processSequence(pixels + seqs[i].offset, seqs[i].size, x, y, z);
       }
       this->finalize(imIn);
       return this->retVal;
@@ -267,16 +278,17 @@ namespace smil
 
     ASSERT(CHECK_ALLOCATED(&imIn), RES_ERR_BAD_ALLOCATION, res);
 
-    size_t               blobNbr = blobs.size();
-    std::vector<labelT>  _keys;
-    std::vector<retType> _results(blobNbr);
+    size_t                    blobNbr = blobs.size();
+    std::vector<const Blob *> _blobs;
+    std::vector<retType>      _results(blobNbr);
 
+    _blobs.reserve(blobNbr);
     for (typename std::map<labelT, Blob>::const_iterator it = blobs.begin();
          it != blobs.end(); it++)
-      _keys.push_back(it->first);
+      _blobs.push_back(&it->second);
 
-    labelT  *keys    = _keys.data();
-    retType *results = _results.data();
+    const Blob **blobPtrs = _blobs.data();
+    retType     *results  = _results.data();
 
     size_t i;
 
@@ -289,13 +301,66 @@ namespace smil
 #pragma omp for
 #endif // USE_OPEN_MP
       for (i = 0; i < blobNbr; i++) {
-        funcT       func;
-        const Blob &blob = blobs.at(keys[i]);
-        results[i]       = func(imIn, blob);
+        funcT func;
+        results[i] = func(imIn, *blobPtrs[i]);
+      }
+    }
+
+    i = 0;
+    for (typename std::map<labelT, Blob>::const_iterator it = blobs.begin();
+         it != blobs.end(); it++, i++)
+      res.emplace_hint(res.end(), it->first, results[i]);
+    return res;
+  }
+
+  /*
+   * Evaluate a measure on each blob of a run table. Results are indexed by
+   * the position of the blob in the table.
+   */
+  template <class T, class labelT, class funcT>
+  std::vector<typename funcT::retType>
+  processBlobTableMeasure(const Image<T> &imIn, const BlobTable<labelT> &table)
+  {
+    typedef typename funcT::retType retType;
+
+    size_t               blobNbr = table.size();
+    std::vector<retType> res(blobNbr);
+
+    ASSERT(CHECK_ALLOCATED(&imIn), RES_ERR_BAD_ALLOCATION, res);
+
+    retType *results = res.data();
+
+    size_t i;
+
+#ifdef USE_OPEN_MP
+    int nthreads = Core::getInstance()->getNumberOfThreads();
+#pragma omp parallel private(i) num_threads(nthreads)
+#endif // USE_OPEN_MP
+    {
+#ifdef USE_OPEN_MP
+#pragma omp for schedule(dynamic, 64)
+#endif // USE_OPEN_MP
+      for (i = 0; i < blobNbr; i++) {
+        funcT func;
+        results[i] = func(imIn, table.getRuns(i), table.getRunCount(i));
       }
     }
-    for (i = 0; i < blobNbr; i++)
-      res[keys[i]] = results[i];
+    return res;
+  }
+
+  /*
+   * Map adapter on processBlobTableMeasure()
+   */
+  template <class T, class labelT, class funcT>
+  std::map<labelT, typename funcT::retType>
+  processBlobMeasure(const Image<T> &imIn, const BlobTable<labelT> &table)
+  {
+    std::map<labelT, typename funcT::retType> res;
+
+    std::vector<typename funcT::retType> results =
+        processBlobTableMeasure<T, labelT, funcT>(imIn, table);
+    for (size_t i = 0; i < results.size(); i++)
+      res.emplace_hint(res.end(), table.labels[i], results[i]);
     return res;
   }
 
@@ -306,8 +371,8 @@ namespace smil
   std::map<labelT, typename funcT::retType>
   processBlobMeasure(const Image<T> &imIn, bool onlyNonZero = true)
   {
-    std::map<labelT, Blob> blobs = computeBlobs(imIn, onlyNonZero);
-    return processBlobMeasure<T, labelT, funcT>(imIn, blobs);
+    BlobTable<labelT> table = computeBlobTable(imIn, onlyNonZero);
+    return processBlobMeasure<T, labelT, funcT>(imIn, table);
   }
 
   /** @}*/
@@ -31,8 +31,14 @@
 #define _D_BLOB_HPP
 
 #include "Core/include/private/DImage.hpp"
+#include <algorithm>
+#include <limits>
 #include <map>
 
+#ifdef USE_OPEN_MP
+#include <omp.h>
+#endif // USE_OPEN_MP
+
 namespace smil
 {
   /**
@@ -88,51 +94,249 @@ namespace smil
   };
 
   /**
-   * Create a map of blobs from a labeled image
+   * Dense run table of the blobs of a labeled image.
+   *
+   * Runs are stored in a compressed sparse row layout : the runs of the
+   * blob at position @b i (whose label is <c>labels[i]</c>) are stored in
+   * <c>runs[starts[i]]</c> to <c>runs[starts[i + 1] - 1]</c>, in raster
+   * order. Labels are sorted in increasing order.
+   *
+   * This is the structure used internally by blob measures. Contrary to a
+   * map of Blob, it is built without any per-label allocation and can be
+   * traversed in parallel.
+   *
+   * @see computeBlobTable()
+   */
+  template <class labelT>
+  struct BlobTable {
+    std::vector<labelT>        labels;
+    std::vector<size_t>        starts;
+    std::vector<PixelSequence> runs;
+
+    BlobTable() : starts(1, 0)
+    {
+    }
+
+    /**
+     * Number of blobs in the table
+     */
+    size_t size() const
+    {
+      return labels.size();
+    }
+
+    /**
+     * Number of runs of the blob at position @b i
+     */
+    size_t getRunCount(size_t i) const
+    {
+      return starts[i + 1] - starts[i];
+    }
+
+    /**
+     * Pointer to the first run of the blob at position @b i
+     */
+    const PixelSequence *getRuns(size_t i) const
+    {
+      return runs.data() + starts[i];
+    }
+
+    /**
+     * Position of a label in the table, or @b size() if absent
+     */
+    size_t find(labelT lbl) const
+    {
+      typename std::vector<labelT>::const_iterator it =
+          std::lower_bound(labels.begin(), labels.end(), lbl);
+      if (it == labels.end() || *it != lbl)
+        return labels.size();
+      return it - labels.begin();
+    }
+
+    /**
+     * Convert the table into a map of Blob
+     */
+    std::map<labelT, Blob> toBlobMap() const
+    {
+      std::map<labelT, Blob> blobs;
+      for (size_t i = 0; i < labels.size(); i++) {
+        Blob &blob = blobs.emplace_hint(blobs.end(), labels[i], Blob())->second;
+        blob.sequences.assign(getRuns(i), getRuns(i) + getRunCount(i));
+      }
+      return blobs;
+    }
+  };
+
+  /**
+   * Create a dense run table of blobs from a labeled image
+   *
+   * Lines are split among threads, each thread extracting its own run
+   * list. Runs are then counted per label and scattered into the CSR
+   * table in thread order, so that the raster order is kept inside each
+   * blob.
+   *
+   * When labels aren't non negative integers, or when the maximum label is
+   * larger than the number of runs (sparse labels), buckets are obtained by
+   * sorting runs instead.
    *
    * @param[in] imIn : input @b labeled image
    * @param[in] onlyNonZero : ignore regions whose label is @b 0
-   * @return a map of pairs <b><label, blob></b>
+   * @return the run table of the blobs in the image
    */
   template <class T>
-  std::map<T, Blob> computeBlobs(const Image<T> &imIn, bool onlyNonZero = true)
+  BlobTable<T> computeBlobTable(const Image<T> &imIn, bool onlyNonZero = true)
   {
-    std::map<T, Blob> blobs;
+    BlobTable<T> table;
 
-    ASSERT(CHECK_ALLOCATED(&imIn), RES_ERR_BAD_ALLOCATION, blobs);
+    ASSERT(CHECK_ALLOCATED(&imIn), RES_ERR_BAD_ALLOCATION, table);
 
-    typename ImDtTypes<T>::sliceType lines = imIn.getLines();
-    typename ImDtTypes<T>::lineType  pixels;
+    typename ImDtTypes<T>::sliceType lines  = imIn.getLines();
     size_t                           npix   = imIn.getWidth();
     size_t                           nlines = imIn.getLineCount();
 
-    T curVal;
-
-    for (size_t l = 0; l < nlines; l++) {
-      size_t curSize  = 0;
-      size_t curStart = l * npix;
-
-      pixels = lines[l];
-      curVal = pixels[0];
-      if (curVal != 0 || !onlyNonZero)
-        curSize++;
-
-      for (size_t i = 1; i < npix; i++) {
-        if (pixels[i] == curVal)
-          curSize++;
-        else {
-          if (curVal != 0 || !onlyNonZero)
-            blobs[curVal].sequences.push_back(PixelSequence(curStart, curSize));
-          curStart = i + l * npix;
-          curSize  = 1;
-          curVal   = pixels[i];
+    int nthreads = 1;
+#ifdef USE_OPEN_MP
+    nthreads = Core::getInstance()->getNumberOfThreads();
+    if (size_t(nthreads) > nlines)
+      nthreads = std::max<int>(int(nlines), 1);
+#endif // USE_OPEN_MP
+
+    // Per-thread run lists
+    std::vector<std::vector<T>>             runLabels(nthreads);
+    std::vector<std::vector<PixelSequence>> runSeqs(nthreads);
+    std::vector<T>                          minLabels(nthreads, T(0));
+    std::vector<T>                          maxLabels(nthreads, T(0));
+
+#ifdef USE_OPEN_MP
+#pragma omp parallel num_threads(nthreads)
+#endif // USE_OPEN_MP
+    {
+      int tid = 0;
+#ifdef USE_OPEN_MP
+      tid = omp_get_thread_num();
+#endif // USE_OPEN_MP
+      size_t lBeg = nlines * tid / nthreads;
+      size_t lEnd = nlines * (tid + 1) / nthreads;
+
+      std::vector<T>             &lbls   = runLabels[tid];
+      std::vector<PixelSequence> &seqs   = runSeqs[tid];
+      T                           minLbl = T(0), maxLbl = T(0);
+
+      for (size_t l = lBeg; l < lEnd; l++) {
+        typename ImDtTypes<T>::lineType pixels = lines[l];
+        size_t                          i      = 0;
+        while (i < npix) {
+          T      curVal   = pixels[i];
+          size_t curStart = i;
+          while (++i < npix && pixels[i] == curVal)
+            ;
+          if (curVal != T(0) || !onlyNonZero) {
+            lbls.push_back(curVal);
+            seqs.push_back(PixelSequence(l * npix + curStart, i - curStart));
+            if (lbls.size() == 1 || curVal < minLbl)
+              minLbl = curVal;
+            if (lbls.size() == 1 || curVal > maxLbl)
+              maxLbl = curVal;
+          }
         }
       }
-      if (curVal != 0 || !onlyNonZero)
-        blobs[curVal].sequences.push_back(PixelSequence(curStart, curSize));
+      minLabels[tid] = minLbl;
+      maxLabels[tid] = maxLbl;
     }
 
-    return blobs;
+    size_t runCount = 0;
+    T      minLbl = T(0), maxLbl = T(0);
+    for (int t = 0; t < nthreads; t++) {
+      if (runLabels[t].empty())
+        continue;
+      if (runCount == 0 || minLabels[t] < minLbl)
+        minLbl = minLabels[t];
+      if (runCount == 0 || maxLabels[t] > maxLbl)
+        maxLbl = maxLabels[t];
+      runCount += runLabels[t].size();
+    }
+    if (runCount == 0)
+      return table;
+
+    table.runs.resize(runCount);
+
+    bool dense = std::numeric_limits<T>::is_integer && minLbl >= T(0) &&
+                 size_t(maxLbl) <= runCount;
+    if (dense) {
+      // Dense labels : counting sort on label values, in two passes over
+      // the runs with one shared array
+      size_t              nSlots = size_t(maxLbl) + 1;
+      std::vector<size_t> counts(nSlots, 0);
+      for (int t = 0; t < nthreads; t++) {
+        const std::vector<T> &lbls = runLabels[t];
+        for (size_t i = 0; i < lbls.size(); i++)
+          counts[size_t(lbls[i])]++;
+      }
+
+      // Turn counts into write positions
+      size_t pos = 0;
+      for (size_t s = 0; s < nSlots; s++) {
+        size_t n  = counts[s];
+        counts[s] = pos;
+        pos += n;
+        if (n > 0) {
+          table.labels.push_back(T(s));
+          table.starts.push_back(pos);
+        }
+      }
+
+      for (int t = 0; t < nthreads; t++) {
+        const std::vector<T>             &lbls = runLabels[t];
+        const std::vector<PixelSequence> &seqs = runSeqs[t];
+        for (size_t i = 0; i < lbls.size(); i++)
+          table.runs[counts[size_t(lbls[i])]++] = seqs[i];
+      }
+    } else {
+      // Sparse labels : stable sort of run indices on labels
+      std::vector<T>             allLabels;
+      std::vector<PixelSequence> allSeqs;
+      allLabels.reserve(runCount);
+      allSeqs.reserve(runCount);
+      for (int t = 0; t < nthreads; t++) {
+        allLabels.insert(allLabels.end(), runLabels[t].begin(),
+                         runLabels[t].end());
+        allSeqs.insert(allSeqs.end(), runSeqs[t].begin(), runSeqs[t].end());
+      }
+
+      std::vector<size_t> order(runCount);
+      for (size_t i = 0; i < runCount; i++)
+        order[i] = i;
+      std::stable_sort(order.begin(), order.end(),
+                       [&allLabels](size_t a, size_t b) {
+                         return allLabels[a] < allLabels[b];
+                       });
+
+      for (size_t i = 0; i < runCount; i++) {
+        T lbl = allLabels[order[i]];
+        if (table.labels.empty() || table.labels.back() != lbl) {
+          if (!table.labels.empty())
+            table.starts.push_back(i);
+          table.labels.push_back(lbl);
+        }
+        table.runs[i] = allSeqs[order[i]];
+      }
+      table.starts.push_back(runCount);
+    }
+
+    return table;
+  }
+
+  /**
+   * Create a map of blobs from a labeled image
+   *
+   * @param[in] imIn : input @b labeled image
+   * @param[in] onlyNonZero : ignore regions whose label is @b 0
+   * @return a map of pairs <b><label, blob></b>
+   */
+  template <class T>
+  std::map<T, Blob> computeBlobs(const Image<T> &imIn, bool onlyNonZero = true)
+  {
+    return computeBlobTable(imIn, onlyNonZero).toBlobMap();
   }
 
   /**
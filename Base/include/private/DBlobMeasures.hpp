@@ -34,7 +34,9 @@
 #include "DImageHistogram.hpp"
 #include "DMeasures.hpp"
 
+#include <limits>
 #include <map>
+#include <string>
 
 namespace smil
 {
@@ -346,6 +348,630 @@ namespace smil
     return processBlobMeasure<T, labelT, measEntropyFunc<T>>(imIn, blobs);
   }
 
+  //
+  //  ####    ####   #       #    #  #    #  #    #   ####
+  // #    #  #    #  #       #    #  ##  ##  ##   #  #
+  // #       #    #  #       #    #  # ## #  # #  #   ####
+  // #       #    #  #       #    #  #    #  #  # #       #
+  // #    #  #    #  #       #    #  #    #  #   ##  #    #
+  //  ####    ####   ######   ####   #    #  #    #   ####
+  //
+  /**
+   * Column oriented storage of blob measures.
+   *
+   * Each feature is stored in a contiguous column indexed by label : the
+   * value of feature @b f for the blob labeled @b l is
+   * <c>getColumn(f)[l]</c>. Rows of labels absent from the image are set to
+   * @b 0.
+   *
+   * Columns are stored one after the other in a single buffer, so the whole
+   * table is also a <c>features x rows</c> row-major matrix.
+   *
+   * @see blobsMeasureTable()
+   */
+  class BlobMeasureTable
+  {
+  public:
+    BlobMeasureTable() : rowCount(0)
+    {
+    }
+
+    /**
+     * Allocate the table for a list of features and a number of rows
+     * (i.e. maximum label + 1)
+     */
+    void resize(const std::vector<std::string> &featureNames, size_t rows)
+    {
+      features = featureNames;
+      rowCount = rows;
+      data.assign(features.size() * rowCount, 0.);
+    }
+
+    /**
+     * Number of rows (labels) of each column
+     */
+    size_t getRowCount() const
+    {
+      return rowCount;
+    }
+
+    /**
+     * Number of columns (features)
+     */
+    size_t getFeatureCount() const
+    {
+      return features.size();
+    }
+
+    /**
+     * Names of the features, in column order
+     */
+    std::vector<std::string> getFeatures() const
+    {
+      return features;
+    }
+
+    /**
+     * Index of a feature column, or -1 if the feature is not in the table
+     */
+    int getFeatureIndex(const std::string &feature) const
+    {
+      for (size_t i = 0; i < features.size(); i++)
+        if (features[i] == feature)
+          return int(i);
+      return -1;
+    }
+
+#ifndef SWIG
+    /**
+     * Pointer to the column of a feature, or @b NULL if absent
+     */
+    double *getColumn(const std::string &feature)
+    {
+      int i = getFeatureIndex(feature);
+      if (i < 0)
+        return NULL;
+      return data.data() + size_t(i) * rowCount;
+    }
+
+    /**
+     * Pointers to all columns, in feature order
+     */
+    std::vector<double *> getColumns()
+    {
+      std::vector<double *> cols(features.size());
+      for (size_t i = 0; i < features.size(); i++)
+        cols[i] = data.data() + i * rowCount;
+      return cols;
+    }
+#endif // SWIG
+
+    /**
+     * Copy of the column of a feature
+     */
+    std::vector<double> getValues(const std::string &feature) const
+    {
+      int i = getFeatureIndex(feature);
+      if (i < 0)
+        return std::vector<double>();
+      std::vector<double>::const_iterator first =
+          data.begin() + size_t(i) * rowCount;
+      return std::vector<double>(first, first + rowCount);
+    }
+
+#if defined SWIGPYTHON && defined USE_NUMPY
+    /**
+     * getNumpyArray() - NumPy array sharing the memory of a feature column
+     *
+     * @warning The table must outlive the returned array.
+     */
+    PyObject *getNumpyArray(const std::string &feature)
+    {
+      int i = getFeatureIndex(feature);
+      if (i < 0) {
+        ERR_MSG("Feature not in table : " + feature);
+        Py_RETURN_NONE;
+      }
+      npy_intp d[1] = {npy_intp(rowCount)};
+      return PyArray_SimpleNewFromData(1, d, NPY_DOUBLE,
+                                       data.data() + size_t(i) * rowCount);
+    }
+
+    /**
+     * getNumpyArray() - NumPy array (features x rows) sharing the memory of
+     * the whole table
+     *
+     * @warning The table must outlive the returned array.
+     */
+    PyObject *getNumpyArray()
+    {
+      npy_intp d[2] = {npy_intp(features.size()), npy_intp(rowCount)};
+      return PyArray_SimpleNewFromData(2, d, NPY_DOUBLE, data.data());
+    }
+#endif // defined SWIGPYTHON && defined USE_NUMPY
+
+  private:
+    std::vector<std::string> features;
+    size_t                   rowCount;
+    std::vector<double>      data;
+  };
+
+  /** @cond */
+  /*
+   * Rows of label-indexed columns are indexed by the label values : labels
+   * shall be non negative integers, the largest one lower than rowCount.
+   */
+  template <class labelT>
+  bool blobLabelsAreRows(const BlobTable<labelT> &blobs)
+  {
+    return blobs.size() == 0 || (std::numeric_limits<labelT>::is_integer &&
+                                 blobs.labels.front() >= labelT(0));
+  }
+
+  template <class labelT>
+  bool blobLabelsFitRows(const BlobTable<labelT> &blobs, size_t rowCount)
+  {
+    return blobLabelsAreRows(blobs) &&
+           (blobs.size() == 0 || size_t(blobs.labels.back()) < rowCount);
+  }
+
+  struct blobFeatureSet {
+    enum FeatureID {
+      F_AREA,
+      F_VOLUME,
+      F_MIN,
+      F_MAX,
+      F_MEAN,
+      F_STDDEV,
+      F_XC,
+      F_YC,
+      F_ZC,
+      F_XMIN,
+      F_YMIN,
+      F_ZMIN,
+      F_XMAX,
+      F_YMAX,
+      F_ZMAX,
+      F_M000,
+      F_M100,
+      F_M010,
+      F_M001,
+      F_M110,
+      F_M101,
+      F_M011,
+      F_M200,
+      F_M020,
+      F_M002,
+      F_COUNT
+    };
+
+    std::vector<int> ids;
+    bool             needValues, needMinMax, needPos, needBox, needMoments2;
+
+    bool parse(const std::vector<std::string> &features)
+    {
+      static const char *names[F_COUNT] = {
+          "area", "volume", "min",  "max",  "mean", "stddev", "xc",
+          "yc",   "zc",     "xmin", "ymin", "zmin", "xmax",   "ymax",
+          "zmax", "m000",   "m100", "m010", "m001", "m110",   "m101",
+          "m011", "m200",   "m020", "m002"};
+
+      ids.clear();
+      needValues = needMinMax = needPos = needBox = needMoments2 = false;
+      for (size_t i = 0; i < features.size(); i++) {
+        int id = -1;
+        for (int f = 0; f < F_COUNT; f++)
+          if (features[i] == names[f])
+            id = f;
+        if (id < 0) {
+          ERR_MSG("Unknown blob feature : " + features[i]);
+          return false;
+        }
+        ids.push_back(id);
+
+        if (id == F_VOLUME || id == F_MEAN || id == F_STDDEV)
+          needValues = true;
+        else if (id == F_MIN || id == F_MAX)
+          needMinMax = true;
+        else if (id >= F_XMIN && id <= F_ZMAX)
+          needBox = true;
+        else if ((id >= F_XC && id <= F_ZC) || (id >= F_M000 && id <= F_M001))
+          needPos = true;
+        else if (id >= F_M110)
+          needPos = needMoments2 = true;
+      }
+      return true;
+    }
+  };
+  /** @endcond */
+
+#ifndef SWIG
+  /**
+   * blobsMeasureTable() - Measure a set of features on each blob, in a
+   * single traversal, into caller-provided label-indexed columns.
+   *
+   * Available features are :
+   * - @TB{"area"} : number of pixels;
+   * - @TB{"volume"}, @TB{"min"}, @TB{"max"}, @TB{"mean"}, @TB{"stddev"} :
+   *   statistics of the values of @b imIn;
+   * - @TB{"xc"}, @TB{"yc"}, @TB{"zc"} : barycenter, weighted by the values of
+   *   @b imIn (see blobsBarycenter());
+   * - @TB{"xmin"}, @TB{"ymin"}, @TB{"zmin"}, @TB{"xmax"}, @TB{"ymax"},
+   *   @TB{"zmax"} : bounding box;
+   * - @TB{"m000"}, @TB{"m100"}, @TB{"m010"}, @TB{"m001"}, @TB{"m110"},
+   *   @TB{"m101"}, @TB{"m011"}, @TB{"m200"}, @TB{"m020"}, @TB{"m002"} : non
+   *   centered moments (see blobsMoments()).
+   *
+   * @param[in] imIn : input image
+   * @param[in] blobs : input blob run table
+   * @param[in] features : names of the features to measure
+   * @param[out] columns : one array per feature, each of @b rowCount values
+   * @param[in] rowCount : size of each column, shall be greater than the
+   * maximum label
+   *
+   * @note Rows of labels absent from @b blobs are set to @b 0.
+   */
+  template <class T, class labelT>
+  RES_T blobsMeasureTable(const Image<T> &imIn, const BlobTable<labelT> &blobs,
+                          const std::vector<std::string> &features,
+                          double *const *columns, size_t rowCount)
+  {
+    ASSERT_ALLOCATED(&imIn);
+
+    blobFeatureSet fset;
+    ASSERT(fset.parse(features), "Bad feature list", RES_ERR);
+
+    size_t nFeatures = fset.ids.size();
+    size_t blobNbr   = blobs.size();
+
+    ASSERT(blobLabelsAreRows(blobs),
+           "Labels shall be non negative integers", RES_ERR);
+    ASSERT(blobLabelsFitRows(blobs, rowCount),
+           "Columns are too small for the labels", RES_ERR);
+
+    for (size_t f = 0; f < nFeatures; f++)
+      std::fill(columns[f], columns[f] + rowCount, 0.);
+
+    typename ImDtTypes<T>::lineType pixels = imIn.getPixels();
+
+    size_t     width     = imIn.getWidth();
+    size_t     sliceSize = width * imIn.getHeight();
+    const int *ids       = fset.ids.data();
+
+    size_t i;
+
+#ifdef USE_OPEN_MP
+    int nthreads = Core::getInstance()->getNumberOfThreads();
+#pragma omp parallel for private(i) schedule(dynamic, 64) num_threads(nthreads)
+#endif // USE_OPEN_MP
+    for (i = 0; i < blobNbr; i++) {
+      double n = 0, sum = 0, sum2 = 0;
+      double vMin = double(ImDtTypes<T>::max());
+      double vMax = double(ImDtTypes<T>::min());
+      double m000 = 0, m100 = 0, m010 = 0, m001 = 0;
+      double m110 = 0, m101 = 0, m011 = 0, m200 = 0, m020 = 0, m002 = 0;
+      size_t xMin = width, yMin = imIn.getHeight(), zMin = imIn.getDepth();
+      size_t xMax = 0, yMax = 0, zMax = 0;
+
+      const PixelSequence *runs   = blobs.getRuns(i);
+      size_t               runNbr = blobs.getRunCount(i);
+
+      for (size_t r = 0; r < runNbr; r++) {
+        size_t off  = runs[r].offset;
+        size_t size = runs[r].size;
+        n += size;
+
+        typename ImDtTypes<T>::lineType line = pixels + off;
+
+        if (fset.needValues)
+          for (size_t k = 0; k < size; k++) {
+            double v = double(line[k]);
+            sum += v;
+            sum2 += v * v;
+          }
+        if (fset.needMinMax)
+          for (size_t k = 0; k < size; k++) {
+            double v = double(line[k]);
+            if (v < vMin)
+              vMin = v;
+            if (v > vMax)
+              vMax = v;
+          }
+        if (!fset.needPos && !fset.needBox)
+          continue;
+
+        size_t z = off / sliceSize;
+        size_t y = (off % sliceSize) / width;
+        size_t x = off % width;
+
+        if (fset.needBox) {
+          xMin = std::min(xMin, x);
+          xMax = std::max(xMax, x + size - 1);
+          yMin = std::min(yMin, y);
+          yMax = std::max(yMax, y);
+          zMin = std::min(zMin, z);
+          zMax = std::max(zMax, z);
+        }
+        if (fset.needPos)
+          for (size_t k = 0; k < size; k++, x++) {
+            double v = double(line[k]);
+            m000 += v;
+            m100 += v * x;
+            m010 += v * y;
+            m001 += v * z;
+            if (fset.needMoments2) {
+              m110 += v * x * y;
+              m101 += v * x * z;
+              m011 += v * y * z;
+              m200 += v * x * x;
+              m020 += v * y * y;
+              m002 += v * z * z;
+            }
+          }
+      }
+
+      size_t row = size_t(blobs.labels[i]);
+      for (size_t f = 0; f < nFeatures; f++) {
+        double val = 0;
+        switch (ids[f]) {
+          case blobFeatureSet::F_AREA:
+            val = n;
+            break;
+          case blobFeatureSet::F_VOLUME:
+            val = sum;
+            break;
+          case blobFeatureSet::F_MIN:
+            val = vMin;
+            break;
+          case blobFeatureSet::F_MAX:
+            val = vMax;
+            break;
+          case blobFeatureSet::F_MEAN:
+            val = sum / n;
+            break;
+          case blobFeatureSet::F_STDDEV:
+            val = std::sqrt(std::max(sum2 / n - (sum / n) * (sum / n), 0.));
+            break;
+          case blobFeatureSet::F_XC:
+            val = m100 / m000;
+            break;
+          case blobFeatureSet::F_YC:
+            val = m010 / m000;
+            break;
+          case blobFeatureSet::F_ZC:
+            val = m001 / m000;
+            break;
+          case blobFeatureSet::F_XMIN:
+            val = double(xMin);
+            break;
+          case blobFeatureSet::F_YMIN:
+            val = double(yMin);
+            break;
+          case blobFeatureSet::F_ZMIN:
+            val = double(zMin);
+            break;
+          case blobFeatureSet::F_XMAX:
+            val = double(xMax);
+            break;
+          case blobFeatureSet::F_YMAX:
+            val = double(yMax);
+            break;
+          case blobFeatureSet::F_ZMAX:
+            val = double(zMax);
+            break;
+          case blobFeatureSet::F_M000:
+            val = m000;
+            break;
+          case blobFeatureSet::F_M100:
+            val = m100;
+            break;
+          case blobFeatureSet::F_M010:
+            val = m010;
+            break;
+          case blobFeatureSet::F_M001:
+            val = m001;
+            break;
+          case blobFeatureSet::F_M110:
+            val = m110;
+            break;
+          case blobFeatureSet::F_M101:
+            val = m101;
+            break;
+          case blobFeatureSet::F_M011:
+            val = m011;
+            break;
+          case blobFeatureSet::F_M200:
+            val = m200;
+            break;
+          case blobFeatureSet::F_M020:
+            val = m020;
+            break;
+          case blobFeatureSet::F_M002:
+            val = m002;
+            break;
+        }
+        columns[f][row] = val;
+      }
+    }
+
+    return RES_OK;
+  }
+#endif // SWIG
+
+  /**
+   * blobsMeasureTable() - Measure a set of features on each region of a
+   * labeled image, in a single traversal.
+   *
+   * @param[in] imIn : input image
+   * @param[in] imLbl : input labeled image
+   * @param[in] features : names of the features to measure (see the other
+   * version of this function for the list)
+   * @param[out] table : output table, with one label-indexed column per
+   * feature
+   * @param[in] onlyNonZero : skip a blob having a null label
+   *
+   * In Python, columns can be accessed without copy as NumPy arrays with
+   * @TT{table.getNumpyArray("area")}.
+   *
+   * @note Columns have one row per value up to the maximum label : labels
+   * shall be non negative integers, and preferably consecutive, as given by
+   * label().
+   *
+   * @smilexample{blob_measures.py}
+   */
+  template <class T, class labelT>
+  RES_T blobsMeasureTable(const Image<T> &imIn, const Image<labelT> &imLbl,
+                          const std::vector<std::string> &features,
+                          BlobMeasureTable &table, bool onlyNonZero = true)
+  {
+    ASSERT_ALLOCATED(&imIn, &imLbl);
+    ASSERT_SAME_SIZE(&imIn, &imLbl);
+
+    BlobTable<labelT> blobs = computeBlobTable(imLbl, onlyNonZero);
+    ASSERT(blobLabelsAreRows(blobs),
+           "Labels shall be non negative integers", RES_ERR);
+
+    size_t rowCount = blobs.size() > 0 ? size_t(blobs.labels.back()) + 1 : 1;
+    table.resize(features, rowCount);
+
+    std::vector<double *> columns = table.getColumns();
+    return blobsMeasureTable(imIn, blobs, features, columns.data(), rowCount);
+  }
+
+  /**
+   * blobsMeasureTable() - Measure a set of geometric features on each region
+   * of a labeled image, in a single traversal.
+   *
+   * Value weighted features (barycenter, moments) are evaluated with unit
+   * weights.
+   *
+   * @param[in] imLbl : input labeled image
+   * @param[in] features : names of the features to measure
+   * @param[out] table : output table, with one label-indexed column per
+   * feature
+   * @param[in] onlyNonZero : skip a blob having a null label
+   */
+  template <class labelT>
+  RES_T blobsMeasureTable(const Image<labelT>            &imLbl,
+                          const std::vector<std::string> &features,
+                          BlobMeasureTable &table, bool onlyNonZero = true)
+  {
+    ASSERT_ALLOCATED(&imLbl);
+
+    Image<UINT8> imOne(imLbl);
+    fill(imOne, UINT8(1));
+    return blobsMeasureTable(imOne, imLbl, features, table, onlyNonZero);
+  }
+
+#ifndef SWIG
+  /**
+   * blobsArea() - Measure the area of each blob into a label-indexed array.
+   *
+   * @param[in] blobs : input blob run table
+   * @param[out] areas : array of @b rowCount values
+   * @param[in] rowCount : size of @b areas, greater than the maximum label
+   */
+  template <class labelT>
+  RES_T blobsArea(const BlobTable<labelT> &blobs, double *areas,
+                  size_t rowCount)
+  {
+    ASSERT(blobLabelsAreRows(blobs),
+           "Labels shall be non negative integers", RES_ERR);
+    ASSERT(blobLabelsFitRows(blobs, rowCount),
+           "Array is too small for the labels", RES_ERR);
+
+    std::fill(areas, areas + rowCount, 0.);
+    for (size_t i = 0; i < blobs.size(); i++) {
+      const PixelSequence *runs = blobs.getRuns(i);
+      double               n    = 0;
+      for (size_t r = 0; r < blobs.getRunCount(i); r++)
+        n += runs[r].size;
+      areas[size_t(blobs.labels[i])] = n;
+    }
+    return RES_OK;
+  }
+
+  /**
+   * blobsVolume() - Measure the volume of each blob into a label-indexed
+   * array.
+   *
+   * @param[in] imIn : input image
+   * @param[in] blobs : input blob run table
+   * @param[out] volumes : array of @b rowCount values
+   * @param[in] rowCount : size of @b volumes, greater than the maximum label
+   */
+  template <class T, class labelT>
+  RES_T blobsVolume(const Image<T> &imIn, const BlobTable<labelT> &blobs,
+                    double *volumes, size_t rowCount)
+  {
+    std::vector<std::string> features(1, "volume");
+    return blobsMeasureTable(imIn, blobs, features, &volumes, rowCount);
+  }
+
+  /**
+   * blobsMeanVal() - Measure the mean value and standard deviation of each
+   * blob into label-indexed arrays.
+   *
+   * @param[in] imIn : input image
+   * @param[in] blobs : input blob run table
+   * @param[out] means, stdDevs : arrays of @b rowCount values
+   * @param[in] rowCount : size of the arrays, greater than the maximum label
+   */
+  template <class T, class labelT>
+  RES_T blobsMeanVal(const Image<T> &imIn, const BlobTable<labelT> &blobs,
+                     double *means, double *stdDevs, size_t rowCount)
+  {
+    std::vector<std::string> features = {"mean", "stddev"};
+    double                  *columns[2] = {means, stdDevs};
+    return blobsMeasureTable(imIn, blobs, features, columns, rowCount);
+  }
+
+  /**
+   * blobsBarycenter() - Measure the barycenter of each blob into
+   * label-indexed arrays.
+   *
+   * @param[in] imIn : input image
+   * @param[in] blobs : input blob run table
+   * @param[out] xc, yc, zc : arrays of @b rowCount values (@b zc may be
+   * @b NULL)
+   * @param[in] rowCount : size of the arrays, greater than the maximum label
+   */
+  template <class T, class labelT>
+  RES_T blobsBarycenter(const Image<T> &imIn, const BlobTable<labelT> &blobs,
+                        double *xc, double *yc, double *zc, size_t rowCount)
+  {
+    std::vector<std::string> features = {"xc", "yc"};
+    double                  *columns[3] = {xc, yc, zc};
+    if (zc != NULL)
+      features.push_back("zc");
+    return blobsMeasureTable(imIn, blobs, features, columns, rowCount);
+  }
+
+  /**
+   * blobsMoments() - Measure the non centered moments of each blob into
+   * label-indexed arrays.
+   *
+   * @param[in] imIn : input image
+   * @param[in] blobs : input blob run table
+   * @param[out] moments : 6 arrays (2D images) or 10 arrays (3D images) of
+   * @b rowCount values, in the same order as the vector returned by
+   * measMoments()
+   * @param[in] rowCount : size of the arrays, greater than the maximum label
+   */
+  template <class T, class labelT>
+  RES_T blobsMoments(const Image<T> &imIn, const BlobTable<labelT> &blobs,
+                     double *const *moments, size_t rowCount)
+  {
+    std::vector<std::string> features;
+    if (imIn.getDimension() == 3)
+      features = {"m000", "m100", "m010", "m001", "m110",
+                  "m101", "m011", "m200", "m020", "m002"};
+    else
+      features = {"m000", "m100", "m010", "m110", "m200", "m020"};
+    return blobsMeasureTable(imIn, blobs, features, moments, rowCount);
+  }
+#endif // SWIG
+
   /** @}*/
 
 } // namespace smil
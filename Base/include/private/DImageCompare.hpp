@@ -623,70 +623,6 @@ namespace smil
     return area(imOut);
   }
 
-  /**
-   * distanceHausdorff() -
-   *
-   *
-   * @see
-   * - Wikipedia : @UrlWikipedia{Hausdorff_distance, Hausdorff distance}
-   * @note
-   * - only binary images (two classes)
-   *
-   * @param[in] imGt : @TI{Ground Truth} image
-   * @param[in] imIn : image to verify
-   * @returns returns @TB{Hausdorff distance} between two images
-   */
-  template <typename T>
-  double distanceHausdorff(const Image<T> &imGt, const Image<T> &imIn)
-  {
-    ASSERT_ALLOCATED(&imGt, &imIn);
-    ASSERT_SAME_SIZE(&imGt, &imIn);
-
-    if (!isBinary(imGt) || !isBinary(imIn)) {
-      ERR_MSG("This function is defined only for binary images");
-      return 0.;
-    }
-
-    Image<T> imt(imGt);
-
-    gradient(imGt, imt, SquSE());
-    inf(imGt, imt, imt);
-    std::vector<size_t> pixGt = nonZeroOffsets(imt);
-
-    gradient(imIn, imt, SquSE());
-    inf(imIn, imt, imt);
-    std::vector<size_t> pixIn = nonZeroOffsets(imt);
-
-    off_t               szGt = pixGt.size();
-    std::vector<double> distGt(szGt, std::numeric_limits<double>::max());
-    off_t               szIn = pixIn.size();
-    std::vector<double> distIn(szIn, std::numeric_limits<double>::max());
-
-    size_t Size[3];
-    imGt.getSize(Size);
-    ImageBox box(Size);
-
-#ifdef OPEN_MP
-#pragma omp parallel for
-#endif
-    for (off_t i = 0; i < szGt; i++) {
-      for (off_t j = 0; j < szIn; j++) {
-        double d = box.getDistance(pixGt[i], pixIn[j]);
-
-        if (d < distGt[i])
-          distGt[i] = d;
-        if (d < distIn[j])
-          distIn[j] = d;
-      }
-    }
-
-    std::vector<double>::iterator iGt, iIn;
-    iGt = std::max_element(distGt.begin(), distGt.end());
-    iIn = std::max_element(distIn.begin(), distIn.end());
-
-    return std::max(*iGt, *iIn);
-  }
-
   /** @} */
 
 #undef DXM
@@ -268,6 +268,288 @@ namespace smil
     return k.Convolve(imIn, radius, imOut);
   }
 
+  /** @cond */
+  /*
+   * Young - van Vliet recursive approximation of the Gaussian filter. Borders
+   * are replicated : the causal pass starts from its steady state and the
+   * anticausal one from the Triggs - Sdika initial values.
+   */
+  class RecursiveGaussian
+  {
+  public:
+    RecursiveGaussian(double sigma)
+    {
+      double q = sigma >= 2.5
+                     ? 0.98711 * sigma - 0.96330
+                     : 3.97156 - 4.14554 * std::sqrt(1. - 0.26891 * sigma);
+      double b0 = 1.57825 + q * (2.44413 + q * (1.4281 + q * 0.422205));
+      double c1 = q * (2.44413 + q * (2.85619 + q * 1.26661)) / b0;
+      double c2 = -q * q * (1.4281 + q * 1.26661) / b0;
+      double c3 = 0.422205 * q * q * q / b0;
+      double cB = 1. - (c1 + c2 + c3);
+
+      double scale = cB / ((1. + c1 - c2 + c3) * (1. - c1 - c2 - c3) *
+                           (1. + c2 + (c1 - c3) * c3));
+      double m[9]  = {-c3 * c1 + 1. - c3 * c3 - c2,
+                      (c3 + c1) * (c2 + c3 * c1),
+                      c3 * (c1 + c3 * c2),
+                      c1 + c3 * c2,
+                      -(c2 - 1.) * (c2 + c3 * c1),
+                      -(c3 * c1 + c3 * c3 + c2 - 1.) * c3,
+                      c3 * c1 + c2 + c1 * c1 - c2 * c2,
+                      c1 * c2 + c3 * c2 * c2 - c1 * c3 * c3 - c3 * c3 * c3 -
+                          c3 * c2 + c3,
+                      c3 * (c1 + c3 * c2)};
+      for (int i = 0; i < 9; i++)
+        M[i] = float(m[i] * scale);
+      a1 = float(c1);
+      a2 = float(c2);
+      a3 = float(c3);
+      B  = float(cB);
+    }
+
+    /*
+     * Filters count lines of len values, the value j of the line i being at
+     * p[i + j * stride]. Inner loops run over the lines : they vectorize when
+     * the lines are neighbour columns.
+     */
+    void apply(float *p, size_t len, size_t stride, size_t count,
+               std::vector<float> &buf) const
+    {
+      if (len < 2)
+        return;
+
+      buf.resize(3 * count);
+      float *last = &buf[0], *y1 = &buf[count], *y2 = &buf[2 * count];
+
+      float *wN = p + (len - 1) * stride;
+      for (size_t i = 0; i < count; i++)
+        last[i] = wN[i];
+
+      // Causal pass : values before the first one are constant
+      for (size_t j = 1; j < len; j++) {
+        float       *r  = p + j * stride;
+        const float *r1 = r - stride;
+        const float *r2 = p + (j >= 2 ? j - 2 : 0) * stride;
+        const float *r3 = p + (j >= 3 ? j - 3 : 0) * stride;
+        for (size_t i = 0; i < count; i++)
+          r[i] = B * r[i] + a1 * r1[i] + a2 * r2[i] + a3 * r3[i];
+      }
+
+      // Last value, and the two following ones, of the anticausal pass
+      const float *wN1 = wN - stride;
+      const float *wN2 = p + (len >= 3 ? len - 3 : 0) * stride;
+      for (size_t i = 0; i < count; i++) {
+        float u0 = wN[i] - last[i], u1 = wN1[i] - last[i];
+        float u2 = wN2[i] - last[i];
+        y1[i]    = last[i] + M[3] * u0 + M[4] * u1 + M[5] * u2;
+        y2[i]    = last[i] + M[6] * u0 + M[7] * u1 + M[8] * u2;
+        wN[i]    = last[i] + M[0] * u0 + M[1] * u1 + M[2] * u2;
+      }
+
+      // Anticausal pass
+      for (size_t j = len - 1; j-- > 0;) {
+        float       *r  = p + j * stride;
+        const float *r1 = r + stride;
+        const float *r2 = j + 2 < len ? r1 + stride : y1;
+        const float *r3 = j + 3 < len ? r2 + stride : (j + 3 == len ? y1 : y2);
+        for (size_t i = 0; i < count; i++)
+          r[i] = B * r[i] + a1 * r1[i] + a2 * r2[i] + a3 * r3[i];
+      }
+    }
+
+  private:
+    float a1, a2, a3, B;
+    float M[9];
+  };
+
+  /*
+   * Filters the lines of an image buffer along one axis (0, 1 or 2). Lines
+   * along y and z are processed by blocks of neighbour columns.
+   */
+  inline void recursiveGaussianAxis(const RecursiveGaussian &filter, float *buf,
+                                    const size_t *size, int axis)
+  {
+    size_t W = size[0], H = size[1], D = size[2];
+    size_t len, stride, count, nBlocks, blockSize = 256;
+
+    if (axis == 0) {
+      len = W, stride = 1, count = 1, nBlocks = H * D;
+    } else if (axis == 1) {
+      len = H, stride = W, count = std::min(W, blockSize);
+      nBlocks = D * ((W + count - 1) / count);
+    } else {
+      len = D, stride = W * H, count = std::min(W * H, blockSize);
+      nBlocks = (W * H + count - 1) / count;
+    }
+    size_t perSlice = axis == 1 ? nBlocks / D : nBlocks;
+
+#ifdef USE_OPEN_MP
+    int nthreads = Core::getInstance()->getNumberOfThreads();
+#pragma omp parallel num_threads(nthreads)
+#endif // USE_OPEN_MP
+    {
+      std::vector<float> lineBuf;
+
+#ifdef USE_OPEN_MP
+#pragma omp for schedule(dynamic)
+#endif // USE_OPEN_MP
+      for (size_t b = 0; b < nBlocks; b++) {
+        if (axis == 0) {
+          filter.apply(buf + b * W, len, stride, count, lineBuf);
+          continue;
+        }
+        size_t slice = axis == 1 ? b / perSlice : 0;
+        size_t first = (b % perSlice) * count;
+        size_t width = axis == 1 ? W : W * H;
+        filter.apply(buf + slice * W * H + first, len, stride,
+                     std::min(count, width - first), lineBuf);
+      }
+    }
+  }
+
+  /*
+   * Rounded and saturated conversion of the filtered values
+   */
+  template <class T>
+  inline T recursiveGaussianCast(float v)
+  {
+    if (IS_FLOAT(T))
+      return T(v);
+    if (v <= float(ImDtTypes<T>::min()))
+      return ImDtTypes<T>::min();
+    if (v >= float(ImDtTypes<T>::max()))
+      return ImDtTypes<T>::max();
+    return T(std::floor(v + 0.5f));
+  }
+
+  /*
+   * Gaussian filter of imIn in a float buffer, followed by an order-th
+   * finite difference along axis.
+   */
+  template <class T>
+  RES_T recursiveGaussianBuffer(const Image<T> &imIn, double sigma, int axis,
+                                int order, std::vector<float> &buf)
+  {
+    ASSERT(sigma >= 0.5, "sigma must be at least 0.5", RES_ERR);
+    ASSERT(axis >= 0 && axis <= 2, "axis must be 0, 1 or 2", RES_ERR);
+    ASSERT(order >= 0 && order <= 2, "order must be 0, 1 or 2", RES_ERR);
+
+    size_t size[3];
+    imIn.getSize(size);
+    size_t nPixels = imIn.getPixelCount();
+
+    buf.resize(nPixels);
+    typename ImDtTypes<T>::lineType pixels = imIn.getPixels();
+    for (size_t i = 0; i < nPixels; i++)
+      buf[i] = float(pixels[i]);
+
+    RecursiveGaussian filter(sigma);
+    for (int a = 0; a < 3; a++)
+      if (size[a] > 1)
+        recursiveGaussianAxis(filter, &buf[0], size, a);
+
+    if (order == 0)
+      return RES_OK;
+
+    // Central differences, with replicated borders : null along axes of
+    // size 1
+    size_t stride = axis == 0 ? 1 : (axis == 1 ? size[0] : size[0] * size[1]);
+    size_t len    = size[axis];
+    std::vector<float> in(buf);
+
+#ifdef USE_OPEN_MP
+    int nthreads = Core::getInstance()->getNumberOfThreads();
+#pragma omp parallel for num_threads(nthreads)
+#endif // USE_OPEN_MP
+    for (size_t i = 0; i < nPixels; i++) {
+      size_t j    = (i / stride) % len;
+      float  prev = in[j > 0 ? i - stride : i];
+      float  next = in[j + 1 < len ? i + stride : i];
+      buf[i] = order == 1 ? 0.5f * (next - prev) : next - 2.f * in[i] + prev;
+    }
+    return RES_OK;
+  }
+  /** @endcond */
+
+  /**
+   * recursiveGaussianFilter() - Recursive Gaussian filter
+   *
+   * Gaussian filter of standard deviation @b sigma, in 2D or 3D, computed by
+   * the recursive approximation of Young and van Vliet. Image borders are
+   * replicated.
+   *
+   * @note
+   * The cost doesn't depend on @b sigma, unlike gaussianFilter() whose
+   * kernel grows with the radius. Values are filtered in float and lines are
+   * processed by blocks of neighbour columns.
+   *
+   * @see
+   * - I.T. Young and L.J. van Vliet, <i>Recursive implementation of the
+   *   Gaussian filter</i>, Signal Processing, 1995
+   * - B. Triggs and M. Sdika, <i>Boundary conditions for Young - van Vliet
+   *   recursive filtering</i>, IEEE Trans. on Signal Processing, 2006
+   *
+   * @param[in] imIn : input image
+   * @param[in] sigma : standard deviation of the Gaussian (at least 0.5)
+   * @param[out] imOut : output image
+   */
+  template <class T>
+  RES_T recursiveGaussianFilter(const Image<T> &imIn, double sigma,
+                                Image<T> &imOut)
+  {
+    ASSERT_ALLOCATED(&imIn, &imOut);
+    ASSERT_SAME_SIZE(&imIn, &imOut);
+
+    std::vector<float> buf;
+    ASSERT(recursiveGaussianBuffer(imIn, sigma, 0, 0, buf) == RES_OK);
+
+    ImageFreezer freeze(imOut);
+
+    typename ImDtTypes<T>::lineType pixels = imOut.getPixels();
+    for (size_t i = 0; i < buf.size(); i++)
+      pixels[i] = recursiveGaussianCast<T>(buf[i]);
+
+    return RES_OK;
+  }
+
+  /**
+   * recursiveGaussianDerivative() - Recursive Gaussian derivative filter
+   *
+   * First or second derivative along one axis of the image filtered by
+   * recursiveGaussianFilter(), computed by finite differences. For large
+   * values of @b sigma, this is close to the convolution by the derivative of
+   * the Gaussian.
+   *
+   * Derivatives are signed : the output image should be of a signed or
+   * floating point type. Other types are saturated.
+   *
+   * @param[in] imIn : input image
+   * @param[in] sigma : standard deviation of the Gaussian (at least 0.5)
+   * @param[in] axis : derivation axis (@b 0, @b 1 or @b 2 for x, y or z)
+   * @param[in] order : derivation order (@b 1 or @b 2)
+   * @param[out] imOut : output image
+   */
+  template <class T1, class T2>
+  RES_T recursiveGaussianDerivative(const Image<T1> &imIn, double sigma,
+                                    int axis, int order, Image<T2> &imOut)
+  {
+    ASSERT_ALLOCATED(&imIn, &imOut);
+    ASSERT_SAME_SIZE(&imIn, &imOut);
+    ASSERT(order == 1 || order == 2, "order must be 1 or 2", RES_ERR);
+
+    std::vector<float> buf;
+    ASSERT(recursiveGaussianBuffer(imIn, sigma, axis, order, buf) == RES_OK);
+
+    ImageFreezer freeze(imOut);
+
+    typename ImDtTypes<T2>::lineType pixels = imOut.getPixels();
+    for (size_t i = 0; i < buf.size(); i++)
+      pixels[i] = recursiveGaussianCast<T2>(buf[i]);
+
+    return RES_OK;
+  }
+
   /** @cond */
   /**
    * 2D Gaussian filter
@@ -300,6 +582,157 @@ namespace smil
   }
   /** @endcond */
 
+  /** @cond */
+  /*
+   * Fixed point copy of a kernel for 8 bits images : weights are rounded to
+   * multiples of 2^-shift, shift being as large as 32 bits accumulators
+   * allow. Returns false when this leaves less than 16 bits of precision.
+   */
+  inline bool fixedPointKernel(const std::vector<double> &kernel,
+                               std::vector<INT32> &fixedKernel, int &shift)
+  {
+    double absSum = 0.;
+    for (size_t i = 0; i < kernel.size(); i++)
+      absSum += std::abs(kernel[i]);
+
+    // Sums of 8 bits values must stay below 2^30
+    for (shift = 22; shift >= 16; shift--)
+      if (absSum * std::ldexp(1., shift + 8) < std::ldexp(1., 30))
+        break;
+    if (shift < 16)
+      return false;
+
+    fixedKernel.resize(kernel.size());
+    for (size_t i = 0; i < kernel.size(); i++)
+      fixedKernel[i] = INT32(std::floor(std::ldexp(kernel[i], shift) + 0.5));
+    return true;
+  }
+
+  template <class T>
+  ENABLE_IF(std::numeric_limits<T>::is_integer && sizeof(T) == 1, bool)
+  fixedPointKernel(const T *, const std::vector<double> &kernel,
+                   std::vector<INT32> &fixedKernel, int &shift)
+  {
+    return fixedPointKernel(kernel, fixedKernel, shift);
+  }
+
+  template <class T>
+  ENABLE_IF(!(std::numeric_limits<T>::is_integer && sizeof(T) == 1), bool)
+  fixedPointKernel(const T *, const std::vector<double> &, std::vector<INT32> &,
+                   int &)
+  {
+    return false;
+  }
+
+  /*
+   * Value of a fixed point sum, truncated toward zero as the floating point
+   * one, and saturated
+   */
+  template <class T>
+  inline T fixedPointValue(INT32 sum, int shift)
+  {
+    INT32 v = sum >= 0 ? sum >> shift : -((-sum) >> shift);
+    v       = std::max<INT32>(v, INT32(ImDtTypes<T>::min()));
+    return T(std::min<INT32>(v, INT32(ImDtTypes<T>::max())));
+  }
+
+  /*
+   * Convolution across rows : the row y of out is the weighted sum of the
+   * rows y - radius to y + radius of in. Rows are nRows lines of rowLen
+   * values, rowStride apart. Inner loops run along the rows, over contiguous
+   * values. Border rows are normalized by the weight of the kernel part
+   * inside the image.
+   */
+  template <class T>
+  void convolveRows(const T *in, T *out, size_t rowLen, size_t nRows,
+                    size_t rowStride, const std::vector<double> &kernel)
+  {
+    int r = (kernel.size() - 1) / 2;
+
+    std::vector<double> partialKernWeights(r + 1);
+    double              pkwSum = 0;
+    for (int i = 0; i < r; i++)
+      pkwSum += kernel[i];
+    for (int i = 0; i < r; i++) {
+      pkwSum += kernel[i + r];
+      partialKernWeights[i] = pkwSum;
+    }
+
+    std::vector<INT32> fixedKernel;
+    int                shift = 0;
+    bool fixedPoint = fixedPointKernel(in, kernel, fixedKernel, shift);
+
+    // Rows are split into chunks, so that a few long rows keep all threads
+    // busy
+    const size_t chunkLen = 4096;
+    size_t       nChunks  = (rowLen + chunkLen - 1) / chunkLen;
+    size_t       nTasks   = nRows * nChunks;
+
+#ifdef USE_OPEN_MP
+    int nthreads = Core::getInstance()->getNumberOfThreads();
+#pragma omp parallel num_threads(nthreads)
+#endif // USE_OPEN_MP
+    {
+      std::vector<double> sum(chunkLen);
+      std::vector<INT32>  fixedSum(chunkLen);
+
+#ifdef USE_OPEN_MP
+#pragma omp for
+#endif // USE_OPEN_MP
+      for (size_t t = 0; t < nTasks; t++) {
+        int    y     = int(t / nChunks);
+        size_t first = (t % nChunks) * chunkLen;
+        size_t len   = std::min(chunkLen, rowLen - first);
+        int    iBeg  = std::max(-r, -y);
+        int    iEnd  = std::min(r, int(nRows) - 1 - y);
+        T     *lOut  = out + y * rowStride + first;
+
+        if (fixedPoint && iBeg == -r && iEnd == r) {
+          for (size_t x = 0; x < len; x++)
+            fixedSum[x] = 0;
+          for (int i = -r; i <= r; i++) {
+            INT32    k   = fixedKernel[i + r];
+            const T *lIn = in + (y + i) * rowStride + first;
+            for (size_t x = 0; x < len; x++)
+              fixedSum[x] += k * INT32(lIn[x]);
+          }
+          for (size_t x = 0; x < len; x++)
+            lOut[x] = fixedPointValue<T>(fixedSum[x], shift);
+          continue;
+        }
+
+        for (size_t x = 0; x < len; x++)
+          sum[x] = 0;
+        for (int i = iBeg; i <= iEnd; i++) {
+          double   k   = kernel[i + r];
+          const T *lIn = in + (y + i) * rowStride + first;
+          for (size_t x = 0; x < len; x++)
+            sum[x] += k * lIn[x];
+        }
+
+        double weight = 1.;
+        if (iBeg > -r && iEnd < r) {
+          weight = 0.;
+          for (int i = iBeg; i <= iEnd; i++)
+            weight += kernel[i + r];
+        } else if (iBeg > -r) {
+          weight = partialKernWeights[y];
+        } else if (iEnd < r) {
+          weight = partialKernWeights[nRows - 1 - y];
+        }
+
+        if (weight == 1.) {
+          for (size_t x = 0; x < len; x++)
+            lOut[x] = T(sum[x]);
+        } else {
+          for (size_t x = 0; x < len; x++)
+            lOut[x] = T(sum[x] / weight);
+        }
+      }
+    }
+  }
+  /** @endcond */
+
   /**
    * horizConvolve() - 2D Horizontal convolution
    *
@@ -322,6 +755,14 @@ namespace smil
    * im2.show()
    *
    * @endcode
+   *
+   * @note
+   * On 8 bits images, weights are rounded to fixed point and sums are
+   * computed with 32 bits integers, except near the image borders. With
+   * weights whose absolute values sum up to 1, sums differ from floating
+   * point ones by less than <b>kernel.size() * 2^-14</b> before truncation,
+   * so results only differ by one when the exact sum is that close to an
+   * integer.
    */
   // Inplace safe
   template <class T>
@@ -353,6 +794,10 @@ namespace smil
     typedef double      bufType; // If float, loops are vectorized
     BufferPool<bufType> bufferPool(imW);
 
+    std::vector<INT32> fixedKernel;
+    int                shift = 0;
+    bool fixedPoint = fixedPointKernel(linesIn[0], kernel, fixedKernel, shift);
+
 #ifdef USE_OPEN_MP
     int nthreads = Core::getInstance()->getNumberOfThreads();
 #pragma omp parallel private(lOut) num_threads(nthreads)
@@ -360,6 +805,7 @@ namespace smil
     {
       typename ImDtTypes<bufType>::lineType lIn = bufferPool.getBuffer();
       double                                sum;
+      std::vector<INT32> fixedIn(fixedPoint ? imW : 0), fixedSum(fixedIn);
 
 #ifdef USE_OPEN_MP
 #pragma omp for
@@ -368,6 +814,20 @@ namespace smil
         copyLine<T, bufType>(linesIn[y], imW, lIn);
         lOut = linesOut[y];
 
+        // center pixels, in fixed point
+        if (fixedPoint && imW > 2 * kernelRadius) {
+          for (int x = 0; x < imW; x++) {
+            fixedIn[x]  = INT32(linesIn[y][x]);
+            fixedSum[x] = 0;
+          }
+          INT32 *fIn = &fixedIn[0], *fSum = &fixedSum[0];
+          for (int i = -kernelRadius; i <= kernelRadius; i++) {
+            INT32 k = fixedKernel[i + kernelRadius];
+            for (int x = kernelRadius; x < imW - kernelRadius; x++)
+              fSum[x] += k * fIn[x + i];
+          }
+        }
+
         // left pixels
         for (int x = 0; x < kernelRadius; x++) {
           sum = 0;
@@ -377,11 +837,16 @@ namespace smil
         }
 
         // center pixels
-        for (int x = kernelRadius; x < imW - kernelRadius; x++) {
-          sum = 0;
-          for (int i = -kernelRadius; i <= kernelRadius; i++)
-            sum += kernel[i + kernelRadius] * lIn[x + i];
-          lOut[x] = T(sum);
+        if (fixedPoint) {
+          for (int x = kernelRadius; x < imW - kernelRadius; x++)
+            lOut[x] = fixedPointValue<T>(fixedSum[x], shift);
+        } else {
+          for (int x = kernelRadius; x < imW - kernelRadius; x++) {
+            sum = 0;
+            for (int i = -kernelRadius; i <= kernelRadius; i++)
+              sum += kernel[i + kernelRadius] * lIn[x + i];
+            lOut[x] = T(sum);
+          }
         }
 
         // right pixels
@@ -412,73 +877,59 @@ namespace smil
   RES_T vertConvolve(const Image<T> &imIn, const std::vector<double> &kernel,
                      Image<T> &imOut)
   {
+    if (&imIn == &imOut) {
+      Image<T> tmpIm(imIn, true); // clone
+      return vertConvolve(tmpIm, kernel, imOut);
+    }
+
     CHECK_ALLOCATED(&imIn, &imOut);
     CHECK_SAME_SIZE(&imIn, &imOut);
 
     ImageFreezer freeze(imOut);
 
-    typename ImDtTypes<T>::volType   slicesIn  = imIn.getSlices();
-    typename ImDtTypes<T>::volType   slicesOut = imOut.getSlices();
-    typename ImDtTypes<T>::sliceType sIn, sOut;
+    size_t imW = imIn.getWidth();
+    size_t imH = imIn.getHeight();
+    size_t imD = imIn.getDepth();
 
-    int imW          = imIn.getWidth();
-    int imH          = imIn.getHeight();
-    int imD          = imIn.getDepth();
-    int kernelRadius = (kernel.size() - 1) / 2;
+    typename ImDtTypes<T>::lineType pixelsIn  = imIn.getPixels();
+    typename ImDtTypes<T>::lineType pixelsOut = imOut.getPixels();
 
-    double *partialKernWeights = new double[kernelRadius];
-    double  pkwSum             = 0;
-    for (int i = 0; i < kernelRadius; i++)
-      pkwSum += kernel[i];
-    for (int i = 0; i < kernelRadius; i++) {
-      pkwSum += kernel[i + kernelRadius];
-      partialKernWeights[i] = pkwSum;
-    }
+    for (size_t z = 0; z < imD; z++)
+      convolveRows(pixelsIn + z * imW * imH, pixelsOut + z * imW * imH, imW,
+                   imH, imW, kernel);
 
-    typedef double      bufType; // If double, loops are vectorized
-    BufferPool<bufType> bufferPool(imW);
+    return RES_OK;
+  }
 
-    for (int z = 0; z < imD; z++) {
-#ifdef USE_OPEN_MP
-      int nthreads = Core::getInstance()->getNumberOfThreads();
-#pragma omp parallel private(sIn, sOut) num_threads(nthreads)
-#endif // USE_OPEN_MP
-      {
-        sIn  = slicesIn[z];
-        sOut = slicesOut[z];
-        double sum;
+  /**
+   * depthConvolve() - 3D Depth convolution
+   *
+   * 3D convolution along the z axis using a @TB{1D kernel}
+   *
+   * @param[in] imIn : input image
+   * @param[in] kernel : an <b>1D kernel</b> (vector)
+   * @param[out] imOut : output image
+   *
+   * @see horizConvolve()
+   */
+  template <class T>
+  RES_T depthConvolve(const Image<T> &imIn, const std::vector<double> &kernel,
+                      Image<T> &imOut)
+  {
+    if (&imIn == &imOut) {
+      Image<T> tmpIm(imIn, true); // clone
+      return depthConvolve(tmpIm, kernel, imOut);
+    }
 
-#ifdef USE_OPEN_MP
-#pragma omp for
-#endif // USE_OPEN_MP
-        for (int x = 0; x < imW; x++) {
-          // Top pixels
-          for (int y = 0; y < kernelRadius; y++) {
-            sum = 0;
-            for (int i = -y; i < kernelRadius + 1; i++)
-              sum += kernel[i + kernelRadius] * sIn[y + i][x];
-            sOut[y][x] = T(sum / partialKernWeights[y]);
-          }
+    CHECK_ALLOCATED(&imIn, &imOut);
+    CHECK_SAME_SIZE(&imIn, &imOut);
 
-          // Center pixels
-          for (int y = kernelRadius; y < imH - kernelRadius; y++) {
-            sum = 0;
-            for (int i = -kernelRadius; i <= kernelRadius; i++)
-              sum += kernel[i + kernelRadius] * sIn[y + i][x];
-            sOut[y][x] = T(sum);
-          }
+    ImageFreezer freeze(imOut);
+
+    size_t sliceLen = imIn.getWidth() * imIn.getHeight();
+    convolveRows(imIn.getPixels(), imOut.getPixels(), sliceLen,
+                 imIn.getDepth(), sliceLen, kernel);
 
-          // Bottom pixels
-          for (int y = imH - kernelRadius; y < imH; y++) {
-            sum = 0;
-            for (int i = -kernelRadius; i < imH - y; i++)
-              sum += kernel[i + kernelRadius] * sIn[y + i][x];
-            sOut[y][x] = T(sum / partialKernWeights[imH - 1 - y]);
-          }
-        }
-      }
-    }
-    delete[] partialKernWeights;
     return RES_OK;
   }
 
@@ -53,6 +53,123 @@ namespace smil
    * thresholding
    */
 
+  /** @cond */
+  /*
+   * Bin of the pixel i of an image, bin 0 holding the value minV
+   */
+  template <class T>
+  struct HistogramBin {
+    HistogramBin(const T *p, const T &m) : pixels(p), minV(m)
+    {
+    }
+    size_t operator()(size_t i) const
+    {
+      return size_t(pixels[i] - minV);
+    }
+    const T *pixels;
+    T        minV;
+  };
+
+  /*
+   * Bin of the pair of values of the pixel i in two images
+   */
+  template <class T1, class T2>
+  struct JointHistogramBin {
+    JointHistogramBin(const T1 *p1, const T2 *p2)
+        : pixels1(p1), pixels2(p2), card2(ImDtTypes<T2>::cardinal())
+    {
+    }
+    size_t operator()(size_t i) const
+    {
+      return size_t(pixels1[i] - ImDtTypes<T1>::min()) * card2 +
+             size_t(pixels2[i] - ImDtTypes<T2>::min());
+    }
+    const T1 *pixels1;
+    const T2 *pixels2;
+    size_t    card2;
+  };
+
+  /*
+   * Counts of the nPixels bins given by bin in h[0, card), only where mask
+   * isn't zero when mask isn't NULL.
+   *
+   * Each thread counts its own part of the image in private bins, which are
+   * summed at the end. For small ranges, each thread has several interleaved
+   * copies of its bins, so that runs of equal pixels don't wait on the same
+   * counter.
+   */
+  template <class binT, class maskT>
+  void histogramCounts(const binT &bin, const maskT *mask, size_t nPixels,
+                       size_t card, size_t *h)
+  {
+    const size_t nCopies = card <= 1024 ? 4 : 1;
+
+    int nthreads = 1;
+#ifdef USE_OPEN_MP
+    // Don't spend more time clearing and summing bins than counting pixels
+    nthreads        = Core::getInstance()->getNumberOfThreads();
+    size_t nThreads = std::max<size_t>(nPixels / (4 * nCopies * card), 1);
+    if (size_t(nthreads) > nThreads)
+      nthreads = int(nThreads);
+#endif // USE_OPEN_MP
+
+    std::vector<size_t> bins(nthreads * nCopies * card, 0);
+
+#ifdef USE_OPEN_MP
+#pragma omp parallel num_threads(nthreads)
+#endif // USE_OPEN_MP
+    {
+      int tid = 0;
+#ifdef USE_OPEN_MP
+      tid = omp_get_thread_num();
+#endif // USE_OPEN_MP
+      size_t lBeg = nPixels * tid / nthreads;
+      size_t lEnd = nPixels * (tid + 1) / nthreads;
+
+      size_t *b0 = &bins[tid * nCopies * card];
+      size_t  i  = lBeg;
+
+      if (nCopies == 4) {
+        size_t *b1 = b0 + card, *b2 = b1 + card, *b3 = b2 + card;
+        if (mask == NULL) {
+          for (; i + 4 <= lEnd; i += 4) {
+            b0[bin(i)]++;
+            b1[bin(i + 1)]++;
+            b2[bin(i + 2)]++;
+            b3[bin(i + 3)]++;
+          }
+        } else {
+          for (; i + 4 <= lEnd; i += 4) {
+            b0[bin(i)] += mask[i] != 0;
+            b1[bin(i + 1)] += mask[i + 1] != 0;
+            b2[bin(i + 2)] += mask[i + 2] != 0;
+            b3[bin(i + 3)] += mask[i + 3] != 0;
+          }
+        }
+      }
+      if (mask == NULL) {
+        for (; i < lEnd; i++)
+          b0[bin(i)]++;
+      } else {
+        for (; i < lEnd; i++)
+          if (mask[i] != 0)
+            b0[bin(i)]++;
+      }
+    }
+
+    size_t nBins = nthreads * nCopies;
+#ifdef USE_OPEN_MP
+#pragma omp parallel for num_threads(nthreads)
+#endif // USE_OPEN_MP
+    for (size_t k = 0; k < card; k++) {
+      size_t count = 0;
+      for (size_t c = 0; c < nBins; c++)
+        count += bins[c * card + k];
+      h[k] = count;
+    }
+  }
+  /** @endcond */
+
 #ifndef SWIG
   /**
    * Image histogram
@@ -68,12 +185,9 @@ namespace smil
   ENABLE_IF(!IS_FLOAT(T), RES_T)
   histogram(const Image<T> &imIn, size_t *h)
   {
-    for (size_t i = 0; i < ImDtTypes<T>::cardinal(); i++)
-      h[i] = 0;
-
-    typename Image<T>::lineType pixels = imIn.getPixels();
-    for (size_t i = 0; i < imIn.getPixelCount(); i++)
-      h[size_t(pixels[i] - ImDtTypes<T>::min())]++;
+    histogramCounts(HistogramBin<T>(imIn.getPixels(), ImDtTypes<T>::min()),
+                    (T *) NULL, imIn.getPixelCount(), ImDtTypes<T>::cardinal(),
+                    h);
 
     return RES_OK;
   }
@@ -101,15 +215,67 @@ namespace smil
   {
     ASSERT(haveSameSize(&imIn, &imMask, NULL));
 
-    for (size_t i = 0; i < ImDtTypes<T>::cardinal(); i++)
-      h[i] = 0;
+    histogramCounts(HistogramBin<T>(imIn.getPixels(), ImDtTypes<T>::min()),
+                    imMask.getPixels(), imIn.getPixelCount(),
+                    ImDtTypes<T>::cardinal(), h);
 
-    typename Image<T>::lineType pixels  = imIn.getPixels();
-    typename Image<T>::lineType maskPix = imMask.getPixels();
+    return RES_OK;
+  }
+
+  /**
+   * Joint histogram of two images
+   *
+   * Counts the pairs of values taken by the same pixel in both images.
+   *
+   * @param[in] imIn1 : first input image
+   * @param[in] imIn2 : second input image
+   * @param[out] h : dense array of <b>cardinal(T1) * cardinal(T2)</b> counts.
+   * The count of the pair <b>(v1, v2)</b> is at <b>(v1 - min(T1)) *
+   * cardinal(T2) + v2 - min(T2)</b>
+   *
+   * @note Available only in C++, and only for 8 bits images, larger types
+   * needing too many bins
+   */
+  template <class T1, class T2>
+  ENABLE_IF(sizeof(T1) == 1 && sizeof(T2) == 1, RES_T)
+  jointHistogram(const Image<T1> &imIn1, const Image<T2> &imIn2, size_t *h)
+  {
+    ASSERT(haveSameSize(&imIn1, &imIn2, NULL));
+
+    histogramCounts(
+        JointHistogramBin<T1, T2>(imIn1.getPixels(), imIn2.getPixels()),
+        (T1 *) NULL, imIn1.getPixelCount(),
+        ImDtTypes<T1>::cardinal() * ImDtTypes<T2>::cardinal(), h);
+
+    return RES_OK;
+  }
+
+  /**
+   * Joint histogram of two images with a mask image
+   *
+   * Counts the pairs of values taken by the same pixel in both images, in the
+   * region defined by the image mask.
+   *
+   * @param[in] imIn1 : first input image
+   * @param[in] imIn2 : second input image
+   * @param[in] imMask : image mask
+   * @param[out] h : dense array of <b>cardinal(T1) * cardinal(T2)</b> counts,
+   * as given by jointHistogram()
+   *
+   * @note Available only in C++, and only for 8 bits images, larger types
+   * needing too many bins
+   */
+  template <class T1, class T2>
+  ENABLE_IF(sizeof(T1) == 1 && sizeof(T2) == 1, RES_T)
+  jointHistogram(const Image<T1> &imIn1, const Image<T2> &imIn2,
+                 const Image<T1> &imMask, size_t *h)
+  {
+    ASSERT(haveSameSize(&imIn1, &imIn2, &imMask, NULL));
 
-    for (size_t i = 0; i < imIn.getPixelCount(); i++)
-      if (maskPix[i] != 0)
-        h[size_t(pixels[i] - ImDtTypes<T>::min())]++;
+    histogramCounts(
+        JointHistogramBin<T1, T2>(imIn1.getPixels(), imIn2.getPixels()),
+        imMask.getPixels(), imIn1.getPixelCount(),
+        ImDtTypes<T1>::cardinal() * ImDtTypes<T2>::cardinal(), h);
 
     return RES_OK;
   }
@@ -129,29 +295,24 @@ namespace smil
     std::vector<T> rVals = rangeVal(imIn);
     size_t         card  = rVals[1] - rVals[0] + 1;
 
-    size_t *buf = new size_t[card];
-    for (size_t i = 0; i < card; i++)
-      buf[i] = 0;
-
-    typename Image<T>::lineType pixels = imIn.getPixels();
-    for (size_t i = 0; i < imIn.getPixelCount(); i++)
-      buf[size_t(pixels[i] - rVals[0])]++;
+    std::vector<size_t> buf(card);
+    histogramCounts(HistogramBin<T>(imIn.getPixels(), rVals[0]), (T *) NULL,
+                    imIn.getPixelCount(), card, &buf[0]);
 
+    // Values come in increasing order : insert them at the end
     std::map<T, UINT> h;
 
     if (fullRange)
       for (T i = ImDtTypes<T>::min(); i < rVals[0]; i++)
-        h.insert(std::pair<T, UINT>(i, 0));
+        h.insert(h.end(), std::pair<T, UINT>(i, 0));
 
     for (size_t i = 0; i < card; i++)
-      h.insert(std::pair<T, UINT>(i + rVals[0], buf[i]));
+      h.insert(h.end(), std::pair<T, UINT>(i + rVals[0], buf[i]));
 
     if (fullRange)
       for (T i = rVals[1]; i <= ImDtTypes<T>::max() && i != ImDtTypes<T>::min();
            i++)
-        h.insert(std::pair<T, UINT>(i, 0));
-
-    delete[] buf;
+        h.insert(h.end(), std::pair<T, UINT>(i, 0));
 
     return h;
   }
@@ -179,32 +340,25 @@ namespace smil
     std::vector<T> rVals = rangeVal(imIn);
     size_t         card  = rVals[1] - rVals[0] + 1;
 
-    size_t *buf = new size_t[card];
-    for (size_t i = 0; i < card; i++)
-      buf[i] = 0;
-
-    typename Image<T>::lineType pixels     = imIn.getPixels();
-    typename Image<T>::lineType maskPixels = imMask.getPixels();
-    for (size_t i = 0; i < imIn.getPixelCount(); i++)
-      if (maskPixels[i] != 0)
-        buf[size_t(pixels[i] - rVals[0])]++;
+    std::vector<size_t> buf(card);
+    histogramCounts(HistogramBin<T>(imIn.getPixels(), rVals[0]),
+                    imMask.getPixels(), imIn.getPixelCount(), card, &buf[0]);
 
+    // Values come in increasing order : insert them at the end
     if (fullRange)
       for (T i = ImDtTypes<T>::min(); i < rVals[0]; i++)
-        h.insert(std::pair<T, UINT>(i, 0));
+        h.insert(h.end(), std::pair<T, UINT>(i, 0));
 
     for (size_t i = 0; i < card; i++)
-      h.insert(std::pair<T, UINT>(i + rVals[0], buf[i]));
+      h.insert(h.end(), std::pair<T, UINT>(i + rVals[0], buf[i]));
 
     if (fullRange) {
       T imin = ImDtTypes<T>::min();
       T imax = ImDtTypes<T>::max();
       for (T i = rVals[1]; i <= imax && i != imin; i++)
-        h.insert(std::pair<T, UINT>(i, 0));
+        h.insert(h.end(), std::pair<T, UINT>(i, 0));
     }
 
-    delete[] buf;
-
     return h;
   }
 
@@ -506,92 +660,52 @@ namespace smil
   }
 
   /** @cond */
-  template <class T>
-  bool IncrementThresholds(std::vector<double> &thresholdIndexes,
-                           std::map<T, UINT> &hist, UINT threshLevels,
-                           double totalFrequency, double &globalMean,
-                           std::vector<double> &classMean,
-                           std::vector<double> &classFrequency)
+  /*
+   * Between-class term S^2 / W of the bins [a, b), from the prefix sums of
+   * the histogram (W) and of the bin indexes weighted by the histogram (S).
+   */
+  inline double otsuClassTerm(const std::vector<double> &W,
+                              const std::vector<double> &S, size_t a, size_t b)
   {
-    unsigned long numberOfHistogramBins = hist.size();
-    unsigned long numberOfClasses       = classMean.size();
-
-    typedef double MeanType;
-    typedef double FrequencyType;
-
-    MeanType      meanOld;
-    FrequencyType freqOld;
-
-    unsigned int k;
-    int          j;
-
-    // from the upper threshold down
-    for (j = static_cast<int>(threshLevels - 1); j >= 0; j--) {
-      // if this threshold can be incremented (i.e. we're not at the end of the
-      // histogram)
-      if (thresholdIndexes[j] <
-          numberOfHistogramBins - 2 - (threshLevels - 1 - j)) {
-        // increment it and update mean and frequency of the class bounded by
-        // the threshold
-        thresholdIndexes[j] += 1;
-
-        meanOld = classMean[j];
-        freqOld = classFrequency[j];
-
-        classFrequency[j] += hist[UINT(thresholdIndexes[j])];
-
-        if (classFrequency[j] > 0) {
-          classMean[j] =
-              (meanOld * static_cast<MeanType>(freqOld) +
-               static_cast<MeanType>(thresholdIndexes[j]) *
-                   static_cast<MeanType>(hist[UINT(thresholdIndexes[j])])) /
-              static_cast<MeanType>(classFrequency[j]);
-        } else {
-          classMean[j] = 0;
-        }
-
-        // set higher thresholds adjacent to their previous ones, and update
-        // mean and frequency of the respective classes
-        for (k = j + 1; k < threshLevels; k++) {
-          thresholdIndexes[k] = thresholdIndexes[k - 1] + 1;
-          classFrequency[k]   = hist[UINT(thresholdIndexes[k])];
-          if (classFrequency[k] > 0) {
-            classMean[k] = static_cast<MeanType>(thresholdIndexes[k]);
-          } else {
-            classMean[k] = 0;
-          }
-        }
-
-        // update mean and frequency of the highest class
-        classFrequency[numberOfClasses - 1] = totalFrequency;
-        classMean[numberOfClasses - 1]      = globalMean * totalFrequency;
-
-        for (k = 0; k < numberOfClasses - 1; k++) {
-          classFrequency[numberOfClasses - 1] -= classFrequency[k];
-          classMean[numberOfClasses - 1] -=
-              classMean[k] * static_cast<MeanType>(classFrequency[k]);
-        }
-
-        if (classFrequency[numberOfClasses - 1] > 0) {
-          classMean[numberOfClasses - 1] /=
-              static_cast<MeanType>(classFrequency[numberOfClasses - 1]);
-        } else {
-          classMean[numberOfClasses - 1] = 0;
-        }
+    double w = W[b] - W[a];
+    if (w <= 0)
+      return 0.;
+    double s = S[b] - S[a];
+    return s * s / w;
+  }
 
-        // exit the for loop if a threshold has been incremented
-        break;
-      } else // if this threshold can't be incremented
-      {
-        // if it's the lowest threshold
-        if (j == 0) {
-          // we couldn't increment because we're done
-          return false;
-        }
+  /*
+   * One level of the multi-level Otsu dynamic programming : for each cut c
+   * in [cLo, cHi], best value of the classes following it, and the smallest
+   * next cut reaching it. Best next cuts don't decrease with c, so they are
+   * searched by divide and conquer.
+   */
+  inline void otsuLevel(const std::vector<double> &W,
+                        const std::vector<double> &S,
+                        const std::vector<double> &nextBest, size_t cLo,
+                        size_t cHi, size_t optLo, size_t optHi,
+                        std::vector<double> &best, std::vector<size_t> &opt)
+  {
+    if (cLo > cHi)
+      return;
+
+    size_t c     = cLo + (cHi - cLo) / 2;
+    size_t first = std::max(optLo, c + 1);
+    double bVal  = -1.;
+    size_t bOpt  = first;
+    for (size_t n = first; n <= optHi; n++) {
+      double v = otsuClassTerm(W, S, c, n) + nextBest[n];
+      if (v > bVal) {
+        bVal = v;
+        bOpt = n;
       }
     }
-    // we incremented
-    return true;
+    best[c] = bVal;
+    opt[c]  = bOpt;
+
+    if (c > cLo)
+      otsuLevel(W, S, nextBest, cLo, c - 1, optLo, bOpt, best, opt);
+    otsuLevel(W, S, nextBest, c + 1, cHi, bOpt, optHi, best, opt);
   }
   /** @endcond */
 
@@ -600,6 +714,12 @@ namespace smil
    * Return threshold values and the value of the resulting variance between
    * classes
    *
+   * @note
+   * Thresholds maximizing the variance between classes are found by dynamic
+   * programming on a dense copy of the histogram, in
+   * @f$ O(levels \cdot L \log L) @f$ for @f$ L @f$ histogram bins. Among
+   * equivalent solutions, the one with the lowest thresholds is returned.
+   *
    * @param[in] hist : image histogram
    * @param[in] threshLevels : number of threshold levels (default : @b 1)
    * @return vector with the threshold levels
@@ -608,88 +728,70 @@ namespace smil
   std::vector<T> otsuThresholdValues(std::map<T, UINT> &hist,
                                      UINT               threshLevels = 1)
   {
-    typedef double                MeanType;
-    typedef std::vector<MeanType> MeanVectorType;
+    std::vector<T> threshVals;
+    if (hist.empty() || threshLevels == 0)
+      return threshVals;
 
-    double   totalFrequency = 0;
-    MeanType globalMean     = 0;
+    // Dense histogram : bins are the values from min(0, lowest value)
+    double base = std::min(0., double(hist.begin()->first));
+    size_t k    = threshLevels;
+    size_t L    = size_t(double(hist.rbegin()->first) - base) + 1;
+    L           = std::max(L, k + 1);
 
+    std::vector<double> h(L, 0.);
     for (typename std::map<T, UINT>::iterator it = hist.begin();
-         it != hist.end(); it++) {
-      globalMean += double((*it).first) * double((*it).second);
-      totalFrequency += (*it).second;
-    }
+         it != hist.end(); it++)
+      h[size_t(double(it->first) - base)] += it->second;
 
-    globalMean /= totalFrequency;
-
-    unsigned long  numberOfClasses = threshLevels + 1;
-    MeanVectorType thresholdIndexes(threshLevels, 0);
-
-    for (unsigned long j = 0; j < threshLevels; j++) {
-      thresholdIndexes[j] = j;
-    }
-
-    MeanVectorType maxVarThresholdIndexes = thresholdIndexes;
-    double         freqSum                = 0;
-    MeanVectorType classFrequency(numberOfClasses, 0);
-
-    for (unsigned long j = 0; j < numberOfClasses - 1; j++) {
-      classFrequency[j] = hist[T(thresholdIndexes[j])];
-      freqSum += classFrequency[j];
+    std::vector<double> W(L + 1, 0.), S(L + 1, 0.);
+    for (size_t i = 0; i < L; i++) {
+      W[i + 1] = W[i] + h[i];
+      S[i + 1] = S[i] + double(i) * h[i];
     }
 
-    classFrequency[numberOfClasses - 1] = totalFrequency - freqSum;
-
-    double         meanSum = 0;
-    MeanVectorType classMean(numberOfClasses, 0);
-
-    for (unsigned long j = 0; j < numberOfClasses - 1; j++) {
-      if (classFrequency[j] > 0) {
-        classMean[j] = j;
-      } else {
-        classMean[j] = 0;
+    // Class j holds the bins [c(j-1), c(j)), with c(-1) = 0 and c(k) = L.
+    // best[j][c] is the best value of the classes following the cut c(j) = c
+    std::vector<std::vector<double>> best(k, std::vector<double>(L + 1, 0.));
+    std::vector<std::vector<size_t>> opt(k, std::vector<size_t>(L + 1, L));
+
+    for (size_t c = k; c <= L - 1; c++)
+      best[k - 1][c] = otsuClassTerm(W, S, c, L);
+    for (size_t j = k - 1; j-- > 0;)
+      otsuLevel(W, S, best[j + 1], j + 1, L - k + j, j + 2, L - k + j + 1,
+                best[j], opt[j]);
+
+    double bVal = -1.;
+    size_t cut  = 1;
+    for (size_t c = 1; c <= L - k; c++) {
+      double v = otsuClassTerm(W, S, 0, c) + best[0][c];
+      if (v > bVal) {
+        bVal = v;
+        cut  = c;
       }
-      meanSum += classMean[j] * classFrequency[j];
-    }
-
-    if (classFrequency[numberOfClasses - 1] > 0) {
-      classMean[numberOfClasses - 1] =
-          double(globalMean * totalFrequency - meanSum) /
-          double(classFrequency[numberOfClasses - 1]);
-    } else {
-      classMean[numberOfClasses - 1] = 0;
-    }
-
-    double maxVarBetween = 0;
-    for (unsigned long j = 0; j < numberOfClasses; j++) {
-      maxVarBetween += classFrequency[j] * (globalMean - classMean[j]) *
-                       (globalMean - classMean[j]);
     }
 
-    // explore all possible threshold configurations and choose the one that
-    // yields maximum between-class variance
-    while (IncrementThresholds(thresholdIndexes, hist, threshLevels,
-                               totalFrequency, globalMean, classMean,
-                               classFrequency)) {
-      double varBetween = 0;
-      for (unsigned long j = 0; j < numberOfClasses; j++) {
-        varBetween += classFrequency[j] * (globalMean - classMean[j]) *
-                      (globalMean - classMean[j]);
-      }
-
-      if (varBetween > maxVarBetween) {
-        maxVarBetween          = varBetween;
-        maxVarThresholdIndexes = thresholdIndexes;
-      }
+    std::vector<size_t> cuts;
+    for (size_t j = 0; j < k; j++) {
+      cuts.push_back(cut);
+      threshVals.push_back(T(base + double(cut - 1)));
+      cut = opt[j][cut];
     }
+    cuts.push_back(L);
 
-    std::vector<T> threshVals;
-
-    for (unsigned long j = 0; j < threshLevels; j++) {
-      threshVals.push_back(T(maxVarThresholdIndexes[j]));
-      //= histogram->GetBinMax(0,maxVarThresholdIndexes[j]);
+    // Variance between classes, as a sum over the classes
+    double globalMean = 0.;
+    for (typename std::map<T, UINT>::iterator it = hist.begin();
+         it != hist.end(); it++)
+      globalMean += double(it->first) * double(it->second);
+    globalMean /= W[L];
+
+    double varBetween = 0.;
+    for (size_t j = 0, prev = 0; j <= k; prev = cuts[j++]) {
+      double w    = W[cuts[j]] - W[prev];
+      double mean = w > 0 ? (S[cuts[j]] - S[prev]) / w + base : 0.;
+      varBetween += w * (globalMean - mean) * (globalMean - mean);
     }
-    threshVals.push_back(maxVarBetween);
+    threshVals.push_back(varBetween);
 
     return threshVals;
   }
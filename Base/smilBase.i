@@ -27,11 +27,27 @@
 
 
 
+%{
+#if defined(SWIGPYTHON) && defined(USE_NUMPY)
+// include numpy at the top of the CXX wrapper file
+#define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
+#include <numpy/arrayobject.h>
+#endif
+%}
+
 %include smilCommon.i
 %include <std_container.i>
 
 SMIL_MODULE(smilBase)
 
+#if defined SWIGPYTHON && defined USE_NUMPY && !defined SWIGIMPORTED
+%init
+%{
+  // Required by BlobMeasureTable::getNumpyArray()
+  _import_array();
+%}
+#endif // defined SWIGPYTHON && defined USE_NUMPY && !defined SWIGIMPORTED
+
 
 //////////////////////////////////////////////////////////
 // Functions
@@ -158,7 +174,10 @@ TEMPLATE_WRAP_FUNC_2T_CROSS(otsuThreshold);
 TEMPLATE_WRAP_FUNC(horizConvolve);
 TEMPLATE_WRAP_FUNC(vertConvolve);
 TEMPLATE_WRAP_FUNC(convolve);
+TEMPLATE_WRAP_FUNC(depthConvolve);
 TEMPLATE_WRAP_FUNC(gaussianFilter);
+TEMPLATE_WRAP_FUNC(recursiveGaussianFilter);
+TEMPLATE_WRAP_FUNC_2T_CROSS(recursiveGaussianDerivative);
 
 TEMPLATE_WRAP_FUNC(drawLine);
 TEMPLATE_WRAP_FUNC(drawRectangle);
@@ -269,6 +288,8 @@ TEMPLATE_WRAP_FUNC_2T_CROSS(blobsBarycenter);
 TEMPLATE_WRAP_FUNC_2T_CROSS(blobsBoundBox);
 TEMPLATE_WRAP_FUNC_2T_CROSS(blobsMoments);
 TEMPLATE_WRAP_FUNC_2T_CROSS(blobsEntropy);
+TEMPLATE_WRAP_FUNC(blobsMeasureTable);
+TEMPLATE_WRAP_FUNC_2T_CROSS(blobsMeasureTable);
 
 %include "DBlobOperations.hpp"
 //TEMPLATE_WRAP_FUNC_2T_CROSS(areaThreshold);
@@ -293,5 +314,4 @@ TEMPLATE_WRAP_FUNC(indexFallOut);
 TEMPLATE_WRAP_FUNC(indexMissRate);
 TEMPLATE_WRAP_FUNC(indexOverlap);
 TEMPLATE_WRAP_FUNC(distanceHamming);
-TEMPLATE_WRAP_FUNC(distanceHausdorff);
 
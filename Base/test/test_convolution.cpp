@@ -93,6 +93,34 @@ class Test_ConvolVert : public TestCase
   }
 };
 
+class Test_DepthConvolve : public TestCase
+{
+  virtual void run()
+  {
+    Image<UINT8> im1(2, 1, 5);
+    Image<UINT8> im2(im1);
+    Image<UINT8> im3(im1);
+
+    UINT8 vec1[] = {10, 10, 20, 20, 40, 40, 80, 80, 160, 160};
+    im1 << vec1;
+
+    UINT8 vecTruth[] = {13, 13, 22, 22, 45, 45, 90, 90, 133, 133};
+    im3 << vecTruth;
+
+    double         kern[] = {0.25, 0.5, 0.25};
+    vector<double> kernel(kern, kern + 3);
+    depthConvolve(im1, kernel, im2);
+    TEST_ASSERT(im2 == im3);
+
+    // In place
+    depthConvolve(im1, kernel, im1);
+    TEST_ASSERT(im1 == im3);
+
+    if (retVal != RES_OK)
+      im2.printSelf(1);
+  }
+};
+
 class Test_GaussianFilter : public TestCase
 {
   virtual void run()
@@ -134,13 +162,160 @@ class Test_GaussianFilter : public TestCase
   }
 };
 
+class Test_RecursiveGaussianFilter : public TestCase
+{
+  virtual void run()
+  {
+    // Constant images are unchanged, borders included
+    Image<UINT8> im1(40, 30, 5);
+    Image<UINT8> im2(im1);
+    fill(im1, UINT8(100));
+    recursiveGaussianFilter(im1, 10., im2);
+    TEST_ASSERT(minVal(im2) == 100 && maxVal(im2) == 100);
+
+    // Impulse response : symmetric, close to a Gaussian
+    Image<float> imF(121, 121);
+    Image<float> imG(imF);
+    fill(imF, 0.f);
+    imF.setPixel(60, 60, 1.f);
+    recursiveGaussianFilter(imF, 10., imG);
+
+    double g0 = 1. / (2 * M_PI * 100.);
+    TEST_ASSERT(std::abs(imG.getPixel(60, 60) - g0) < 0.03 * g0);
+    TEST_ASSERT(std::abs(imG.getPixel(50, 60) - imG.getPixel(70, 60)) <
+                1e-3 * g0);
+    TEST_ASSERT(std::abs(imG.getPixel(60, 50) - imG.getPixel(50, 60)) <
+                1e-3 * g0);
+
+    // Derivatives of a ramp
+    Image<float> imR(200, 20);
+    Image<float> imD(imR);
+    for (int y = 0; y < 20; y++)
+      for (int x = 0; x < 200; x++)
+        imR.setPixel(x, y, 3.f * x);
+
+    recursiveGaussianDerivative(imR, 5., 0, 1, imD);
+    TEST_ASSERT(std::abs(imD.getPixel(100, 10) - 3.f) < 1e-2);
+    recursiveGaussianDerivative(imR, 5., 0, 2, imD);
+    TEST_ASSERT(std::abs(imD.getPixel(100, 10)) < 1e-2);
+    recursiveGaussianDerivative(imR, 5., 1, 1, imD);
+    TEST_ASSERT(std::abs(imD.getPixel(100, 10)) < 1e-2);
+
+    // Null along axes of size 1
+    Image<float> imZero(imR);
+    fill(imZero, 0.f);
+    recursiveGaussianDerivative(imR, 5., 2, 1, imD);
+    TEST_ASSERT(equ(imD, imZero));
+
+    Image<float> imL(200, 1);
+    Image<float> imLD(imL);
+    copy(imR, 0, 10, 0, 200, 1, 1, imL);
+    recursiveGaussianDerivative(imL, 5., 1, 2, imLD);
+    imZero.setSize(imL);
+    fill(imZero, 0.f);
+    TEST_ASSERT(equ(imLD, imZero));
+
+    if (retVal != RES_OK) {
+      cout << imG.getPixel(60, 60) << " " << g0 << endl;
+      cout << imD.getPixel(100, 10) << endl;
+    }
+  }
+};
+
+/*
+ * Floating point convolution along one axis, border values being normalized
+ * by the weight of the kernel part inside the image
+ */
+static UINT8 convolveRef(const Image<UINT8> &im, const vector<double> &kernel,
+                         int axis, size_t x, size_t y, size_t z)
+{
+  size_t size[3] = {im.getWidth(), im.getHeight(), im.getDepth()};
+  size_t pos[3]  = {x, y, z};
+  int    r       = (kernel.size() - 1) / 2;
+  double sum = 0., weight = 0.;
+  for (int i = -r; i <= r; i++) {
+    int p = int(pos[axis]) + i;
+    if (p < 0 || p >= int(size[axis]))
+      continue;
+    size_t q[3] = {x, y, z};
+    q[axis]     = p;
+    sum += kernel[i + r] * im.getPixel(q[0], q[1], q[2]);
+    weight += kernel[i + r];
+  }
+  if (pos[axis] >= size_t(r) && pos[axis] + r < size[axis])
+    weight = 1.;
+  return UINT8(min(sum / weight, 255.));
+}
+
+/*
+ * Fixed point sums of 8 bits images differ by at most one from floating
+ * point ones, borders included
+ */
+class Test_FixedPointConvolve : public TestCase
+{
+  virtual void run()
+  {
+    Image<UINT8> imIn(61, 47, 29);
+    Image<UINT8> imOut(imIn);
+    UINT8       *pixels = imIn.getPixels();
+    srand(11);
+    for (size_t i = 0; i < imIn.getPixelCount(); i++)
+      pixels[i] = UINT8(rand() % 256);
+
+    // Gaussian kernels, and a flat one whose sums are often integers
+    vector<vector<double>> kernels;
+    double                 sigmas[] = {0.5, 1., 2.5, 4.};
+    for (int s = 0; s < 4; s++) {
+      int            r = int(ceil(3 * sigmas[s]));
+      vector<double> kernel(2 * r + 1);
+      double         sum = 0.;
+      for (int i = -r; i <= r; i++)
+        sum += kernel[i + r] = exp(-i * i / (2 * sigmas[s] * sigmas[s]));
+      for (int i = -r; i <= r; i++)
+        kernel[i + r] /= sum;
+      kernels.push_back(kernel);
+    }
+    kernels.push_back(vector<double>(7, 1. / 7));
+
+    size_t maxDiff = 0, nDiff = 0, nTotal = 0;
+    for (size_t k = 0; k < kernels.size(); k++) {
+      for (int axis = 0; axis < 3; axis++) {
+        if (axis == 0)
+          horizConvolve(imIn, kernels[k], imOut);
+        else if (axis == 1)
+          vertConvolve(imIn, kernels[k], imOut);
+        else
+          depthConvolve(imIn, kernels[k], imOut);
+
+        for (size_t z = 0; z < imIn.getDepth(); z++)
+          for (size_t y = 0; y < imIn.getHeight(); y++)
+            for (size_t x = 0; x < imIn.getWidth(); x++) {
+              int d = abs(int(imOut.getPixel(x, y, z)) -
+                          int(convolveRef(imIn, kernels[k], axis, x, y, z)));
+              maxDiff = max(maxDiff, size_t(d));
+              // Differences shall be rare with Gaussian kernels
+              if (k < 4) {
+                nDiff += d != 0;
+                nTotal++;
+              }
+            }
+      }
+    }
+    TEST_ASSERT(maxDiff <= 1);
+    TEST_ASSERT(nDiff * 1000 < nTotal);
+  }
+};
+
 int main(void)
 {
   TestSuite ts;
 
   ADD_TEST(ts, Test_ConvolHoriz);
   ADD_TEST(ts, Test_ConvolVert);
+  ADD_TEST(ts, Test_DepthConvolve);
+  ADD_TEST(ts, Test_FixedPointConvolve);
   ADD_TEST(ts, Test_GaussianFilter);
+  ADD_TEST(ts, Test_RecursiveGaussianFilter);
 
   return ts.run();
 }
@@ -0,0 +1,121 @@
+/*
+ * Smil
+ * Copyright (c) 2011-2015 Matthieu Faessel
+ *
+ * This file is part of Smil.
+ *
+ * Smil is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Smil is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Smil.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/include/DCore.h"
+#include "DBase.h"
+
+using namespace smil;
+
+class Test_Histogram : public TestCase
+{
+  virtual void run()
+  {
+    Image<UINT8> im1(257, 131), im2(im1), imMask(im1);
+    randFill(im1);
+    randFill(im2);
+    randFill(imMask);
+
+    UINT8 *p1 = im1.getPixels();
+    UINT8 *p2 = im2.getPixels();
+    UINT8 *pm = imMask.getPixels();
+
+    vector<size_t> truth(256, 0), truthMask(256, 0);
+    vector<size_t> truthJoint(256 * 256, 0), truthJointMask(256 * 256, 0);
+    for (size_t i = 0; i < im1.getPixelCount(); i++) {
+      truth[p1[i]]++;
+      truthJoint[p1[i] * 256 + p2[i]]++;
+      if (pm[i] != 0) {
+        truthMask[p1[i]]++;
+        truthJointMask[p1[i] * 256 + p2[i]]++;
+      }
+    }
+
+    vector<size_t> h(256);
+    histogram(im1, &h[0]);
+    TEST_ASSERT(h == truth);
+
+    histogram(im1, imMask, &h[0]);
+    TEST_ASSERT(h == truthMask);
+
+    map<UINT8, UINT> hMap = histogram(im1, imMask);
+    bool             same = true;
+    for (map<UINT8, UINT>::iterator it = hMap.begin(); it != hMap.end(); it++)
+      same = same && it->second == truthMask[it->first];
+    TEST_ASSERT(same);
+
+    vector<size_t> hJoint(256 * 256);
+    jointHistogram(im1, im2, &hJoint[0]);
+    TEST_ASSERT(hJoint == truthJoint);
+
+    jointHistogram(im1, im2, imMask, &hJoint[0]);
+    TEST_ASSERT(hJoint == truthJointMask);
+  }
+};
+
+class Test_OtsuThresholdValues : public TestCase
+{
+  virtual void run()
+  {
+    Image<UINT8> im(30, 10);
+
+    UINT8 **lines = im.getLines();
+    for (UINT j = 0; j < 10; j++)
+      for (UINT i = 0; i < 30; i++)
+        lines[j][i] = i < 10 ? 10 : (i < 20 ? 50 : 200);
+
+    vector<UINT8> tVals = otsuThresholdValues(im, 1);
+    TEST_ASSERT(tVals.size() == 2);
+    TEST_ASSERT(tVals[0] == 50);
+
+    tVals = otsuThresholdValues(im, 2);
+    TEST_ASSERT(tVals.size() == 3);
+    TEST_ASSERT(tVals[0] == 10);
+    TEST_ASSERT(tVals[1] == 50);
+
+    // Many levels on a large range
+    Image<UINT16> im16(256, 256);
+    UINT16      **lines16 = im16.getLines();
+    for (UINT j = 0; j < 256; j++)
+      for (UINT i = 0; i < 256; i++)
+        lines16[j][i] = UINT16(1000 + 15000 * (i / 64) + j);
+
+    vector<UINT16> tVals16 = otsuThresholdValues(im16, 3);
+    TEST_ASSERT(tVals16.size() == 4);
+    TEST_ASSERT(tVals16[0] == 1255);
+    TEST_ASSERT(tVals16[1] == 16255);
+    TEST_ASSERT(tVals16[2] == 31255);
+
+    if (retVal != RES_OK)
+      for (size_t i = 0; i + 1 < tVals16.size(); i++)
+        cout << tVals16[i] << endl;
+  }
+};
+
+int main(void)
+{
+  TestSuite ts;
+
+  ADD_TEST(ts, Test_Histogram);
+  ADD_TEST(ts, Test_OtsuThresholdValues);
+
+  return ts.run();
+}
@@ -68,6 +68,90 @@ class Test_ComputeBlobs : public TestCase
   }
 };
 
+class Test_ComputeBlobTable : public TestCase
+{
+  virtual void run()
+  {
+    Image<UINT16>           im(64, 48);
+    Image<UINT16>::lineType pixels = im.getPixels();
+
+    for (size_t i = 0; i < im.getPixelCount(); i++)
+      pixels[i] = UINT16((i / 5) % 37);
+
+    BlobTable<UINT16> table = computeBlobTable(im, true);
+    map<UINT16, Blob> blobs = computeBlobs(im, true);
+    map<UINT16, Blob> ref;
+    size_t            npix = im.getWidth();
+
+    // Reference : one run per line segment of constant value
+    for (size_t l = 0; l < im.getLineCount(); l++) {
+      size_t i = 0;
+      while (i < npix) {
+        UINT16 v = pixels[l * npix + i];
+        size_t s = i;
+        while (++i < npix && pixels[l * npix + i] == v)
+          ;
+        if (v != 0)
+          ref[v].sequences.push_back(PixelSequence(l * npix + s, i - s));
+      }
+    }
+
+    TEST_ASSERT(table.size() == 36);
+    TEST_ASSERT(blobs.size() == ref.size());
+    TEST_ASSERT(table.find(0) == table.size());
+
+    map<UINT16, Blob>::iterator it = ref.begin();
+    for (size_t b = 0; it != ref.end(); it++, b++) {
+      TEST_ASSERT(table.labels[b] == it->first);
+      TEST_ASSERT(table.getRunCount(b) == it->second.sequences.size());
+      TEST_ASSERT(blobs[it->first].sequences.size() ==
+                  it->second.sequences.size());
+      for (size_t r = 0; r < it->second.sequences.size(); r++) {
+        TEST_ASSERT(table.getRuns(b)[r].offset ==
+                    it->second.sequences[r].offset);
+        TEST_ASSERT(table.getRuns(b)[r].size == it->second.sequences[r].size);
+        TEST_ASSERT(blobs[it->first].sequences[r].offset ==
+                    it->second.sequences[r].offset);
+      }
+    }
+
+    // Sparse labels
+    Image<UINT32> im32(10, 10);
+    fill(im32, UINT32(0));
+    im32.setPixel(3, 2, UINT32(4000000000U));
+    im32.setPixel(7, 5, UINT32(12));
+    BlobTable<UINT32> table32 = computeBlobTable(im32, false);
+    TEST_ASSERT(table32.size() == 3);
+    TEST_ASSERT(table32.labels[2] == 4000000000U);
+    TEST_ASSERT(table32.getRuns(2)[0].offset == 23);
+    TEST_ASSERT(table32.getRunCount(0) == 12);
+
+    map<UINT32, double> areas = blobsArea(im32);
+    TEST_ASSERT(areas.size() == 2 && areas[12] == 1);
+
+    // Negative labels
+    Image<INT16> im16(10, 10);
+    fill(im16, INT16(0));
+    im16.setPixel(1, 1, INT16(-3));
+    im16.setPixel(2, 1, INT16(-3));
+    im16.setPixel(4, 6, INT16(5));
+    BlobTable<INT16> table16 = computeBlobTable(im16, true);
+    TEST_ASSERT(table16.size() == 2);
+    TEST_ASSERT(table16.labels[0] == -3 && table16.labels[1] == 5);
+    TEST_ASSERT(table16.getRuns(0)[0].offset == 11);
+    TEST_ASSERT(table16.getRuns(0)[0].size == 2);
+
+    // Floating point labels aren't merged
+    Image<float> imF(10, 10);
+    fill(imF, 0.f);
+    imF.setPixel(1, 1, 1.25f);
+    imF.setPixel(5, 1, 1.75f);
+    map<float, Blob> blobsF = computeBlobs(imF, true);
+    TEST_ASSERT(blobsF.size() == 2);
+    TEST_ASSERT(blobsF[1.75f].sequences[0].offset == 15);
+  }
+};
+
 class Test_Areas : public TestCase
 {
   virtual void run()
@@ -127,14 +211,110 @@ class Test_MeasureVolumes : public TestCase
   }
 };
 
+class Test_MeasureTable : public TestCase
+{
+  virtual void run()
+  {
+    Image<UINT8> imLbl(64, 64);
+    Image<UINT8> imIn(imLbl);
+
+    fill(imLbl, UINT8(0));
+    drawRectangle(imLbl, 3, 5, 10, 7, UINT8(2), 1);
+    drawRectangle(imLbl, 20, 30, 25, 12, UINT8(7), 1);
+    Image<UINT8>::lineType pixels = imIn.getPixels();
+    for (size_t i = 0; i < imIn.getPixelCount(); i++)
+      pixels[i] = UINT8(i % 13 + 1);
+
+    vector<string> features = {"area", "volume", "mean",  "stddev", "min",
+                               "max",  "xc",     "yc",    "xmin",   "ymax",
+                               "m000", "m110",   "m200"};
+
+    BlobMeasureTable table;
+    TEST_ASSERT(blobsMeasureTable(imIn, imLbl, features, table) == RES_OK);
+    TEST_ASSERT(table.getRowCount() == 8);
+    TEST_ASSERT(table.getFeatureCount() == features.size());
+
+    map<UINT8, Blob>           blobs   = computeBlobs(imLbl);
+    map<UINT8, double>         areas   = blobsArea(blobs);
+    map<UINT8, double>         vols    = blobsVolume(imIn, blobs);
+    map<UINT8, Vector_double>  means   = blobsMeanVal(imIn, blobs);
+    map<UINT8, UINT8>          mins    = blobsMinVal(imIn, blobs);
+    map<UINT8, UINT8>          maxs    = blobsMaxVal(imIn, blobs);
+    map<UINT8, Vector_double>  bary    = blobsBarycenter(imIn, blobs);
+    map<UINT8, vector<size_t>> bbox    = blobsBoundBox(imIn, blobs);
+    map<UINT8, Vector_double>  moments = blobsMoments(imIn, blobs);
+
+    double *area   = table.getColumn("area");
+    double *volume = table.getColumn("volume");
+    double *mean   = table.getColumn("mean");
+    double *stddev = table.getColumn("stddev");
+    double *vmin   = table.getColumn("min");
+    double *vmax   = table.getColumn("max");
+    double *xc     = table.getColumn("xc");
+    double *yc     = table.getColumn("yc");
+    double *xmin   = table.getColumn("xmin");
+    double *ymax   = table.getColumn("ymax");
+    double *m110   = table.getColumn("m110");
+    double *m200   = table.getColumn("m200");
+
+    TEST_ASSERT(table.getColumn("zz") == NULL);
+    TEST_ASSERT(area[0] == 0 && area[3] == 0);
+
+    UINT8 lbls[2] = {2, 7};
+    for (int k = 0; k < 2; k++) {
+      UINT8 l = lbls[k];
+      TEST_ASSERT(area[l] == areas[l]);
+      TEST_ASSERT(volume[l] == vols[l]);
+      TEST_ASSERT(fabs(mean[l] - means[l][0]) < 1e-9);
+      TEST_ASSERT(fabs(stddev[l] - means[l][1]) < 1e-9);
+      TEST_ASSERT(vmin[l] == mins[l] && vmax[l] == maxs[l]);
+      TEST_ASSERT(fabs(xc[l] - bary[l][0]) < 1e-9);
+      TEST_ASSERT(fabs(yc[l] - bary[l][1]) < 1e-9);
+      TEST_ASSERT(xmin[l] == bbox[l][0] && ymax[l] == bbox[l][3]);
+      TEST_ASSERT(m110[l] == moments[l][3] && m200[l] == moments[l][4]);
+    }
+
+    // Caller-provided arrays
+    BlobTable<UINT8> btable = computeBlobTable(imLbl);
+    vector<double>   xs(8), ys(8), as(8);
+    TEST_ASSERT(blobsBarycenter(imIn, btable, xs.data(), ys.data(), NULL,
+                                8) == RES_OK);
+    TEST_ASSERT(blobsArea(btable, as.data(), 8) == RES_OK);
+    TEST_ASSERT(xs[7] == xc[7] && ys[2] == yc[2] && as[7] == 300);
+    TEST_ASSERT(blobsArea(btable, as.data(), 7) != RES_OK);
+
+    // Label-indexed rows need non negative integer labels
+    Image<INT16> imSigned(imLbl);
+    fill(imSigned, INT16(0));
+    drawRectangle(imSigned, 3, 5, 10, 7, INT16(-3), 1);
+    drawRectangle(imSigned, 20, 30, 25, 12, INT16(4), 1);
+    TEST_ASSERT(blobsMeasureTable(imIn, imSigned, features, table) !=
+                RES_OK);
+    BlobTable<INT16> stable = computeBlobTable(imSigned);
+    TEST_ASSERT(blobsArea(stable, as.data(), 8) != RES_OK);
+
+    Image<float> imFloat(imLbl);
+    copy(imLbl, imFloat);
+    TEST_ASSERT(blobsMeasureTable(imIn, imFloat, features, table) != RES_OK);
+
+    // Without negative label, a signed label image is fine
+    drawRectangle(imSigned, 3, 5, 10, 7, INT16(2), 1);
+    TEST_ASSERT(blobsMeasureTable(imIn, imSigned, features, table) == RES_OK);
+    TEST_ASSERT(table.getRowCount() == 5);
+    TEST_ASSERT(table.getColumn("area")[2] == areas[2]);
+  }
+};
+
 int main()
 {
   TestSuite ts;
 
   ADD_TEST(ts, Test_ComputeBlobs);
+  ADD_TEST(ts, Test_ComputeBlobTable);
   ADD_TEST(ts, Test_Areas);
   ADD_TEST(ts, Test_Barycenters);
   ADD_TEST(ts, Test_MeasureVolumes);
+  ADD_TEST(ts, Test_MeasureTable);
 
   return ts.run();
 }
@@ -195,21 +195,6 @@ class Test_Hamming : public TestCase
   }
 };
 
-class Test_Hausdorff : public TestCase
-{
-  virtual void run()
-  {
-    double rExpect = 90.510;
-
-    double r = distanceHausdorff(imGt, imIn);
-
-    bool ok = abs(r - rExpect) < 0.001;
-    TEST_ASSERT(ok);
-    if (!ok)
-      cout << "\n\t distanceHausdorff \t" << rExpect << "\t" << r << endl;
-  }
-};
-
 int main(void)
 {
   TestSuite ts;
@@ -242,7 +227,6 @@ int main(void)
   ADD_TEST(ts, Test_Overlap);
   ADD_TEST(ts, Test_Jaccard);
   ADD_TEST(ts, Test_Hamming);
-  ADD_TEST(ts, Test_Hausdorff);
 
   return ts.run();
 }
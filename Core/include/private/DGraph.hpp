@@ -690,6 +690,690 @@ namespace smil
     return mst;
   }
 
+  //
+  //  ####    ####   #####
+  // #    #  #       #    #
+  // #        ####   #    #
+  // #            #  #####
+  // #    #  #    #  #   #
+  //  ####    ####   #    #
+  //
+  /**
+   * Non-oriented graph in Compressed Sparse Row form
+   *
+   * Nodes are kept sorted in a vector and the edges incident to each node are
+   * stored contiguously : for the node at index @b i, the neighbor node
+   * indexes are <tt>getAdjacentNodes()[k]</tt> and the matching edge indexes
+   * are <tt>getAdjacentEdges()[k]</tt>, for @b k in
+   * <tt>[getRowStarts()[i], getRowStarts()[i + 1])</tt>.
+   *
+   * The structure is built once from a list of edges and then only read,
+   * without any map or set lookup. Use Graph to edit a graph : the
+   * constructor from a Graph and toGraph() convert between both.
+   *
+   * @see Graph
+   */
+  template <class NodeT = size_t, class WeightT = size_t>
+  class CSRGraph : public BaseObject
+  {
+  public:
+    typedef CSRGraph<NodeT, WeightT> CSRGraphType;
+    typedef Graph<NodeT, WeightT>    GraphType;
+
+    typedef NodeT                NodeType;
+    typedef WeightT              NodeWeightType;
+    typedef std::vector<NodeT>   NodeListType;
+    typedef std::vector<WeightT> NodeValuesType;
+
+    typedef Edge<NodeT, WeightT>  EdgeType;
+    typedef WeightT               EdgeWeightType;
+    typedef std::vector<EdgeType> EdgeListType;
+    typedef std::vector<size_t>   IndexListType;
+
+  protected:
+    NodeListType   nodes;
+    NodeValuesType nodeValues;
+    EdgeListType   edges;
+    IndexListType  rowStarts;
+    IndexListType  adjNodes;
+    IndexListType  adjEdges;
+
+  public:
+    //! Default constructor
+    CSRGraph() : BaseObject("CSRGraph")
+    {
+    }
+
+    //! Copy constructor
+    CSRGraph(const CSRGraph &rhs)
+        : BaseObject("CSRGraph"), nodes(rhs.nodes), nodeValues(rhs.nodeValues),
+          edges(rhs.edges), rowStarts(rhs.rowStarts), adjNodes(rhs.adjNodes),
+          adjEdges(rhs.adjEdges)
+    {
+    }
+
+    //! Constructor from a Graph (inactive edges are ignored)
+    CSRGraph(const GraphType &graph) : BaseObject("CSRGraph")
+    {
+      fromGraph(graph);
+    }
+
+    /** @cond */
+    virtual ~CSRGraph()
+    {
+    }
+    /** @endcond */
+
+    CSRGraph &operator=(const CSRGraph &rhs)
+    {
+      nodes      = rhs.nodes;
+      nodeValues = rhs.nodeValues;
+      edges      = rhs.edges;
+      rowStarts  = rhs.rowStarts;
+      adjNodes   = rhs.adjNodes;
+      adjEdges   = rhs.adjEdges;
+      return *this;
+    }
+
+    //! Clear graph content
+    void clear()
+    {
+      nodes.clear();
+      nodeValues.clear();
+      edges.clear();
+      rowStarts.clear();
+      adjNodes.clear();
+      adjEdges.clear();
+    }
+
+    /**
+     * build() - Build the graph from a list of edges
+     *
+     * The nodes are the end points of the edges. Edges keep their order and
+     * node values are cleared.
+     *
+     * @param[in] edgeList : graph edges
+     */
+    void build(const EdgeListType &edgeList)
+    {
+      edges = edgeList;
+      nodes.clear();
+      nodes.reserve(2 * edges.size());
+      for (size_t i = 0; i < edges.size(); i++) {
+        nodes.push_back(edges[i].source);
+        nodes.push_back(edges[i].target);
+      }
+      std::sort(nodes.begin(), nodes.end());
+      nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+
+      nodeValues.clear();
+      buildRows();
+    }
+
+    /**
+     * fromGraph() - Build the graph from the content of a Graph
+     *
+     * Inactive edges (removed from @b graph) are ignored, isolated nodes and
+     * node values are kept. Nodes without value get a null value.
+     */
+    void fromGraph(const GraphType &graph)
+    {
+      const typename GraphType::EdgeListType &gEdges = graph.getEdges();
+
+      edges.clear();
+      for (size_t i = 0; i < gEdges.size(); i++)
+        if (gEdges[i].isActive())
+          edges.push_back(gEdges[i]);
+
+      const typename GraphType::NodeListType &gNodes = graph.getNodes();
+      nodes.assign(gNodes.begin(), gNodes.end());
+
+      const typename GraphType::NodeValuesType &gValues =
+          graph.getNodeValues();
+      nodeValues.clear();
+      if (!gValues.empty()) {
+        nodeValues.resize(nodes.size(), WeightT(0));
+        for (size_t i = 0; i < nodes.size(); i++) {
+          typename GraphType::NodeValuesType::const_iterator it =
+              gValues.find(nodes[i]);
+          if (it != gValues.end())
+            nodeValues[i] = it->second;
+        }
+      }
+      buildRows();
+    }
+
+    /**
+     * toGraph() - Copy the nodes, node values and edges into a Graph
+     */
+    void toGraph(GraphType &graph) const
+    {
+      graph.clear();
+      for (size_t i = 0; i < nodes.size(); i++) {
+        if (nodeValues.empty())
+          graph.addNode(nodes[i]);
+        else
+          graph.addNode(nodes[i], nodeValues[i]);
+      }
+      for (size_t i = 0; i < edges.size(); i++)
+        graph.addEdge(edges[i], false);
+    }
+
+    /**
+     * toGraph() - Convert to a Graph
+     */
+    GraphType toGraph() const
+    {
+      GraphType graph;
+      toGraph(graph);
+      return graph;
+    }
+
+    /**
+     * setNodeValues() - Set one value per node, in the order of getNodes()
+     */
+    RES_T setNodeValues(const NodeValuesType &values)
+    {
+      ASSERT(values.empty() || values.size() == nodes.size(),
+             "One value per node is expected", RES_ERR);
+      nodeValues = values;
+      return RES_OK;
+    }
+
+    /**
+     * getNodeNbr() -
+     */
+    size_t getNodeNbr() const
+    {
+      return nodes.size();
+    }
+
+    /**
+     * getEdgeNbr() -
+     */
+    size_t getEdgeNbr() const
+    {
+      return edges.size();
+    }
+
+    /**
+     * getNodeIndex() - Index of a node in getNodes()
+     *
+     * @returns getNodeNbr() if the node isn't in the graph
+     */
+    size_t getNodeIndex(const NodeT &node) const
+    {
+      typename NodeListType::const_iterator it =
+          std::lower_bound(nodes.begin(), nodes.end(), node);
+      if (it == nodes.end() || *it != node)
+        return nodes.size();
+      return it - nodes.begin();
+    }
+
+    /**
+     * getDegree() - Number of edges incident to the node at index
+     * @b nodeIndex
+     */
+    size_t getDegree(size_t nodeIndex) const
+    {
+      return rowStarts[nodeIndex + 1] - rowStarts[nodeIndex];
+    }
+
+    /** @cond */
+#ifndef SWIG
+    const NodeListType &getNodes() const
+    {
+      return nodes;
+    }
+
+    const NodeValuesType &getNodeValues() const
+    {
+      return nodeValues;
+    }
+
+    const EdgeListType &getEdges() const
+    {
+      return edges;
+    }
+
+    const IndexListType &getRowStarts() const
+    {
+      return rowStarts;
+    }
+
+    const IndexListType &getAdjacentNodes() const
+    {
+      return adjNodes;
+    }
+
+    const IndexListType &getAdjacentEdges() const
+    {
+      return adjEdges;
+    }
+#endif // SWIG
+    /** @endcond */
+
+    /**
+     * printSelf() -
+     */
+    virtual void printSelf(std::ostream &os = std::cout,
+                           std::string   s  = "") const
+    {
+      os << s << "Number of nodes: " << nodes.size() << std::endl;
+      os << s << "Number of edges: " << edges.size() << std::endl;
+      os << s << "Edges: " << std::endl
+         << "source-target (weight) " << std::endl;
+
+      std::string s2 = s + "\t";
+      for (typename EdgeListType::const_iterator it = edges.begin();
+           it != edges.end(); it++)
+        (*it).printSelf(os, s2);
+    }
+
+  protected:
+    /*
+     * Counting sort of the edge end points by node index. Self loops are
+     * stored once.
+     */
+    void buildRows()
+    {
+      size_t nodeNbr = nodes.size();
+      size_t edgeNbr = edges.size();
+
+      IndexListType srcIndex(edgeNbr), targIndex(edgeNbr);
+      rowStarts.assign(nodeNbr + 1, 0);
+      for (size_t i = 0; i < edgeNbr; i++) {
+        srcIndex[i]  = getNodeIndex(edges[i].source);
+        targIndex[i] = getNodeIndex(edges[i].target);
+        rowStarts[srcIndex[i] + 1]++;
+        if (targIndex[i] != srcIndex[i])
+          rowStarts[targIndex[i] + 1]++;
+      }
+      for (size_t i = 0; i < nodeNbr; i++)
+        rowStarts[i + 1] += rowStarts[i];
+
+      adjNodes.resize(rowStarts[nodeNbr]);
+      adjEdges.resize(rowStarts[nodeNbr]);
+
+      IndexListType pos(rowStarts.begin(), rowStarts.end() - 1);
+      for (size_t i = 0; i < edgeNbr; i++) {
+        size_t k    = pos[srcIndex[i]]++;
+        adjNodes[k] = targIndex[i];
+        adjEdges[k] = i;
+        if (targIndex[i] == srcIndex[i])
+          continue;
+        k           = pos[targIndex[i]]++;
+        adjNodes[k] = srcIndex[i];
+        adjEdges[k] = i;
+      }
+    }
+  };
+
+  /** @cond */
+  /*
+   * Strict order on the edges : by weight, then by index. It makes the
+   * minimum spanning tree unique, equal to the one of a Kruskal algorithm on
+   * edges stable sorted by weight.
+   */
+  template <class EdgeListT>
+  struct EdgeIndexOrder {
+    const EdgeListT &edges;
+
+    EdgeIndexOrder(const EdgeListT &e) : edges(e)
+    {
+    }
+
+    bool operator()(size_t i, size_t j) const
+    {
+      if (edges[i].weight != edges[j].weight)
+        return edges[i].weight < edges[j].weight;
+      return i < j;
+    }
+  };
+  /** @endcond */
+
+  /** graphMSTEdges() - Minimum spanning tree (or forest) of a CSRGraph
+   *
+   * @note
+   * Computed with the Borůvka algorithm : at each round, the lightest edge
+   * leaving each component is looked for in parallel on the adjacency lists,
+   * then components are merged along these edges. There are at most
+   * @f$ \log_2(N) @f$ rounds. Edges with the same weight are ordered by
+   * index, so the result is the one of a Kruskal algorithm and doesn't depend
+   * on the number of threads.
+   *
+   * @param[in] graph : input graph
+   *
+   * @returns indexes of the tree edges in <tt>graph.getEdges()</tt>, sorted
+   * by increasing weight (Kruskal order)
+   */
+  template <class NodeT, class WeightT>
+  std::vector<size_t> graphMSTEdges(const CSRGraph<NodeT, WeightT> &graph)
+  {
+    typedef typename CSRGraph<NodeT, WeightT>::EdgeListType  EdgeListType;
+    typedef typename CSRGraph<NodeT, WeightT>::IndexListType IndexListType;
+
+    const EdgeListType  &edges    = graph.getEdges();
+    const IndexListType &rows     = graph.getRowStarts();
+    const IndexListType &adjNodes = graph.getAdjacentNodes();
+    const IndexListType &adjEdges = graph.getAdjacentEdges();
+
+    EdgeIndexOrder<EdgeListType> lighter(edges);
+
+    const size_t none    = std::numeric_limits<size_t>::max();
+    size_t       nodeNbr = graph.getNodeNbr();
+
+    // Component of each node, always a root of the union-find
+    IndexListType comp(nodeNbr), parent(nodeNbr);
+    for (size_t i = 0; i < nodeNbr; i++)
+      comp[i] = parent[i] = i;
+
+    IndexListType best(nodeNbr), bestNode(nodeNbr);
+    IndexListType compBest(nodeNbr), compBestNode(nodeNbr);
+    IndexListType mstEdges;
+
+    bool merged = true;
+    while (merged) {
+      merged = false;
+
+      // Lightest edge leaving the component of each node
+#ifdef USE_OPEN_MP
+      int nthreads = Core::getInstance()->getNumberOfThreads();
+#pragma omp parallel for num_threads(nthreads)
+#endif // USE_OPEN_MP
+      for (size_t i = 0; i < nodeNbr; i++) {
+        size_t b = none, bn = none;
+        for (size_t k = rows[i]; k < rows[i + 1]; k++) {
+          if (comp[adjNodes[k]] == comp[i])
+            continue;
+          if (b == none || lighter(adjEdges[k], b)) {
+            b  = adjEdges[k];
+            bn = adjNodes[k];
+          }
+        }
+        best[i]     = b;
+        bestNode[i] = bn;
+      }
+
+      // Lightest edge leaving each component
+      std::fill(compBest.begin(), compBest.end(), none);
+      for (size_t i = 0; i < nodeNbr; i++) {
+        size_t c = comp[i];
+        if (best[i] == none)
+          continue;
+        if (compBest[c] == none || lighter(best[i], compBest[c])) {
+          compBest[c]     = best[i];
+          compBestNode[c] = bestNode[i];
+        }
+      }
+
+      // Merge along these edges. An edge chosen by both of its components
+      // is only kept once.
+      for (size_t c = 0; c < nodeNbr; c++) {
+        if (compBest[c] == none)
+          continue;
+        size_t a = c, b = comp[compBestNode[c]];
+        while (parent[a] != a)
+          a = parent[a];
+        while (parent[b] != b)
+          b = parent[b];
+        if (a == b)
+          continue;
+        parent[std::max(a, b)] = std::min(a, b);
+        mstEdges.push_back(compBest[c]);
+        merged = true;
+      }
+
+      if (!merged)
+        break;
+
+      // Flatten the union-find on the component roots, then relabel
+      for (size_t c = 0; c < nodeNbr; c++) {
+        if (comp[c] != c)
+          continue;
+        size_t r = c;
+        while (parent[r] != r)
+          r = parent[r];
+        parent[c] = r;
+      }
+#ifdef USE_OPEN_MP
+#pragma omp parallel for num_threads(nthreads)
+#endif // USE_OPEN_MP
+      for (size_t i = 0; i < nodeNbr; i++)
+        comp[i] = parent[comp[i]];
+    }
+
+    std::sort(mstEdges.begin(), mstEdges.end(), lighter);
+    return mstEdges;
+  }
+
+  /** graphMST() - Minimum spanning tree (or forest) of a CSRGraph
+   *
+   * @see graphMSTEdges()
+   *
+   * @param[in] graph : input graph
+   *
+   * @returns the tree, with its edges in Kruskal order
+   */
+  template <class NodeT, class WeightT>
+  CSRGraph<NodeT, WeightT> graphMST(const CSRGraph<NodeT, WeightT> &graph)
+  {
+    typedef CSRGraph<NodeT, WeightT> CSRGraphType;
+
+    std::vector<size_t> mstEdges = graphMSTEdges(graph);
+
+    typename CSRGraphType::EdgeListType edges(mstEdges.size());
+    for (size_t i = 0; i < mstEdges.size(); i++)
+      edges[i] = graph.getEdges()[mstEdges[i]];
+
+    CSRGraphType mst;
+    mst.build(edges);
+
+    // Copy node values
+    if (!graph.getNodeValues().empty()) {
+      typename CSRGraphType::NodeValuesType values(mst.getNodeNbr());
+      for (size_t i = 0; i < values.size(); i++)
+        values[i] = graph.getNodeValues()[graph.getNodeIndex(
+            mst.getNodes()[i])];
+      mst.setNodeValues(values);
+    }
+    return mst;
+  }
+
+  //
+  // #####   #####   #####
+  // #    #  #    #    #
+  // #####   #    #    #
+  // #    #  #####     #
+  // #    #  #         #
+  // #####   #         #
+  //
+  /**
+   * Binary partition tree of a weighted graph
+   *
+   * The leaves are the nodes of the graph, in the order of
+   * CSRGraph::getNodes(). Each internal node merges two regions along an edge
+   * of the minimum spanning tree, edges being processed by increasing weight,
+   * and its altitude is the weight of this edge. Cutting the tree at a given
+   * altitude gives the quasi-flat zones of the graph : the connected
+   * components of its edges with a weight not above this altitude.
+   *
+   * A graph with several connected components gives a forest, with one root
+   * per component.
+   *
+   * @note
+   * The tree is built from the edges of graphMSTEdges(), already in Kruskal
+   * order, with a single union-find pass.
+   */
+  template <class NodeT = size_t, class WeightT = size_t>
+  class BinaryPartitionTree : public BaseObject
+  {
+  public:
+    typedef std::vector<size_t>  IndexListType;
+    typedef std::vector<WeightT> AltitudeListType;
+
+  protected:
+    size_t           leafNbr;
+    IndexListType    parents;
+    IndexListType    children;
+    IndexListType    edgeIndexes;
+    AltitudeListType altitudes;
+
+  public:
+    //! Default constructor
+    BinaryPartitionTree() : BaseObject("BinaryPartitionTree"), leafNbr(0)
+    {
+    }
+
+    //! Build the tree of a graph
+    BinaryPartitionTree(const CSRGraph<NodeT, WeightT> &graph)
+        : BaseObject("BinaryPartitionTree"), leafNbr(0)
+    {
+      build(graph);
+    }
+
+    /** @cond */
+    virtual ~BinaryPartitionTree()
+    {
+    }
+    /** @endcond */
+
+    /**
+     * build() - Build the tree of a graph
+     */
+    void build(const CSRGraph<NodeT, WeightT> &graph)
+    {
+      IndexListType mstEdges = graphMSTEdges(graph);
+
+      leafNbr        = graph.getNodeNbr();
+      size_t nodeNbr = leafNbr + mstEdges.size();
+
+      parents.resize(nodeNbr);
+      altitudes.assign(nodeNbr, WeightT(0));
+      children.resize(2 * mstEdges.size());
+      edgeIndexes = mstEdges;
+      for (size_t i = 0; i < nodeNbr; i++)
+        parents[i] = i;
+
+      // Node indexes of the edge ends, from the adjacency lists
+      const IndexListType &rows = graph.getRowStarts();
+      IndexListType        ends(2 * graph.getEdgeNbr());
+      for (size_t i = 0; i < leafNbr; i++)
+        for (size_t k = rows[i]; k < rows[i + 1]; k++) {
+          size_t e        = graph.getAdjacentEdges()[k];
+          ends[2 * e]     = i;
+          ends[2 * e + 1] = graph.getAdjacentNodes()[k];
+        }
+
+      // Union-find on the leaves, each root pointing to its tree node
+      IndexListType uf(leafNbr), treeNode(leafNbr);
+      for (size_t i = 0; i < leafNbr; i++)
+        uf[i] = treeNode[i] = i;
+
+      for (size_t k = 0; k < mstEdges.size(); k++) {
+        const typename CSRGraph<NodeT, WeightT>::EdgeType &e =
+            graph.getEdges()[mstEdges[k]];
+        size_t a = findRoot(uf, ends[2 * mstEdges[k]]);
+        size_t b = findRoot(uf, ends[2 * mstEdges[k] + 1]);
+        size_t n = leafNbr + k;
+
+        parents[treeNode[a]] = parents[treeNode[b]] = n;
+        children[2 * k]                             = treeNode[a];
+        children[2 * k + 1]                         = treeNode[b];
+        altitudes[n]                                = e.weight;
+
+        uf[b]       = a;
+        treeNode[a] = n;
+      }
+    }
+
+    /**
+     * getLeafNbr() - Number of leaves (nodes of the graph)
+     */
+    size_t getLeafNbr() const
+    {
+      return leafNbr;
+    }
+
+    /**
+     * getNodeNbr() - Number of nodes of the tree, leaves included
+     */
+    size_t getNodeNbr() const
+    {
+      return parents.size();
+    }
+
+    /** @cond */
+#ifndef SWIG
+    /*
+     * Parent of each node, roots being their own parent. Parents always
+     * have a greater index than their children.
+     */
+    const IndexListType &getParents() const
+    {
+      return parents;
+    }
+
+    /*
+     * Children of the internal node getLeafNbr() + k at 2k and 2k + 1
+     */
+    const IndexListType &getChildren() const
+    {
+      return children;
+    }
+
+    /*
+     * Graph edge of the internal node getLeafNbr() + k at k
+     */
+    const IndexListType &getEdgeIndexes() const
+    {
+      return edgeIndexes;
+    }
+
+    /*
+     * Altitude of each node, null for the leaves
+     */
+    const AltitudeListType &getAltitudes() const
+    {
+      return altitudes;
+    }
+#endif // SWIG
+    /** @endcond */
+
+    /**
+     * quasiFlatZones() - Cut of the tree at a given altitude
+     *
+     * @param[in] altitude : highest weight of the merged edges
+     *
+     * @returns for each leaf, the index of the highest node above it with an
+     * altitude not greater than @b altitude (or the leaf itself). Leaves
+     * with the same value are in the same zone.
+     */
+    IndexListType quasiFlatZones(double altitude) const
+    {
+      size_t        nodeNbr = parents.size();
+      IndexListType zone(nodeNbr);
+
+      // Parents come after their children : top-down pass
+      for (size_t i = nodeNbr; i-- > 0;) {
+        size_t p = parents[i];
+        zone[i]  = (p != i && double(altitudes[p]) <= altitude) ? zone[p] : i;
+      }
+      zone.resize(leafNbr);
+      return zone;
+    }
+
+  protected:
+    static size_t findRoot(IndexListType &uf, size_t x)
+    {
+      while (uf[x] != x) {
+        uf[x] = uf[uf[x]];
+        x     = uf[x];
+      }
+      return x;
+    }
+  };
+
   /** @} */
 
 } // namespace smil
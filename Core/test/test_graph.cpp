@@ -100,12 +100,125 @@ class Test_Labelize : public TestCase
   }
 };
 
+class Test_CSRGraph : public TestCase
+{
+  virtual void run()
+  {
+    Graph<> graph;
+    graph.addEdge(Edge<>(0, 2, 1));
+    graph.addEdge(Edge<>(1, 3, 1));
+    graph.addEdge(Edge<>(1, 4, 2));
+    graph.addEdge(Edge<>(2, 1, 7));
+    graph.addNode(6, 5);
+    graph.removeEdge(1, 4);
+
+    CSRGraph<> csr(graph);
+
+    TEST_ASSERT(csr.getNodeNbr() == 6);
+    TEST_ASSERT(csr.getEdgeNbr() == 3);
+    TEST_ASSERT(csr.getNodeValues()[csr.getNodeIndex(6)] == 5);
+    TEST_ASSERT(csr.getDegree(csr.getNodeIndex(1)) == 2);
+    TEST_ASSERT(csr.getDegree(csr.getNodeIndex(4)) == 0);
+
+    // Neighbors of node 2
+    size_t         n = csr.getNodeIndex(2);
+    vector<size_t> neighbors;
+    for (size_t k = csr.getRowStarts()[n]; k < csr.getRowStarts()[n + 1]; k++)
+      neighbors.push_back(csr.getNodes()[csr.getAdjacentNodes()[k]]);
+    sort(neighbors.begin(), neighbors.end());
+    TEST_ASSERT(neighbors.size() == 2 && neighbors[0] == 0 &&
+                neighbors[1] == 1);
+
+    Graph<> graph2 = csr.toGraph();
+    TEST_ASSERT(graph2.getEdges() == csr.getEdges());
+    TEST_ASSERT(graph2.getNodes() == graph.getNodes());
+  }
+};
+
+class Test_CSRGraphMST : public TestCase
+{
+  virtual void run()
+  {
+    Graph<> graph;
+    graph.addEdge(Edge<>(0, 2, 1));
+    graph.addEdge(Edge<>(1, 3, 1));
+    graph.addEdge(Edge<>(1, 4, 2));
+    graph.addEdge(Edge<>(2, 1, 7));
+    graph.addEdge(Edge<>(2, 3, 3));
+    graph.addEdge(Edge<>(3, 4, 1));
+    graph.addEdge(Edge<>(4, 0, 1));
+    graph.addEdge(Edge<>(4, 1, 3));
+    // Second connected component
+    graph.addEdge(Edge<>(7, 8, 5));
+    graph.addEdge(Edge<>(8, 9, 2));
+    graph.addEdge(Edge<>(9, 7, 5));
+
+    CSRGraph<> csr(graph);
+
+    vector<size_t> mstEdges = graphMSTEdges(csr);
+    vector<size_t> mstTruth;
+    mstTruth.push_back(0);
+    mstTruth.push_back(1);
+    mstTruth.push_back(5);
+    mstTruth.push_back(6);
+    mstTruth.push_back(8);
+    mstTruth.push_back(7);
+
+    TEST_ASSERT(mstEdges == mstTruth);
+
+    if (retVal != RES_OK) {
+      for (size_t i = 0; i < mstEdges.size(); i++)
+        cout << mstEdges[i] << " ";
+      cout << endl;
+    }
+
+    CSRGraph<> mst = graphMST(csr);
+    TEST_ASSERT(mst.getEdgeNbr() == 6);
+    TEST_ASSERT(mst.getNodeNbr() == 8);
+  }
+};
+
+class Test_BinaryPartitionTree : public TestCase
+{
+  virtual void run()
+  {
+    Graph<> graph;
+    graph.addEdge(Edge<>(0, 1, 2));
+    graph.addEdge(Edge<>(1, 2, 5));
+    graph.addEdge(Edge<>(2, 3, 1));
+    graph.addEdge(Edge<>(3, 4, 7));
+    graph.addEdge(Edge<>(0, 2, 6));
+
+    BinaryPartitionTree<> bpt(graph);
+
+    TEST_ASSERT(bpt.getLeafNbr() == 5);
+    TEST_ASSERT(bpt.getNodeNbr() == 9);
+    TEST_ASSERT(bpt.getAltitudes()[8] == 7);
+    TEST_ASSERT(bpt.getParents()[8] == 8);
+    TEST_ASSERT(bpt.getParents()[2] == 5 && bpt.getParents()[3] == 5);
+
+    vector<size_t> zones = bpt.quasiFlatZones(2);
+    TEST_ASSERT(zones[0] == zones[1] && zones[2] == zones[3]);
+    TEST_ASSERT(zones[0] != zones[2] && zones[4] == 4);
+
+    zones = bpt.quasiFlatZones(5);
+    TEST_ASSERT(zones[0] == zones[3] && zones[4] != zones[0]);
+
+    zones = bpt.quasiFlatZones(0);
+    for (size_t i = 0; i < zones.size(); i++)
+      TEST_ASSERT(zones[i] == i);
+  }
+};
+
 int main()
 {
   TestSuite ts;
 
   ADD_TEST(ts, Test_MST);
   ADD_TEST(ts, Test_Labelize);
+  ADD_TEST(ts, Test_CSRGraph);
+  ADD_TEST(ts, Test_CSRGraphMST);
+  ADD_TEST(ts, Test_BinaryPartitionTree);
 
   return ts.run();
 }
@@ -42,6 +42,7 @@
 #include "private/DHitOrMiss.hpp"
 #include "private/DMorphoArrow.hpp"
 #include "private/DMorphoBase.hpp"
+#include "private/DMorphoComponentTree.hpp"
 #include "private/DMorphoExtrema.hpp"
 #include "private/DMorphoFilter.hpp"
 #include "private/DMorphoGeodesic.hpp"
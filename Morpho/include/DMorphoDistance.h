@@ -64,14 +64,57 @@ namespace smil
 
   /**
    * @brief distanceEuclidean() - Euclidean distance function.
+   *
+   * Exact Euclidean distance of each non zero pixel to the nearest zero
+   * pixel, computed by a separable algorithm linear in the number of pixels.
+   * Non integer distances are truncated when @TB{T2} is an integer type.
+   *
    * @param[in] imIn : Binary input image
    * @param[out] imOut : Output image
-   * @param[in] se : Structuring Element
+   * @param[in] se : Structuring Element, ignored : the distance is exact
+   * whatever its neighborhood. Kept for compatibility.
    */
   template <class T1, class T2>
   RES_T distanceEuclidean(const Image<T1> &imIn, Image<T2> &imOut,
                           const StrElt &se = DEFAULT_SE);
 
+  /**
+   * @brief distanceEuclidean() - Euclidean distance function with anisotropic
+   * pixel spacing.
+   *
+   * Same as above, with distances measured in physical units : a step along
+   * the @TB{x}, @TB{y} and @TB{z} axis has length @TB{sx}, @TB{sy} and
+   * @TB{sz}.
+   *
+   * @param[in] imIn : Binary input image
+   * @param[out] imOut : Output image
+   * @param[in] sx, sy, sz : pixel spacing along each axis
+   *
+   * @note As output values are truncated for integer types, express the
+   * spacing in a unit small enough for the expected precision (e.g. 1/10 mm).
+   */
+  template <class T1, class T2>
+  RES_T distanceEuclidean(const Image<T1> &imIn, Image<T2> &imOut, double sx,
+                          double sy, double sz = 1.);
+
+  /**
+   * @brief distanceEuclideanFeature() - Euclidean distance function and
+   * feature transform.
+   *
+   * Along with the Euclidean distance, get for each pixel the offset of the
+   * nearest zero pixel (the pixel itself for zero pixels).
+   *
+   * @param[in] imIn : Binary input image
+   * @param[out] imOut : Output image
+   * @param[out] imFeature : offset of the nearest zero pixel. Pixels of an
+   * image without any zero pixel are set to the pixel count.
+   * @param[in] sx, sy, sz : pixel spacing along each axis
+   */
+  template <class T1, class T2>
+  RES_T distanceEuclideanFeature(const Image<T1> &imIn, Image<T2> &imOut,
+                                 Image<UINT32> &imFeature, double sx = 1.,
+                                 double sy = 1., double sz = 1.);
+
   /** @cond */
   template <class T1, class T2>
   RES_T dist_euclidean(const Image<T1> &imIn, Image<T2> &imOut);
@@ -90,6 +133,58 @@ namespace smil
   RES_T distanceGeodesic(const Image<T1> &imIn, const Image<T1> &imMask,
                          Image<T2> &imOut, const StrElt &se = DEFAULT_SE);
 
+  /**
+   * @brief distanceGeodesicEuclidean() - Real valued geodesic distance
+   * function.
+   *
+   * Approximation of the Euclidean geodesic distance, inside the mask, of
+   * each non zero pixel of @b imIn to the nearest zero pixel of @b imIn,
+   * evaluated with the Fast Marching Method (first order upwind solution of
+   * the Eikonal equation, with 4-connectivity in 2D and 6-connectivity in
+   * 3D).
+   *
+   * Unlike distanceGeodesic(), which counts structuring element steps, the
+   * result doesn't depend on the orientation of the paths and shall be
+   * stored in a @b float image to keep its precision. Connected components
+   * of the mask are processed in parallel.
+   *
+   * Pixels outside the mask are set to 0. Pixels inside the mask but in a
+   * connected component without any zero pixel of @b imIn are set to the
+   * maximum value of the output image type.
+   *
+   * @param[in] imIn : Binary input image
+   * @param[in] imMask : Binary mask image
+   * @param[out] imOut : Output image
+   * @param[in] sx, sy, sz : pixel spacing along each axis
+   */
+  template <class T1, class T2>
+  RES_T distanceGeodesicEuclidean(const Image<T1> &imIn,
+                                  const Image<T1> &imMask, Image<T2> &imOut,
+                                  double sx = 1., double sy = 1.,
+                                  double sz = 1.);
+
+  /**
+   * @brief distanceGeodesicWeighted() - Weighted geodesic distance function.
+   *
+   * Same as distanceGeodesicEuclidean(), but the cost to travel through each
+   * pixel is given by the image @b imCost : the result is the minimal path
+   * integral of the cost from the zero pixels of @b imIn. Pixels with a zero
+   * cost are not crossed by any path and are set to 0.
+   *
+   * The cost image may be of any type, independently of the seed image :
+   * typically a @b float cost with an @b UINT8 seed image.
+   *
+   * @param[in] imIn : Binary input image
+   * @param[in] imCost : Local cost image (non negative values)
+   * @param[out] imOut : Output image
+   * @param[in] sx, sy, sz : pixel spacing along each axis
+   */
+  template <class T1, class T2, class T3>
+  RES_T distanceGeodesicWeighted(const Image<T1> &imIn,
+                                 const Image<T2> &imCost, Image<T3> &imOut,
+                                 double sx = 1., double sy = 1.,
+                                 double sz = 1.);
+
   /*
    * Internal functions - old deprecated prototypes - not to be called by user
    * programs
@@ -170,4 +265,8 @@ namespace smil
 
 #include "private/DMorphoEuclidean.hpp"
 
+#include "private/DMorphoFastMarching.hpp"
+
+#include "private/DMorphoSurfaceDistance.hpp"
+
 #endif // _DMORPHO_DISTANCE_H
@@ -58,6 +58,253 @@ namespace smil
    * @{
    */
 
+  /** @cond */
+  /*
+   * Neighbors sampled by erode(im, se) around a pixel, as a mask of 27 bits,
+   * for the given parity of its line and slice (odd SEs). The neighbor at
+   * (x + dx, y + dy, z + dz) is the bit (dx + 1) + 3 * (dy + 1) + 9 * (dz + 1).
+   * Returns false when the SE doesn't fit in a 3x3x3 neighborhood.
+   */
+  inline bool hmtNeighborMask(const StrElt &se, int line, int slice,
+                              UINT32 &mask)
+  {
+    if (se.size != 1 || se.points.empty())
+      return false;
+
+    StrElt tse     = se.transpose();
+    bool   oddLine = se.odd && (line + 1) % 2 && (slice + 1) % 2;
+
+    mask = 0;
+    for (size_t i = 0; i < tse.points.size(); i++) {
+      const IntPoint &pt = tse.points[i];
+
+      int dx = -pt.x - (oddLine && (line - pt.y) % 2);
+      int dy = -pt.y;
+      int dz = -pt.z;
+      if (dx < -1 || dx > 1 || dy < -1 || dy > 1 || dz < -1 || dz > 1)
+        return false;
+      mask |= UINT32(1) << ((dx + 1) + 3 * (dy + 1) + 9 * (dz + 1));
+    }
+    return true;
+  }
+
+  /*
+   * Foreground and background masks of a list of composite SEs, for the four
+   * parities of line and slice. Returns false if one of them doesn't fit in a
+   * 3x3x3 neighborhood.
+   */
+  inline bool hmtNeighborMasks(const CompStrEltList &mhtSE,
+                               std::vector<UINT32> &fgMask,
+                               std::vector<UINT32> &bgMask)
+  {
+    size_t nSE = mhtSE.compSeList.size();
+
+    fgMask.resize(4 * nSE);
+    bgMask.resize(4 * nSE);
+    for (size_t k = 0; k < nSE; k++) {
+      const CompStrElt &cse = mhtSE.compSeList[k];
+      for (int par = 0; par < 4; par++) {
+        if (!hmtNeighborMask(cse.fgSE, par & 1, par >> 1,
+                             fgMask[4 * k + par]) ||
+            !hmtNeighborMask(cse.bgSE, par & 1, par >> 1,
+                             bgMask[4 * k + par]))
+          return false;
+      }
+    }
+    return true;
+  }
+
+  /*
+   * Images only made of min and max values, with an unsigned integer type,
+   * on which the hit-or-miss reduces to bit mask tests.
+   */
+  template <class T>
+  bool hmtIsBinary(const Image<T> &im)
+  {
+    if (std::numeric_limits<T>::is_signed ||
+        !std::numeric_limits<T>::is_integer)
+      return false;
+
+    typename ImDtTypes<T>::lineType pixels = im.getPixels();
+    size_t                          nPix   = im.getPixelCount();
+    for (size_t i = 0; i < nPix; i++)
+      if (pixels[i] != ImDtTypes<T>::min() && pixels[i] != ImDtTypes<T>::max())
+        return false;
+    return true;
+  }
+
+  /*
+   * 3x3x3 neighborhood of the pixels of a binary image : the neighbors
+   * inside the image and those in the foreground, with the bit layout of
+   * hmtNeighborMask(). Only the slices with bits in "need" are read.
+   */
+  template <class T>
+  class HmtNeighborhood
+  {
+  public:
+    HmtNeighborhood(const Image<T> &im)
+    {
+      pixels    = im.getPixels();
+      W         = im.getWidth();
+      H         = im.getHeight();
+      D         = im.getDepth();
+      sliceSize = size_t(W) * H;
+    }
+
+    void get(size_t o, int x, int y, int z, UINT32 need, UINT32 &inside,
+             UINT32 &on) const
+    {
+      const T vMax  = ImDtTypes<T>::max();
+      UINT32  rowIn = 2 | (x > 0) | ((x < W - 1) << 2);
+
+      inside = on = 0;
+      for (int dz = -1; dz <= 1; dz++) {
+        if (!((need >> (9 * (dz + 1))) & 0x1FF) || z + dz < 0 || z + dz >= D)
+          continue;
+        for (int dy = -1; dy <= 1; dy++) {
+          if (y + dy < 0 || y + dy >= H)
+            continue;
+          const T *row  = pixels + o + dy * W + dz * sliceSize;
+          UINT32   bits = (x > 0 && row[-1] == vMax) |
+                        ((row[0] == vMax) << 1) |
+                        ((x < W - 1 && row[1] == vMax) << 2);
+          int shift = 12 + 3 * dy + 9 * dz;
+          inside |= rowIn << shift;
+          on |= bits << shift;
+        }
+      }
+    }
+
+    typename ImDtTypes<T>::lineType pixels;
+    int                             W, H, D;
+    size_t                          sliceSize;
+  };
+
+  /*
+   * Hit-or-miss of a binary image by a whole list of composite SEs, in a
+   * single pass.
+   *
+   * In 2D, the 3x3 neighborhood of a pixel is packed into a 9 bit code,
+   * updated column by column along the lines, and a table of 512 entries
+   * compiled from the whole list tells whether any of the SEs matches. In 3D
+   * and on the image borders, the 27 bit neighborhood is tested against the
+   * masks of each SE.
+   *
+   * Returns false, without touching imOut, when the image isn't binary, when
+   * borderVal is neither min nor max or when an SE doesn't fit in a 3x3x3
+   * neighborhood.
+   */
+  template <class T>
+  bool hitOrMissLUT(const Image<T> &imIn, const CompStrEltList &mhtSE,
+                    Image<T> &imOut, T borderVal)
+  {
+    const T vMin = ImDtTypes<T>::min();
+    const T vMax = ImDtTypes<T>::max();
+
+    size_t nSE = mhtSE.compSeList.size();
+    if (nSE == 0 || (borderVal != vMin && borderVal != vMax))
+      return false;
+
+    std::vector<UINT32> fgMask, bgMask;
+    if (!hmtNeighborMasks(mhtSE, fgMask, bgMask) || !hmtIsBinary(imIn))
+      return false;
+
+    // Pixels outside the image match both SEs when the border is max
+    bool borderMax = borderVal == vMax;
+
+    Image<T> *imCopy = NULL;
+    if (&imIn == &imOut)
+      imCopy = new Image<T>(imIn, true); // clone
+    const Image<T> &imSrc = imCopy ? *imCopy : imIn;
+
+    HmtNeighborhood<T> nb(imSrc);
+    int                W = nb.W, H = nb.H, D = nb.D;
+
+    // 2D table, indexed by columns : bit 3 * (dx + 1) + (dy + 1)
+    std::vector<UINT8> lut;
+    bool               useLut = D == 1 && W >= 3 && H >= 3;
+    if (useLut) {
+      lut.assign(2 * 512, 0);
+      for (int par = 0; par < 2; par++) {
+        for (size_t k = 0; k < nSE; k++) {
+          UINT32 fg = fgMask[4 * k + par], bg = bgMask[4 * k + par];
+          if (!borderMax && ((fg | bg) & ~UINT32(0x3FE00)))
+            continue;
+          UINT32 fgCols = 0, bgCols = 0;
+          for (int dy = -1; dy <= 1; dy++)
+            for (int dx = -1; dx <= 1; dx++) {
+              UINT32 bit = UINT32(1) << (13 + dx + 3 * dy);
+              UINT32 col = UINT32(1) << (4 + 3 * dx + dy);
+              if (fg & bit)
+                fgCols |= col;
+              if (bg & bit)
+                bgCols |= col;
+            }
+          for (UINT32 code = 0; code < 512; code++)
+            if ((code & fgCols) == fgCols && (~code & bgCols) == bgCols)
+              lut[par * 512 + code] = 1;
+        }
+      }
+    }
+
+    typename ImDtTypes<T>::lineType pixIn  = imSrc.getPixels();
+    typename ImDtTypes<T>::lineType pixOut = imOut.getPixels();
+
+    int nLines = H * D;
+    int l;
+
+#ifdef USE_OPEN_MP
+    int nthreads = Core::getInstance()->getNumberOfThreads();
+#pragma omp parallel for num_threads(nthreads)
+#endif // USE_OPEN_MP
+    for (l = 0; l < nLines; l++) {
+      int    y    = l % H;
+      int    z    = l / H;
+      size_t o    = size_t(l) * W;
+      T     *lOut = pixOut + o;
+
+      bool lutLine = useLut && y > 0 && y < H - 1;
+      if (lutLine) {
+        const T     *r0  = pixIn + o - W;
+        const T     *r1  = pixIn + o;
+        const T     *r2  = pixIn + o + W;
+        const UINT8 *tab = &lut[(y & 1) * 512];
+
+        UINT32 code = (r0[0] == vMax) | ((r1[0] == vMax) << 1) |
+                      ((r2[0] == vMax) << 2) | ((r0[1] == vMax) << 3) |
+                      ((r1[1] == vMax) << 4) | ((r2[1] == vMax) << 5);
+        for (int x = 1; x < W - 1; x++) {
+          code |= ((r0[x + 1] == vMax) | ((r1[x + 1] == vMax) << 1) |
+                   ((r2[x + 1] == vMax) << 2))
+                  << 6;
+          lOut[x] = tab[code] ? vMax : vMin;
+          code >>= 3;
+        }
+      }
+
+      // Whole line, or its first and last pixels
+      int par = (y & 1) + 2 * (z & 1);
+      for (int x = 0; x < W; x += lutLine ? W - 1 : 1) {
+        UINT32 inside, on;
+        nb.get(o + x, x, y, z, 0x7FFFFFF, inside, on);
+        UINT32 out   = borderMax ? ~inside : 0;
+        bool   match = false;
+        for (size_t k = 0; k < nSE && !match; k++) {
+          UINT32 fg = fgMask[4 * k + par], bg = bgMask[4 * k + par];
+          match     = ((on | out) & fg) == fg &&
+                  (((inside & ~on) | out) & bg) == bg;
+        }
+        lOut[x] = match ? vMax : vMin;
+      }
+    }
+
+    if (imCopy)
+      delete imCopy;
+
+    return true;
+  }
+  /** @endcond */
+
   /**
    * hitOrMiss() - Hit Or Miss transform
    *
@@ -74,9 +321,13 @@ namespace smil
     ASSERT_ALLOCATED(&imIn, &imOut);
     ASSERT_SAME_SIZE(&imIn, &imOut);
 
+    ImageFreezer freezer(imOut);
+    if (hitOrMissLUT(imIn, CompStrEltList(CompStrElt(foreSE, backSE)), imOut,
+                     borderVal))
+      return RES_OK;
+
     Image<T> tmpIm(imIn);
     ASSERT_ALLOCATED(&tmpIm);
-    ImageFreezer freezer(imOut);
     ASSERT((inv<T>(imIn, tmpIm) == RES_OK));
     ASSERT((erode(tmpIm, imOut, backSE, borderVal) == RES_OK));
     ASSERT((erode(imIn, tmpIm, foreSE, borderVal) == RES_OK));
@@ -106,6 +357,11 @@ namespace smil
   /**
    * hitOrMiss() - Hit Or Miss transform
    *
+   * @note
+   * On binary images (@b 0 and max value of the data type), with composite
+   * SEs fitting in a 3x3x3 neighborhood, all the SEs of the list are matched
+   * in a single pass over the image, with a lookup table in 2D.
+   *
    * @param[in] imIn : input image
    * @param[in] mhtSE : vector with composite structuring elements with both
    * foreground and background structuring elements
@@ -121,10 +377,13 @@ namespace smil
     ASSERT_ALLOCATED(&imIn, &imOut);
     ASSERT_SAME_SIZE(&imIn, &imOut);
 
+    ImageFreezer freezer(imOut);
+    if (hitOrMissLUT(imIn, mhtSE, imOut, borderVal))
+      return RES_OK;
+
     Image<T> tmpIm(imIn);
     ASSERT_ALLOCATED(&tmpIm);
 
-    ImageFreezer freezer(imOut);
     ASSERT((fill(imOut, ImDtTypes<T>::min()) == RES_OK));
     for (std::vector<CompStrElt>::const_iterator it = mhtSE.compSeList.begin();
          it != mhtSE.compSeList.end(); it++) {
@@ -287,6 +546,128 @@ namespace smil
     return RES_OK;
   }
 
+  /** @cond */
+  /*
+   * fullThin() and fullThick() of a binary image with lists of active pixels.
+   *
+   * A pixel can only match a composite SE again if one of its 3x3x3 neighbors
+   * changed since this SE was last applied. Each pass thus only visits the
+   * neighbors of the pixels changed during the previous sweep over the list,
+   * and the iterations stop once a whole sweep changed nothing. Each
+   * composite SE is matched with two bit masks of the neighborhood.
+   *
+   * Returns false, without touching imOut, when the image isn't binary or
+   * when an SE doesn't fit in a 3x3x3 neighborhood.
+   */
+  template <class T>
+  bool fullThinThickActive(const Image<T> &imIn, const CompStrEltList &mhtSE,
+                           Image<T> &imOut, bool thickening)
+  {
+    size_t nSE = mhtSE.compSeList.size();
+    if (nSE == 0)
+      return false;
+
+    std::vector<UINT32> fgMask, bgMask;
+    if (!hmtNeighborMasks(mhtSE, fgMask, bgMask) || !hmtIsBinary(imIn))
+      return false;
+
+    const T vMin = ImDtTypes<T>::min();
+    const T vMax = ImDtTypes<T>::max();
+    size_t  nPix = imIn.getPixelCount();
+
+    copy(imIn, imOut);
+    typename ImDtTypes<T>::lineType pix = imOut.getPixels();
+    HmtNeighborhood<T>              nb(imOut);
+
+    // Thinnings remove foreground pixels, thickenings add some
+    const T vFrom = thickening ? vMin : vMax;
+    const T vTo   = thickening ? vMax : vMin;
+
+    int    W         = imIn.getWidth();
+    int    H         = imIn.getHeight();
+    int    D         = imIn.getDepth();
+    size_t sliceSize = size_t(W) * H;
+
+    // changed[k] : pixels changed the last time the k-th SE was applied
+    std::vector<std::vector<size_t>> changed(nSE);
+    size_t                           idlePasses = 0;
+
+    // The first sweep sees every pixel and is done on whole lines
+    {
+      Image<T>                        imPass(imIn);
+      typename ImDtTypes<T>::lineType pixPass = imPass.getPixels();
+      for (size_t k = 0; k < nSE; k++) {
+        const CompStrElt &cse = mhtSE.compSeList[k];
+        if (thickening)
+          thick(imOut, cse.fgSE, cse.bgSE, imPass);
+        else
+          thin(imOut, cse.fgSE, cse.bgSE, imPass);
+        for (size_t i = 0; i < nPix; i++)
+          if (pixPass[i] != pix[i]) {
+            pix[i] = pixPass[i];
+            changed[k].push_back(i);
+          }
+        idlePasses = changed[k].empty() ? idlePasses + 1 : 0;
+      }
+    }
+
+    std::vector<UINT32> stamp(nPix, 0);
+    std::vector<size_t> active, matches;
+
+    for (size_t pass = nSE; idlePasses < nSE; pass++) {
+      size_t k   = pass % nSE;
+      UINT32 tag = UINT32(pass);
+
+      active.clear();
+      for (size_t j = 0; j < nSE; j++) {
+        const std::vector<size_t> &lst = changed[j];
+        for (size_t i = 0; i < lst.size(); i++) {
+          int x = lst[i] % W;
+          int y = (lst[i] / W) % H;
+          int z = lst[i] / sliceSize;
+          for (int zz = std::max(z - 1, 0); zz <= std::min(z + 1, D - 1); zz++)
+            for (int yy = std::max(y - 1, 0); yy <= std::min(y + 1, H - 1);
+                 yy++)
+              for (int xx = std::max(x - 1, 0); xx <= std::min(x + 1, W - 1);
+                   xx++) {
+                size_t n = xx + yy * size_t(W) + zz * sliceSize;
+                if (stamp[n] != tag && pix[n] == vFrom) {
+                  stamp[n] = tag;
+                  active.push_back(n);
+                }
+              }
+        }
+      }
+
+      // All the matches are found before any pixel changes
+      matches.clear();
+      for (size_t i = 0; i < active.size(); i++) {
+        size_t o = active[i];
+        int    x = o % W;
+        int    y = (o / W) % H;
+        int    z = o / sliceSize;
+
+        int    par = (y & 1) + 2 * (z & 1);
+        UINT32 fg  = fgMask[4 * k + par];
+        UINT32 bg  = bgMask[4 * k + par];
+
+        UINT32 inside, on;
+        nb.get(o, x, y, z, fg | bg, inside, on);
+        if ((on & fg) == fg && (inside & ~on & bg) == bg)
+          matches.push_back(o);
+      }
+
+      for (size_t i = 0; i < matches.size(); i++)
+        pix[matches[i]] = vTo;
+      changed[k].swap(matches);
+
+      idlePasses = changed[k].empty() ? idlePasses + 1 : 0;
+    }
+
+    return true;
+  }
+  /** @endcond */
+
   /**
    * fullThin() - Thinning transform (full)
    *
@@ -294,6 +675,11 @@ namespace smil
    * "stability" is defined when the volume of the output image remains stops
    * changing (@TI{idempotence}).
    *
+   * @note
+   * On binary images (@b 0 and max value of the data type) and composite SEs
+   * fitting in a 3x3x3 neighborhood, only the pixels around the last changes
+   * are checked at each iteration.
+   *
    * @param[in] imIn : input image
    * @param[in] mhtSE : vector with composite structuring elements with both
    * foreground and background structuring elements
@@ -308,6 +694,9 @@ namespace smil
 
     ImageFreezer freezer(imOut);
 
+    if (fullThinThickActive(imIn, mhtSE, imOut, false))
+      return RES_OK;
+
     double v1, v2;
     ASSERT((thin<T>(imIn, mhtSE, imOut) == RES_OK));
     v1 = vol(imOut);
@@ -362,6 +751,10 @@ namespace smil
    * "stability" is defined when the volume of the output image remains stops
    * changing (@TI{idempotence}).
    *
+   * @note
+   * As for fullThin(), binary images are processed only around the last
+   * changes.
+   *
    * @param[in] imIn : input image
    * @param[in] mhtSE : vector with composite structuring elements with both
    * foreground and background structuring elements
@@ -375,7 +768,11 @@ namespace smil
     ASSERT_SAME_SIZE(&imIn, &imOut);
 
     ImageFreezer freezer(imOut);
-    double       v1, v2;
+
+    if (fullThinThickActive(imIn, mhtSE, imOut, true))
+      return RES_OK;
+
+    double v1, v2;
     ASSERT((thick<T>(imIn, mhtSE, imOut) == RES_OK));
     v1 = vol(imOut);
     while (true) {
@@ -0,0 +1,580 @@
+/* __HEAD__
+ * Copyright (c) 2011-2016, Matthieu FAESSEL and ARMINES
+ * Copyright (c) 2017-2024, Centre de Morphologie Mathematique
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of Matthieu FAESSEL, or ARMINES nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Description :
+ *   Persistent component tree (max-tree or min-tree), built once and
+ *   filtered many times
+ *
+ * History :
+ *   - 19/10/2026
+ *     First implementation, on top of the parallel union-find max-tree
+ *     builder
+ *
+ * __HEAD__ - Stop here !
+ */
+
+#ifndef _D_MORPHO_COMPONENT_TREE_HPP
+#define _D_MORPHO_COMPONENT_TREE_HPP
+
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "DMorphoMaxTree.hpp"
+
+#ifdef USE_OPEN_MP
+#include <omp.h>
+#endif // USE_OPEN_MP
+
+namespace smil
+{
+  /**
+   * @addtogroup MaxTree
+   *
+   * @{
+   */
+
+  /**
+   * Component tree of an image : max-tree (connected components of upper
+   * level sets) or min-tree (connected components of lower level sets).
+   *
+   * The tree is built once and can then be filtered many times, at different
+   * thresholds or with different attributes, each filtering only touching
+   * the nodes. The filtered image is rebuilt with reconstruct().
+   *
+   * Nodes are stored in topological order, the root first : the parent of a
+   * node always comes before it. Each node is described by its parent and
+   * its level, in separate arrays.
+   *
+   * Available attributes (computed on demand and cached) :
+   * - @b area : number of pixels of the component;
+   * - @b volume : sum, over the pixels of the component, of the absolute
+   *   difference between their value and the level of the parent node;
+   * - @b contrast : highest absolute difference between the value of a pixel
+   *   of the component and the level of the parent node;
+   * - @b width, @b height, @b depth : extent of the bounding box of the
+   *   component along @b x, @b y and @b z;
+   * - @b dynamics : dynamics of the extremum the component leads to, i.e.
+   *   the height to climb (to descend, for a max-tree) from its most extreme
+   *   level before reaching a more extreme component. All the nodes of a
+   *   branch share it, the branch of the global extremum getting the range
+   *   of the data type.
+   *
+   * The h-extrema at any height can then be read from the tree with
+   * hExtrema(), without any reconstruction.
+   *
+   * The @b height and @b width attributes of a max-tree correspond to
+   * heightOpen() and widthOpen().
+   *
+   * @b Example
+   * @code{.py}
+   *   import smilPython as sp
+   *
+   *   im = sp.Image("https://smil.cmm.minesparis.psl.eu/images/barbara.png")
+   *   imOut = sp.Image(im)
+   *
+   *   tree = sp.ComponentTree(im)
+   *   for size in [10, 100, 1000]:
+   *     tree.filter("area", size)
+   *     tree.reconstruct(imOut)
+   * @endcode
+   *
+   * @see areaOpen(), heightOpen(), widthOpen(), hMinima(), hMaxima()
+   */
+  template <class T>
+  class ComponentTree
+  {
+  public:
+    ComponentTree() : maxTree(true), pixelCount(0), filtered(false)
+    {
+      imSize[0] = imSize[1] = imSize[2] = 0;
+    }
+
+    /**
+     * Build the component tree of an image
+     *
+     * @param[in] imIn : input image
+     * @param[in] maxTree : @b true for a max-tree, @b false for a min-tree
+     * @param[in] se : structuring element giving the connectivity
+     */
+    ComponentTree(const Image<T> &imIn, bool maxTree = true,
+                  const StrElt &se = DEFAULT_SE)
+        : maxTree(true), pixelCount(0), filtered(false)
+    {
+      imSize[0] = imSize[1] = imSize[2] = 0;
+      build(imIn, maxTree, se);
+    }
+
+    /**
+     * Build the component tree of an image
+     *
+     * @param[in] imIn : input image
+     * @param[in] maxTree : @b true for a max-tree, @b false for a min-tree
+     * @param[in] se : structuring element giving the connectivity
+     */
+    RES_T build(const Image<T> &imIn, bool maxTree = true,
+                const StrElt &se = DEFAULT_SE)
+    {
+      ASSERT_ALLOCATED(&imIn);
+      ASSERT(imIn.getPixelCount() < size_t(ImDtTypes<UINT32>::max()),
+             "Image is too big", RES_ERR);
+
+      this->maxTree = maxTree;
+      imIn.getSize(imSize);
+      pixelCount = imIn.getPixelCount();
+
+      typename ImDtTypes<T>::lineType pix = imIn.getPixels();
+
+      std::vector<UINT32> parent;
+      {
+        MaxTreeUnionFind<T, UINT32> uf(imIn, se, !maxTree);
+        uf.build(parent);
+      }
+
+      // Canonical pixels, root first
+      std::vector<UINT32> canonicals;
+      for (size_t p = 0; p < pixelCount; p++)
+        if (parent[p] == p || pix[parent[p]] != pix[p])
+          canonicals.push_back(p);
+      {
+        std::vector<UINT32> tmp(canonicals.size());
+        sortOffsetsByValue(pix, canonicals.data(), canonicals.size(),
+                           tmp.data());
+      }
+      if (!maxTree)
+        std::reverse(canonicals.begin(), canonicals.end());
+
+      size_t nodeCount = canonicals.size();
+      pixelNode.resize(pixelCount);
+      nodeParent.resize(nodeCount);
+      nodeLevel.resize(nodeCount);
+
+      for (size_t i = 0; i < nodeCount; i++)
+        pixelNode[canonicals[i]] = UINT32(i);
+      for (size_t i = 0; i < nodeCount; i++) {
+        size_t c      = canonicals[i];
+        nodeParent[i] = pixelNode[parent[c]];
+        nodeLevel[i]  = pix[c];
+      }
+
+      size_t p;
+#ifdef USE_OPEN_MP
+      int nthreads = Core::getInstance()->getNumberOfThreads();
+#pragma omp parallel for num_threads(nthreads)
+#endif // USE_OPEN_MP
+      for (p = 0; p < pixelCount; p++) {
+        if (parent[p] != p && pix[parent[p]] == pix[p])
+          pixelNode[p] = pixelNode[parent[p]];
+      }
+
+      attributes.clear();
+      nodeOut.clear();
+      filtered = false;
+
+      return RES_OK;
+    }
+
+    /**
+     * @b true for a max-tree, @b false for a min-tree
+     */
+    bool isMaxTree() const
+    {
+      return maxTree;
+    }
+
+    /**
+     * Number of nodes of the tree
+     */
+    size_t getNodeCount() const
+    {
+      return nodeLevel.size();
+    }
+
+    /**
+     * Values of an attribute, for each node
+     *
+     * @param[in] attribute : @b area, @b volume, @b contrast, @b width,
+     * @b height, @b depth or @b dynamics
+     * @returns an empty vector if the attribute is unknown
+     */
+    std::vector<double> getAttribute(const std::string &attribute)
+    {
+      const std::vector<double> *values = attributeValues(attribute);
+      if (values == NULL)
+        return std::vector<double>();
+      return *values;
+    }
+
+    /**
+     * Filter the tree : nodes whose attribute is lower than @b threshold
+     * are removed, their pixels taking the level of an ancestor. The root is
+     * never removed.
+     *
+     * Each call starts from the original tree, so the same tree can be
+     * filtered at several thresholds.
+     *
+     * @param[in] attribute : @b area, @b volume, @b contrast, @b width,
+     * @b height, @b depth or @b dynamics
+     * @param[in] threshold : smallest attribute value of kept nodes
+     * @param[in] rule : filtering rule, for non increasing attributes :
+     * - @b direct : only nodes failing the criterion are removed;
+     * - @b min : nodes with a removed ancestor are also removed;
+     * - @b max : nodes with a kept descendant are also kept;
+     * - @b subtractive : as @b direct, but the descendants of removed nodes
+     *   are shifted by the contrast of the removed nodes.
+     *
+     * For increasing attributes (e.g. @b area), @b direct, @b min and
+     * @b max give the same result.
+     */
+    RES_T filter(const std::string &attribute, double threshold,
+                 const std::string &rule = "direct")
+    {
+      ASSERT(!nodeLevel.empty(), "Tree not built", RES_ERR);
+
+      const std::vector<double> *values = attributeValues(attribute);
+      ASSERT(values != NULL, "Unknown attribute", RES_ERR);
+
+      ASSERT(rule == "direct" || rule == "min" || rule == "max" ||
+                 rule == "subtractive",
+             "Unknown filtering rule : " + rule, RES_ERR);
+
+      size_t               nodeCount = nodeLevel.size();
+      std::vector<UINT8>   keep(nodeCount);
+      const double        *attr = values->data();
+      for (size_t i = 0; i < nodeCount; i++)
+        keep[i] = nodeParent[i] == i || attr[i] >= threshold;
+
+      if (rule == "min") {
+        for (size_t i = 0; i < nodeCount; i++)
+          keep[i] = keep[i] && keep[nodeParent[i]];
+      } else if (rule == "max") {
+        for (size_t i = nodeCount; i-- > 0;)
+          if (keep[i])
+            keep[nodeParent[i]] = 1;
+      }
+
+      nodeOut.resize(nodeCount);
+      if (rule == "subtractive") {
+        for (size_t i = 0; i < nodeCount; i++) {
+          UINT32 par = nodeParent[i];
+          if (par == i)
+            nodeOut[i] = nodeLevel[i];
+          else if (keep[i])
+            nodeOut[i] = T(double(nodeOut[par]) + double(nodeLevel[i]) -
+                           double(nodeLevel[par]));
+          else
+            nodeOut[i] = nodeOut[par];
+        }
+      } else {
+        for (size_t i = 0; i < nodeCount; i++)
+          nodeOut[i] = keep[i] ? nodeLevel[i] : nodeOut[nodeParent[i]];
+      }
+      filtered = true;
+
+      return RES_OK;
+    }
+
+    /**
+     * Image of the filtered tree (of the tree itself if it wasn't
+     * filtered) : each pixel takes the output level of its node.
+     *
+     * @param[out] imOut : output image, with the same size as the input
+     * image
+     */
+    RES_T reconstruct(Image<T> &imOut)
+    {
+      ASSERT(!nodeLevel.empty(), "Tree not built", RES_ERR);
+      ASSERT_ALLOCATED(&imOut);
+      ASSERT(imOut.getWidth() == imSize[0] && imOut.getHeight() == imSize[1] &&
+                 imOut.getDepth() == imSize[2],
+             "Output image size differs from the tree image size", RES_ERR);
+
+      ImageFreezer freeze(imOut);
+
+      const T *out = filtered ? nodeOut.data() : nodeLevel.data();
+
+      typename ImDtTypes<T>::lineType pixOut = imOut.getPixels();
+
+      size_t p;
+#ifdef USE_OPEN_MP
+      int nthreads = Core::getInstance()->getNumberOfThreads();
+#pragma omp parallel for num_threads(nthreads)
+#endif // USE_OPEN_MP
+      for (p = 0; p < pixelCount; p++)
+        pixOut[p] = out[pixelNode[p]];
+
+      return RES_OK;
+    }
+
+    /**
+     * h-extrema of the image : h-maxima with a max-tree, h-minima with a
+     * min-tree. Same result as hMaxima() and hMinima().
+     *
+     * The extrema surviving at height @b h are those with a @b dynamics
+     * greater than @b h. Each one is marked on the node whose level range
+     * contains its most extreme level shifted by @b h. Once the tree is
+     * built, each height only costs a pass on the nodes and one on the
+     * pixels.
+     *
+     * @param[in] height : height @b h
+     * @param[out] imOut : output image, with the same size as the input
+     * image : max on the h-extrema, min elsewhere
+     */
+    RES_T hExtrema(double height, Image<T> &imOut)
+    {
+      ASSERT(!nodeLevel.empty(), "Tree not built", RES_ERR);
+      ASSERT_ALLOCATED(&imOut);
+      ASSERT(imOut.getWidth() == imSize[0] && imOut.getHeight() == imSize[1] &&
+                 imOut.getDepth() == imSize[2],
+             "Output image size differs from the tree image size", RES_ERR);
+
+      ImageFreezer freeze(imOut);
+
+      const std::vector<double> &dynamics = *attributeValues("dynamics");
+
+      std::vector<T> extreme;
+      subtreeExtremes(extreme);
+
+      // Levels of the h-reconstruction saturate at the bound of the type.
+      // As with minima() and maxima(), saturated extrema are not reported.
+      double bound = maxTree ? double(ImDtTypes<T>::min())
+                             : double(ImDtTypes<T>::max());
+      double sign  = maxTree ? 1. : -1.;
+
+      size_t             nodeCount = nodeLevel.size();
+      std::vector<UINT8> marked(nodeCount, 0);
+      for (size_t i = 0; i < nodeCount; i++) {
+        UINT32 par = nodeParent[i];
+        if (par != i && marked[par]) {
+          marked[i] = 1;
+          continue;
+        }
+        if (!(dynamics[i] > height))
+          continue;
+
+        // Level of the h-reconstruction on the extremum of the node
+        double cut = double(extreme[i]) - sign * height;
+        if (sign * (cut - bound) <= 0.)
+          continue;
+        marked[i] = sign * double(nodeLevel[i]) >= sign * cut &&
+                    (par == i || sign * double(nodeLevel[par]) < sign * cut);
+      }
+
+      T fgVal = ImDtTypes<T>::max();
+      T bgVal = ImDtTypes<T>::min();
+
+      typename ImDtTypes<T>::lineType pixOut = imOut.getPixels();
+
+      size_t p;
+#ifdef USE_OPEN_MP
+      int nthreads = Core::getInstance()->getNumberOfThreads();
+#pragma omp parallel for num_threads(nthreads)
+#endif // USE_OPEN_MP
+      for (p = 0; p < pixelCount; p++)
+        pixOut[p] = marked[pixelNode[p]] ? fgVal : bgVal;
+
+      return RES_OK;
+    }
+
+  private:
+    bool   maxTree;
+    size_t imSize[3];
+    size_t pixelCount;
+    bool   filtered;
+
+    std::vector<UINT32> pixelNode;
+    std::vector<UINT32> nodeParent;
+    std::vector<T>      nodeLevel;
+    std::vector<T>      nodeOut;
+
+    std::map<std::string, std::vector<double>> attributes;
+
+    /*
+     * Cached attribute values, computed on first request
+     */
+    const std::vector<double> *attributeValues(const std::string &name)
+    {
+      typename std::map<std::string, std::vector<double>>::iterator it =
+          attributes.find(name);
+      if (it != attributes.end())
+        return &it->second;
+
+      std::vector<double> values;
+      if (name == "area")
+        computeArea(values);
+      else if (name == "volume")
+        computeVolume(values);
+      else if (name == "contrast")
+        computeContrast(values);
+      else if (name == "width")
+        computeExtent(0, values);
+      else if (name == "height")
+        computeExtent(1, values);
+      else if (name == "depth")
+        computeExtent(2, values);
+      else if (name == "dynamics")
+        computeDynamics(values);
+      else
+        return NULL;
+
+      std::vector<double> &stored = attributes[name];
+      stored.swap(values);
+      return &stored;
+    }
+
+    // Accumulate children attributes into their parents, bottom-up
+    void sumUp(std::vector<double> &values)
+    {
+      for (size_t i = values.size(); i-- > 1;)
+        if (nodeParent[i] != i)
+          values[nodeParent[i]] += values[i];
+    }
+
+    void computeArea(std::vector<double> &area)
+    {
+      area.assign(nodeLevel.size(), 0.);
+      for (size_t p = 0; p < pixelCount; p++)
+        area[pixelNode[p]] += 1.;
+      sumUp(area);
+    }
+
+    void computeVolume(std::vector<double> &volume)
+    {
+      const std::vector<double> &area = *attributeValues("area");
+
+      // Sum of the pixel values of each component
+      size_t nodeCount = nodeLevel.size();
+      volume.assign(nodeCount, 0.);
+      for (size_t p = 0; p < pixelCount; p++)
+        volume[pixelNode[p]] += double(nodeLevel[pixelNode[p]]);
+      sumUp(volume);
+
+      for (size_t i = 0; i < nodeCount; i++)
+        volume[i] =
+            std::fabs(volume[i] - area[i] * double(nodeLevel[nodeParent[i]]));
+    }
+
+    // Most extreme level of each subtree
+    void subtreeExtremes(std::vector<T> &extreme)
+    {
+      extreme = nodeLevel;
+      for (size_t i = extreme.size(); i-- > 1;) {
+        UINT32 par = nodeParent[i];
+        if (par == i)
+          continue;
+        if (maxTree ? extreme[i] > extreme[par] : extreme[i] < extreme[par])
+          extreme[par] = extreme[i];
+      }
+    }
+
+    void computeContrast(std::vector<double> &contrast)
+    {
+      size_t         nodeCount = nodeLevel.size();
+      std::vector<T> extreme;
+      subtreeExtremes(extreme);
+
+      contrast.resize(nodeCount);
+      for (size_t i = 0; i < nodeCount; i++)
+        contrast[i] = std::fabs(double(extreme[i]) -
+                                double(nodeLevel[nodeParent[i]]));
+    }
+
+    void computeDynamics(std::vector<double> &dynamics)
+    {
+      size_t         nodeCount = nodeLevel.size();
+      std::vector<T> extreme;
+      subtreeExtremes(extreme);
+
+      // Child of each node leading to its most extreme level : its branch
+      // goes on through the node, the branches of the other children end
+      // there.
+      std::vector<UINT32> heir(nodeCount);
+      for (size_t i = 0; i < nodeCount; i++)
+        heir[i] = UINT32(i);
+      for (size_t i = nodeCount; i-- > 1;) {
+        UINT32 par = nodeParent[i];
+        if (par == i)
+          continue;
+        if (heir[par] == par ||
+            (maxTree ? extreme[i] > extreme[heir[par]]
+                     : extreme[i] < extreme[heir[par]]))
+          heir[par] = UINT32(i);
+      }
+
+      double range =
+          double(ImDtTypes<T>::max()) - double(ImDtTypes<T>::min());
+
+      dynamics.resize(nodeCount);
+      for (size_t i = 0; i < nodeCount; i++) {
+        UINT32 par = nodeParent[i];
+        if (par == i)
+          dynamics[i] = range;
+        else if (heir[par] == i)
+          dynamics[i] = dynamics[par];
+        else
+          dynamics[i] =
+              std::fabs(double(nodeLevel[par]) - double(extreme[i]));
+      }
+    }
+
+    void computeExtent(int axis, std::vector<double> &extent)
+    {
+      size_t              nodeCount = nodeLevel.size();
+      std::vector<UINT32> cMin(nodeCount, ImDtTypes<UINT32>::max());
+      std::vector<UINT32> cMax(nodeCount, 0);
+
+      size_t p = 0;
+      for (size_t z = 0; z < imSize[2]; z++)
+        for (size_t y = 0; y < imSize[1]; y++)
+          for (size_t x = 0; x < imSize[0]; x++, p++) {
+            UINT32 c    = UINT32(axis == 0 ? x : axis == 1 ? y : z);
+            UINT32 node = pixelNode[p];
+            cMin[node]  = std::min(cMin[node], c);
+            cMax[node]  = std::max(cMax[node], c);
+          }
+
+      for (size_t i = nodeCount; i-- > 1;) {
+        UINT32 par = nodeParent[i];
+        if (par == i)
+          continue;
+        cMin[par] = std::min(cMin[par], cMin[i]);
+        cMax[par] = std::max(cMax[par], cMax[i]);
+      }
+
+      extent.resize(nodeCount);
+      for (size_t i = 0; i < nodeCount; i++)
+        extent[i] = double(cMax[i]) - double(cMin[i]) + 1.;
+    }
+  };
+
+  /** @} */
+} // namespace smil
+
+#endif // _D_MORPHO_COMPONENT_TREE_HPP
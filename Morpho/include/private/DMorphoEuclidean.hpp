@@ -33,6 +33,9 @@
  * History :
  *   - 04/03/2022 - by Jose-Marcio
  *     Euclidean Distance - based on Beatriz Marcotegui implementation
+ *   - 19/10/2026 - by agent
+ *     Exact separable Euclidean Distance (lower envelope of parabolas),
+ *     with anisotropic spacing and feature transform
  *
  * __HEAD__ - Stop here !
  */
@@ -40,192 +43,262 @@
 #ifndef _D_MORPHOEUCLIDEAN_HPP
 #define _D_MORPHOEUCLIDEAN_HPP
 
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#ifdef USE_OPEN_MP
+#include <omp.h>
+#endif // USE_OPEN_MP
+
 namespace smil
 {
+  /** @cond */
+  /*
+   * Exact separable Euclidean Distance Transform
+   *
+   * The squared distance is computed one dimension after the other, each
+   * pass being a 1D distance transform of a sampled function, evaluated as
+   * the lower envelope of the parabolas rooted at each sample (Felzenszwalb
+   * and Huttenlocher, Meijster et al.). Each pass is linear in the number
+   * of pixels and lines are processed in parallel.
+   *
+   * Pixel spacing may be different along each axis. When requested, the
+   * offset of the nearest background pixel (feature transform) is propagated
+   * along with the distance.
+   */
   class EuclideanFunctor
   {
   public:
-    EuclideanFunctor()
-    {
-    }
-
-    template <class T1, class T2>
-    RES_T _exec(const Image<T1> &imIn, Image<T2> &imOut,
-                const StrElt &se = DEFAULT_SE)
-    {
-      return _distance(imIn, imOut, se);
-    }
-
-  private:
-    double sqr(size_t x)
+    EuclideanFunctor(double sx = 1., double sy = 1., double sz = 1.)
     {
-      return x * x;
+      spacing[0] = sx;
+      spacing[1] = sy;
+      spacing[2] = sz;
     }
 
-    double sqModule(IntPoint &p1, IntPoint &p2)
+    /*
+     * Squared distance of each non zero pixel of imIn to the nearest zero
+     * pixel. If feature is not NULL, it receives the offset of this nearest
+     * zero pixel. Pixels without any zero pixel in the image get an infinite
+     * distance and an offset equal to the pixel count.
+     */
+    template <class T>
+    RES_T squaredDistance(const Image<T> &imIn, std::vector<double> &dist2,
+                          std::vector<size_t> *feature = NULL)
     {
-      return sqr(p1.x - p2.x) + sqr(p1.y - p2.y) + sqr(p1.z - p2.z);
+      ASSERT_ALLOCATED(&imIn);
+      ASSERT(spacing[0] > 0 && spacing[1] > 0 && spacing[2] > 0,
+             "Pixel spacing shall be positive", RES_ERR);
+
+      imIn.getSize(size);
+      pixelCount = imIn.getPixelCount();
+
+      dist2.resize(pixelCount);
+      if (feature != NULL)
+        feature->resize(pixelCount);
+
+      typename ImDtTypes<T>::lineType pixels = imIn.getPixels();
+
+      double *d2 = dist2.data();
+      size_t *ft = feature != NULL ? feature->data() : NULL;
+
+      size_t i;
+#ifdef USE_OPEN_MP
+      int nthreads = Core::getInstance()->getNumberOfThreads();
+#pragma omp parallel for private(i) num_threads(nthreads)
+#endif // USE_OPEN_MP
+      for (i = 0; i < pixelCount; i++) {
+        d2[i] = pixels[i] == T(0) ? 0. : INFINITY;
+        if (ft != NULL)
+          ft[i] = d2[i] == 0. ? i : pixelCount;
+      }
+
+      // One pass per dimension : lines along x, columns along y, then z
+      size_t strides[3] = {1, size[0], size[0] * size[1]};
+      for (int axis = 0; axis < 3; axis++) {
+        if (size[axis] > 1)
+          transformAxis(axis, strides, d2, ft);
+      }
+      return RES_OK;
     }
 
     template <class T1, class T2>
-    RES_T _distance(const Image<T1> &imIn, Image<T2> &imOut,
-                    const StrElt &se = DEFAULT_SE)
+    RES_T distance(const Image<T1> &imIn, Image<T2> &imOut,
+                   Image<UINT32> *imFeature = NULL)
     {
       ASSERT_ALLOCATED(&imIn, &imOut);
       ASSERT_SAME_SIZE(&imIn, &imOut);
+      if (imFeature != NULL) {
+        ASSERT_ALLOCATED(imFeature);
+        ASSERT_SAME_SIZE(&imIn, imFeature);
+        ASSERT(imIn.getPixelCount() < size_t(ImDtTypes<UINT32>::max()),
+               "Image is too big for an UINT32 feature image", RES_ERR);
+      }
 
       ImageFreezer freeze(imOut);
 
-      typedef Image<T1>                       imageInType;
-      typedef typename imageInType::lineType  lineInType;
-      typedef Image<T2>                       imageOutType;
-      typedef typename imageOutType::lineType lineOutType;
-
-      lineInType  pixelsIn  = imIn.getPixels();
-      lineOutType pixelsOut = imOut.getPixels();
-
-      HierarchicalQueue<T2, off_t> hq;
-
-      off_t              pixelCount = imIn.getPixelCount();
-      std::vector<off_t> pixelsOffset(pixelCount, 0);
-
-      StrElt seLoc = se.noCenter();
-
-      off_t maxOffset = pixelCount;
-
-      // INITIALIZE
-      // Pixels != 0 but with a 0 neighbor (contour pixels) are:
-      //  - pushed in the FAH
-      //  - out[p] = 1
-      //  - pixelOffset[p]=bckg neighbor
+      std::vector<double> dist2;
+      std::vector<size_t> feature;
+      ASSERT(squaredDistance(imIn, dist2,
+                             imFeature != NULL ? &feature : NULL) == RES_OK);
+
+      typename ImDtTypes<T2>::lineType pixelsOut = imOut.getPixels();
+
+      double maxVal = double(ImDtTypes<T2>::max());
+      size_t i;
+#ifdef USE_OPEN_MP
+      int nthreads = Core::getInstance()->getNumberOfThreads();
+#pragma omp parallel for private(i) num_threads(nthreads)
+#endif // USE_OPEN_MP
+      for (i = 0; i < pixelCount; i++) {
+        double d     = std::sqrt(dist2[i]);
+        pixelsOut[i] = d < maxVal ? T2(d) : ImDtTypes<T2>::max();
+      }
+
+      if (imFeature != NULL) {
+        ImageFreezer                         freezeFt(*imFeature);
+        typename ImDtTypes<UINT32>::lineType pixelsFt =
+            imFeature->getPixels();
+        for (i = 0; i < pixelCount; i++)
+          pixelsFt[i] = UINT32(feature[i]);
+      }
+      return RES_OK;
+    }
 
-      // pixelOffset: contains the closest bck pixel for each object pixel (for
-      // pixels with computed distance value)
-      //  maxOffset+1 for pixels not processed yet (or background pixels)
-      hq.initialize(imIn);
-      for (auto i = 0; i < pixelCount; i++) {
-        pixelsOffset[i] = maxOffset + 1;
-        if (pixelsIn[i] == T1(0))
+  private:
+    double spacing[3];
+    size_t size[3];
+    size_t pixelCount;
+
+    /*
+     * 1D distance transform of the sampled function f (n samples, with
+     * spacing s) : d[q] = min_p (s.(q - p))^2 + f[p]. arg[q] receives the
+     * minimizing p, or n if f is infinite everywhere.
+     */
+    void transform1D(const double *f, size_t n, double s, double *d,
+                     size_t *arg, size_t *v, double *z)
+    {
+      long k = -1;
+      for (size_t q = 0; q < n; q++) {
+        if (std::isinf(f[q]))
           continue;
-
-        IntPoint pt = imIn.getPointFromOffset(i);
-
-        bool oddLine = seLoc.odd && (pt.y % 2 != 0);
-
-        for (auto it = seLoc.points.begin(); it != seLoc.points.end(); it++) {
-          IntPoint ptSE = *it;
-          IntPoint ptNb = pt + ptSE;
-          off_t    ofNb;
-
-          if (oddLine && (ptNb.y + 1) % 2 != 0)
-            ptNb.x += 1;
-
-          if (imIn.isPointInImage(ptNb))
-            ofNb = imIn.getOffsetFromPoint(ptNb);
-          else
-            continue;
-
-          if (pixelsIn[ofNb] == 0) {
-            hq.push(T2(1), i);
-            pixelsOffset[i] = ofNb;
-            pixelsOut[i]    = 1;
+        double fq = f[q] + (s * q) * (s * q);
+        double r  = -INFINITY;
+        while (k >= 0) {
+          size_t p = v[k];
+          r = (fq - (f[p] + (s * p) * (s * p))) / (2. * s * (double(q) - p));
+          if (r > z[k])
             break;
-          }
+          k--;
         }
-      } // for each pixel
-
-      // #####################################
-
-      // Process hierarchical queue. Get a pixel(p0), find ngb without
-      // computed distance(p1), p2 is a ngb of p1. If p2 knows its
-      // distance, find p3 (the closest bckg pixel to p2) and compute
-      // distance (p1,p3). Keep the smallest distance to p1 and assign
-      // it. The origin of p1 is set, pixelsOffset[p1] is set to oo
-      // (the p3 leading to the smallest distance).
-
-      T2 T2_maxVal = ImDtTypes<T2>::max();
-
-      while (!hq.isEmpty()) {
-        off_t pCurr = hq.pop();
-        if (pixelsOffset[pCurr] > maxOffset) {
-          std::cout << "BAD PLACE, BAD TIME." << int(pCurr)
-                    << "goes out without pixelFrom\n";
-          continue;
+        if (k < 0)
+          r = -INFINITY;
+        k++;
+        v[k] = q;
+        z[k] = r;
+      }
+
+      if (k < 0) {
+        for (size_t q = 0; q < n; q++) {
+          d[q]   = INFINITY;
+          arg[q] = n;
         }
+        return;
+      }
+
+      z[k + 1] = INFINITY;
+      long j   = 0;
+      for (size_t q = 0; q < n; q++) {
+        double x = s * q;
+        while (z[j + 1] < x)
+          j++;
+        double dx = s * (double(q) - double(v[j]));
+        d[q]      = dx * dx + f[v[j]];
+        arg[q]    = v[j];
+      }
+    }
 
-        IntPoint ptCurr = imIn.getPointFromOffset(pCurr);
-
-        bool oddLine = seLoc.odd && (ptCurr.y % 2 != 0);
-        for (auto it1 = seLoc.points.begin(); it1 != seLoc.points.end();
-             it1++) {
-          IntPoint ptSe1 = *it1;
-          IntPoint pt1   = ptCurr + ptSe1;
-
-          if (oddLine && ((pt1.y + 1) % 2) != 0)
-            pt1.x += 1;
-
-          if (!imIn.isPointInImage(pt1))
-            continue;
-
-          off_t p1 = imIn.getOffsetFromPoint(pt1);
-
-          // non NULL input pixel, but without output value
-          // (PixelsOffset == maxOffset+1)
-          if ((pixelsIn[p1] == 0) || (pixelsOffset[p1] <= maxOffset))
-            continue;
-
-          int current_dist = ImDtTypes<int>::max(); // INFINITE!!!
-
-          off_t oo;
-          for (auto it2 = seLoc.points.begin(); it2 != seLoc.points.end();
-               it2++) {
-            IntPoint ptSe2 = *it2;
-            IntPoint pt2   = pt1 + ptSe2;
-
-            bool oddLine2 = seLoc.odd && (pt1.y % 2 != 0);
-            if (oddLine2 && (((pt2.y + 1) % 2) != 0))
-              pt2.x += 1;
-
-            if (!imIn.isPointInImage(pt2))
-              continue;
-
-            off_t p2 = imIn.getOffsetFromPoint(pt2);
-
-            if (pixelsOffset[p2] <= maxOffset) {
-              /* voisin de distance calculee */
-              off_t    p3  = pixelsOffset[p2];
-              IntPoint pt3 = imIn.getPointFromOffset(p3);
-
-              int wd = sqModule(pt1, pt3);
-              if (wd < current_dist) {
-                current_dist = wd;
-                oo           = p2;
-              }
-            } // if ngb knows its distance
-          } // for ngb
-          T2 pr1 = T2(std::sqrt(current_dist));
+    /*
+     * Apply the 1D transform to every line along an axis
+     */
+    void transformAxis(int axis, const size_t *strides, double *d2, size_t *ft)
+    {
+      size_t n      = size[axis];
+      size_t stride = strides[axis];
+      size_t nLines = pixelCount / n;
+      double s      = spacing[axis];
+
+      // Lines along the axis are indexed by the coordinates on the two
+      // other axes : line l starts at (l % inner) + (l / inner) * outer
+      size_t inner = stride;
+      size_t outer = stride * n;
+
+      size_t l;
+
+#ifdef USE_OPEN_MP
+      int nthreads = Core::getInstance()->getNumberOfThreads();
+#pragma omp parallel private(l) num_threads(nthreads)
+#endif // USE_OPEN_MP
+      {
+        std::vector<double> f(n), d(n), z(n + 1);
+        std::vector<size_t> arg(n), v(n), ftLine(ft != NULL ? n : 0);
+
+#ifdef USE_OPEN_MP
+#pragma omp for schedule(dynamic, 16)
+#endif // USE_OPEN_MP
+        for (l = 0; l < nLines; l++) {
+          size_t start = (l % inner) + (l / inner) * outer;
+
+          double *line = d2 + start;
+          for (size_t q = 0; q < n; q++)
+            f[q] = line[q * stride];
+
+          transform1D(f.data(), n, s, d.data(), arg.data(), v.data(),
+                      z.data());
+
+          for (size_t q = 0; q < n; q++)
+            line[q * stride] = d[q];
+
+          if (ft != NULL) {
+            size_t *ftl = ft + start;
+            for (size_t q = 0; q < n; q++)
+              ftLine[q] = ftl[q * stride];
+            for (size_t q = 0; q < n; q++)
+              ftl[q * stride] = arg[q] < n ? ftLine[arg[q]] : pixelCount;
+          }
+        }
+      }
+    }
+  };
+  /** @endcond */
 
-          if (pr1 > T2_maxVal)
-            pr1 = T2_maxVal;
+  template <class T1, class T2>
+  RES_T distanceEuclidean(const Image<T1> &imIn, Image<T2> &imOut,
+                          SMIL_UNUSED const StrElt &se)
+  {
+    EuclideanFunctor func;
 
-          hq.push(pr1, p1);
+    return func.distance(imIn, imOut);
+  }
 
-          pixelsOut[p1]    = pr1;
-          pixelsOffset[p1] = pixelsOffset[oo];
-        } // for each ngb of p
-      } // while ! EMPTY
+  template <class T1, class T2>
+  RES_T distanceEuclidean(const Image<T1> &imIn, Image<T2> &imOut,
+                          double sx, double sy, double sz)
+  {
+    EuclideanFunctor func(sx, sy, sz);
 
-      return RES_OK;
-    } // END euclidian_distance
-  };
+    return func.distance(imIn, imOut);
+  }
 
   template <class T1, class T2>
-  RES_T distanceEuclidean(const Image<T1> &imIn, Image<T2> &imOut,
-                          const StrElt &se)
+  RES_T distanceEuclideanFeature(const Image<T1> &imIn, Image<T2> &imOut,
+                                 Image<UINT32> &imFeature, double sx,
+                                 double sy, double sz)
   {
-    EuclideanFunctor func;
+    EuclideanFunctor func(sx, sy, sz);
 
-    return func._exec(imIn, imOut, se);
+    return func.distance(imIn, imOut, &imFeature);
   }
 
 } // namespace smil
@@ -30,8 +30,12 @@
 #ifndef _D_MORPHO_EXTREMA_HPP
 #define _D_MORPHO_EXTREMA_HPP
 
+#include <limits>
+#include <vector>
+
 #include "DMorphoGeodesic.hpp"
 #include "DMorphoArrow.hpp"
+#include "DMorphoComponentTree.hpp"
 
 namespace smil
 {
@@ -43,9 +47,94 @@ namespace smil
 
   // Extrema
 
+  /** @cond */
+  /*
+   * Regional extrema by union-find on the flat zones : a single scan joins
+   * each pixel to its neighbors of same value and flags those having a
+   * lower (higher, for maxima) neighbor. Zones free of flags are the
+   * regional extrema. As with the reconstruction by minima() and maxima(),
+   * extrema at the bound of the data type are not reported.
+   */
+  template <class T>
+  void regionalExtremaUF(const Image<T> &imIn, Image<T> &imOut,
+                         const StrElt &se, bool maxima)
+  {
+    size_t S[3];
+    imIn.getSize(S);
+    size_t pixelCount = imIn.getPixelCount();
+
+    typename ImDtTypes<T>::lineType pix = imIn.getPixels();
+    typename ImDtTypes<T>::lineType out = imOut.getPixels();
+
+    std::vector<IntPoint> sePts;
+    for (size_t i = 0; i < se.points.size(); i++) {
+      const IntPoint &pt = se.points[i];
+      if (pt.x != 0 || pt.y != 0 || pt.z != 0)
+        sePts.push_back(pt);
+    }
+
+    std::vector<size_t> zpar(pixelCount);
+    std::vector<UINT8>  flagged(pixelCount, 0);
+    for (size_t p = 0; p < pixelCount; p++)
+      zpar[p] = p;
+
+    size_t p = 0;
+    for (off_t z0 = 0; z0 < off_t(S[2]); z0++)
+      for (off_t y0 = 0; y0 < off_t(S[1]); y0++) {
+        bool oddLine = se.odd && (y0 % 2);
+        for (off_t x0 = 0; x0 < off_t(S[0]); x0++, p++) {
+          for (size_t i = 0; i < sePts.size(); i++) {
+            off_t x = x0 + sePts[i].x;
+            off_t y = y0 + sePts[i].y;
+            off_t z = z0 + sePts[i].z;
+            if (oddLine)
+              x += (((y + 1) % 2) != 0);
+            if (x < 0 || x >= off_t(S[0]) || y < 0 || y >= off_t(S[1]) ||
+                z < 0 || z >= off_t(S[2]))
+              continue;
+
+            size_t q = x + (y + z * S[1]) * S[0];
+            if (pix[q] != pix[p]) {
+              if (maxima ? pix[q] > pix[p] : pix[q] < pix[p])
+                flagged[p] = 1;
+              continue;
+            }
+
+            // Union of the zones of p and q, the smallest offset as root
+            size_t rp = p, rq = q;
+            while (zpar[rp] != rp)
+              rp = zpar[rp] = zpar[zpar[rp]];
+            while (zpar[rq] != rq)
+              rq = zpar[rq] = zpar[zpar[rq]];
+            if (rp < rq)
+              zpar[rq] = rp;
+            else if (rq < rp)
+              zpar[rp] = rq;
+          }
+        }
+      }
+
+    // Roots come first in the scan order
+    for (p = 0; p < pixelCount; p++) {
+      zpar[p] = zpar[zpar[p]];
+      if (flagged[p])
+        flagged[zpar[p]] = 1;
+    }
+
+    T bound = maxima ? ImDtTypes<T>::min() : ImDtTypes<T>::max();
+    for (p = 0; p < pixelCount; p++)
+      out[p] = flagged[zpar[p]] || pix[p] == bound ? ImDtTypes<T>::min()
+                                                   : ImDtTypes<T>::max();
+  }
+  /** @endcond */
+
   /**
    * minima() - Minima
    *
+   * @note
+   * On integer images, regional minima are found by a single union-find
+   * scan of the flat zones, without geodesic reconstruction.
+   *
    * @param[in] imIn : input image
    * @param[out] imOut : output image
    * @param[in] se : structuring element
@@ -57,6 +146,12 @@ namespace smil
     ASSERT_ALLOCATED(&imIn, &imOut);
     ASSERT_SAME_SIZE(&imIn, &imOut);
 
+    if (std::numeric_limits<T>::is_integer) {
+      ImageFreezer freeze(imOut);
+      regionalExtremaUF(imIn, imOut, se, false);
+      return RES_OK;
+    }
+
     if (&imIn == &imOut) {
       Image<T> tmpIm(imIn);
       return minima(tmpIm, imOut, se);
@@ -74,6 +169,10 @@ namespace smil
   /**
    * maxima() - Maxima
    *
+   * @note
+   * On integer images, regional maxima are found by a single union-find
+   * scan of the flat zones, without geodesic reconstruction.
+   *
    * @param[in] imIn : input image
    * @param[out] imOut : output image
    * @param[in] se : structuring element
@@ -85,6 +184,12 @@ namespace smil
     ASSERT_ALLOCATED(&imIn, &imOut);
     ASSERT_SAME_SIZE(&imIn, &imOut);
 
+    if (std::numeric_limits<T>::is_integer) {
+      ImageFreezer freeze(imOut);
+      regionalExtremaUF(imIn, imOut, se, true);
+      return RES_OK;
+    }
+
     if (&imIn == &imOut) {
       Image<T> tmpIm(imIn);
       return maxima(tmpIm, imOut, se);
@@ -148,6 +253,12 @@ namespace smil
   /**
    * hMinima() - h-Minima
    *
+   * @note
+   * On integer images, the h-minima are read from the dynamics of the
+   * nodes of the min-tree (see ComponentTree::hExtrema()), without
+   * reconstruction. To get them at several heights, build the tree once and
+   * call ComponentTree::hExtrema() for each height.
+   *
    * @param[in] imIn : input image
    * @param[in] height :
    * @param[out] imOut : output image
@@ -160,6 +271,12 @@ namespace smil
     ASSERT_ALLOCATED(&imIn, &imOut);
     ASSERT_SAME_SIZE(&imIn, &imOut);
 
+    if (std::numeric_limits<T>::is_integer &&
+        imIn.getPixelCount() < size_t(ImDtTypes<UINT32>::max())) {
+      ComponentTree<T> tree(imIn, false, se);
+      return tree.hExtrema(double(height), imOut);
+    }
+
     ImageFreezer freeze(imOut);
 
     Image<T> tmpIm(imIn);
@@ -197,6 +314,12 @@ namespace smil
   /**
    * hMaxima() - h-Maxima
    *
+   * @note
+   * On integer images, the h-maxima are read from the dynamics of the
+   * nodes of the max-tree (see ComponentTree::hExtrema()), without
+   * reconstruction. To get them at several heights, build the tree once and
+   * call ComponentTree::hExtrema() for each height.
+   *
    * @param[in] imIn : input image
    * @param[in] height :
    * @param[out] imOut : output image
@@ -209,6 +332,12 @@ namespace smil
     ASSERT_ALLOCATED(&imIn, &imOut);
     ASSERT_SAME_SIZE(&imIn, &imOut);
 
+    if (std::numeric_limits<T>::is_integer &&
+        imIn.getPixelCount() < size_t(ImDtTypes<UINT32>::max())) {
+      ComponentTree<T> tree(imIn, true, se);
+      return tree.hExtrema(double(height), imOut);
+    }
+
     Image<T> tmpIm(imIn);
 
     ImageFreezer freeze(imOut);
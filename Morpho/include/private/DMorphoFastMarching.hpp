@@ -0,0 +1,440 @@
+/* __HEAD__
+ * Copyright (c) 2011-2016, Matthieu FAESSEL and ARMINES
+ * Copyright (c) 2017-2024, Centre de Morphologie Mathematique
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of Matthieu FAESSEL, or ARMINES nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Description :
+ *   This file evaluates real valued geodesic distances with the Fast
+ *   Marching Method
+ *
+ * History :
+ *   - 19/10/2026
+ *     First implementation - monotone radix heap, weighted distances and
+ *     parallel propagation over connected components of the domain
+ *
+ * __HEAD__ - Stop here !
+ */
+
+#ifndef _D_MORPHO_FAST_MARCHING_HPP
+#define _D_MORPHO_FAST_MARCHING_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "DMorphoLabel.hpp"
+
+#ifdef USE_OPEN_MP
+#include <omp.h>
+#endif // USE_OPEN_MP
+
+namespace smil
+{
+  /** @cond */
+  /*
+   * Monotone priority queue keyed by non negative floats.
+   *
+   * The bit pattern of a non negative float, read as an unsigned integer,
+   * keeps the order of the floats, so a radix heap applies : elements are
+   * stored in buckets indexed by the highest bit differing from the last
+   * popped key. Keys shall never be lower than the last popped key.
+   */
+  template <class ValueT>
+  class RadixHeap
+  {
+  public:
+    RadixHeap() : last(0), count(0)
+    {
+    }
+
+    bool empty() const
+    {
+      return count == 0;
+    }
+
+    void clear()
+    {
+      for (int i = 0; i < 33; i++)
+        buckets[i].clear();
+      last  = 0;
+      count = 0;
+    }
+
+    void push(float key, const ValueT &value)
+    {
+      UINT32 k = toBits(key);
+      if (k < last)
+        k = last;
+      buckets[bucketOf(k)].push_back(std::make_pair(k, value));
+      count++;
+    }
+
+    /*
+     * Remove the element with the lowest key
+     */
+    void pop(float &key, ValueT &value)
+    {
+      if (buckets[0].empty()) {
+        int i = 1;
+        while (buckets[i].empty())
+          i++;
+
+        std::vector<std::pair<UINT32, ValueT>> &bucket = buckets[i];
+
+        UINT32 minKey = bucket[0].first;
+        for (size_t j = 1; j < bucket.size(); j++)
+          if (bucket[j].first < minKey)
+            minKey = bucket[j].first;
+        last = minKey;
+
+        for (size_t j = 0; j < bucket.size(); j++)
+          buckets[bucketOf(bucket[j].first)].push_back(bucket[j]);
+        bucket.clear();
+      }
+      std::pair<UINT32, ValueT> &top = buckets[0].back();
+      key   = toFloat(top.first);
+      value = top.second;
+      buckets[0].pop_back();
+      count--;
+    }
+
+  private:
+    std::vector<std::pair<UINT32, ValueT>> buckets[33];
+    UINT32 last;
+    size_t count;
+
+    int bucketOf(UINT32 k) const
+    {
+      UINT32 x = k ^ last;
+      if (x == 0)
+        return 0;
+#if defined(__GNUC__)
+      return 32 - __builtin_clz(x);
+#else
+      int n = 0;
+      for (; x != 0; x >>= 1)
+        n++;
+      return n;
+#endif
+    }
+
+    static UINT32 toBits(float f)
+    {
+      UINT32 k;
+      std::memcpy(&k, &f, sizeof(k));
+      return k;
+    }
+
+    static float toFloat(UINT32 k)
+    {
+      float f;
+      std::memcpy(&f, &k, sizeof(f));
+      return f;
+    }
+  };
+
+  /*
+   * Fast Marching Method
+   *
+   * Solves the Eikonal equation |grad u| = cost with first order upwind
+   * differences along the image axes (4-neighborhood in 2D, 6-neighborhood
+   * in 3D). The propagation front is ordered by a monotone radix heap.
+   *
+   * The domain is split into its connected components, which don't interact,
+   * and components are propagated in parallel, each thread with its own
+   * heap. Pixel states and distances are shared arrays, but a thread only
+   * writes the pixels of the component it processes.
+   */
+  class FastMarchingFunctor
+  {
+  public:
+    FastMarchingFunctor(double sx = 1., double sy = 1., double sz = 1.)
+    {
+      spacing[0] = sx;
+      spacing[1] = sy;
+      spacing[2] = sz;
+    }
+
+    /*
+     * Distance, inside the domain (pixels with non zero cost), from the
+     * seeds. cost may be NULL for an unit cost. Pixels outside the domain
+     * are set to 0 and domain pixels not reachable from any seed to
+     * INFINITY, which fastMarchingToImage() saturates to the maximum value
+     * of the output type.
+     */
+    template <class T1, class T2, class T3>
+    RES_T propagate(const Image<T1> &imSeeds, const Image<T2> &imDomain,
+                    const Image<T3> *imCost, std::vector<float> &dist)
+    {
+      ASSERT_ALLOCATED(&imSeeds, &imDomain);
+      ASSERT_SAME_SIZE(&imSeeds, &imDomain);
+      ASSERT(spacing[0] > 0 && spacing[1] > 0 && spacing[2] > 0,
+             "Pixel spacing shall be positive", RES_ERR);
+
+      imSeeds.getSize(size);
+      pixelCount = imSeeds.getPixelCount();
+      strides[0] = 1;
+      strides[1] = size[0];
+      strides[2] = size[0] * size[1];
+
+      typename ImDtTypes<T1>::lineType seeds = imSeeds.getPixels();
+
+      dist.assign(pixelCount, 0.);
+      state.assign(pixelCount, FM_OUT);
+
+      cost.clear();
+      if (imCost != NULL) {
+        typename ImDtTypes<T3>::lineType pixelsCost = imCost->getPixels();
+        cost.assign(pixelsCost, pixelsCost + pixelCount);
+      }
+
+      // Connected components of the domain
+      Image<UINT8> imBin(imSeeds);
+      compare(imDomain, "!=", T2(0), UINT8(1), UINT8(0), imBin);
+
+      Image<UINT32> imLbl(imSeeds);
+      if (size[2] > 1)
+        label(imBin, imLbl, Cross3DSE());
+      else
+        label(imBin, imLbl, CrossSE());
+      BlobTable<UINT32> table = computeBlobTable(imLbl);
+
+      size_t nComps = table.size();
+      size_t c;
+
+#ifdef USE_OPEN_MP
+      int nthreads = Core::getInstance()->getNumberOfThreads();
+#pragma omp parallel num_threads(nthreads)
+#endif // USE_OPEN_MP
+      {
+        RadixHeap<size_t> heap;
+
+#ifdef USE_OPEN_MP
+#pragma omp for schedule(dynamic, 1)
+#endif // USE_OPEN_MP
+        for (c = 0; c < nComps; c++) {
+          const PixelSequence *runs  = table.getRuns(c);
+          size_t               nRuns = table.getRunCount(c);
+
+          heap.clear();
+          for (size_t r = 0; r < nRuns; r++) {
+            size_t end = runs[r].offset + runs[r].size;
+            for (size_t o = runs[r].offset; o < end; o++) {
+              if (seeds[o] == T1(0)) {
+                dist[o]  = 0.;
+                state[o] = FM_TRIAL;
+                heap.push(0., o);
+              } else {
+                dist[o]  = INFINITY;
+                state[o] = FM_FAR;
+              }
+            }
+          }
+          march(heap, dist);
+        }
+      }
+      return RES_OK;
+    }
+
+  private:
+    enum { FM_OUT = 0, FM_FAR, FM_TRIAL, FM_FROZEN };
+
+    double             spacing[3];
+    size_t             size[3];
+    size_t             strides[3];
+    size_t             pixelCount;
+    std::vector<UINT8> state;
+    std::vector<float> cost;
+
+    void march(RadixHeap<size_t> &heap, std::vector<float> &dist)
+    {
+      while (!heap.empty()) {
+        float  d;
+        size_t o;
+        heap.pop(d, o);
+        if (state[o] == FM_FROZEN || d > dist[o])
+          continue;
+        state[o] = FM_FROZEN;
+
+        size_t coords[3] = {o % size[0], (o / size[0]) % size[1],
+                            o / strides[2]};
+        for (int axis = 0; axis < 3; axis++) {
+          if (size[axis] < 2)
+            continue;
+          if (coords[axis] > 0)
+            update(o - strides[axis], d, heap, dist);
+          if (coords[axis] + 1 < size[axis])
+            update(o + strides[axis], d, heap, dist);
+        }
+      }
+    }
+
+    void update(size_t o, float dFrozen, RadixHeap<size_t> &heap,
+                std::vector<float> &dist)
+    {
+      if (state[o] != FM_FAR && state[o] != FM_TRIAL)
+        return;
+
+      double f = cost.empty() ? 1. : std::max(double(cost[o]), 0.);
+      double d = solve(o, f, dist);
+      if (d < dFrozen)
+        d = dFrozen;
+      if (float(d) < dist[o]) {
+        dist[o]  = float(d);
+        state[o] = FM_TRIAL;
+        heap.push(dist[o], o);
+      }
+    }
+
+    /*
+     * Upwind solution at pixel o, from the frozen neighbors : the lowest
+     * frozen value along each axis enters the quadratic
+     * sum_i ((u - a_i) / h_i)^2 = f^2 while it stays lower than u.
+     */
+    double solve(size_t o, double f, const std::vector<float> &dist)
+    {
+      double a[3], h[3];
+      int    n = 0;
+
+      size_t coords[3] = {o % size[0], (o / size[0]) % size[1],
+                          o / strides[2]};
+      for (int axis = 0; axis < 3; axis++) {
+        if (size[axis] < 2)
+          continue;
+        double v = INFINITY;
+        if (coords[axis] > 0 && state[o - strides[axis]] == FM_FROZEN)
+          v = dist[o - strides[axis]];
+        if (coords[axis] + 1 < size[axis] &&
+            state[o + strides[axis]] == FM_FROZEN)
+          v = std::min(v, double(dist[o + strides[axis]]));
+        if (std::isinf(v))
+          continue;
+        // insertion sort on a
+        int j = n++;
+        while (j > 0 && a[j - 1] > v) {
+          a[j] = a[j - 1];
+          h[j] = h[j - 1];
+          j--;
+        }
+        a[j] = v;
+        h[j] = spacing[axis];
+      }
+
+      double u = a[0] + h[0] * f;
+      double A = 0., B = 0., C = -f * f;
+      for (int i = 0; i < n; i++) {
+        if (u <= a[i])
+          break;
+        double w = 1. / (h[i] * h[i]);
+        A += w;
+        B += -2. * a[i] * w;
+        C += a[i] * a[i] * w;
+        if (i == 0)
+          continue;
+        double delta = B * B - 4. * A * C;
+        if (delta < 0)
+          break;
+        u = (-B + std::sqrt(delta)) / (2. * A);
+      }
+      return u;
+    }
+  };
+  /** @endcond */
+
+  /*
+   * Copy the real valued distance into the output image, saturating at the
+   * maximum value of the output type.
+   */
+  /** @cond */
+  template <class T>
+  void fastMarchingToImage(const std::vector<float> &dist, Image<T> &imOut)
+  {
+    typename ImDtTypes<T>::lineType pixelsOut = imOut.getPixels();
+
+    double maxVal     = double(ImDtTypes<T>::max());
+    size_t pixelCount = imOut.getPixelCount();
+    size_t i;
+#ifdef USE_OPEN_MP
+    int nthreads = Core::getInstance()->getNumberOfThreads();
+#pragma omp parallel for private(i) num_threads(nthreads)
+#endif // USE_OPEN_MP
+    for (i = 0; i < pixelCount; i++) {
+      double d     = dist[i];
+      pixelsOut[i] = d < maxVal ? T(d) : ImDtTypes<T>::max();
+    }
+  }
+  /** @endcond */
+
+  /*
+   *  #####    ####   #####
+   *  #       #    #  #    #
+   *  #####   #    #  #    #
+   *  #       #    #  #####
+   *  #       #    #  #
+   *  #        ####   #
+   */
+  template <class T1, class T2>
+  RES_T distanceGeodesicEuclidean(const Image<T1> &imIn,
+                                  const Image<T1> &imMask, Image<T2> &imOut,
+                                  double sx, double sy, double sz)
+  {
+    ASSERT_ALLOCATED(&imIn, &imMask, &imOut);
+    ASSERT_SAME_SIZE(&imIn, &imMask, &imOut);
+
+    ImageFreezer freeze(imOut);
+
+    std::vector<float>  dist;
+    FastMarchingFunctor fm(sx, sy, sz);
+    ASSERT(fm.propagate(imIn, imMask, (const Image<T1> *) NULL, dist) ==
+           RES_OK);
+
+    fastMarchingToImage(dist, imOut);
+    return RES_OK;
+  }
+
+  template <class T1, class T2, class T3>
+  RES_T distanceGeodesicWeighted(const Image<T1> &imIn,
+                                 const Image<T2> &imCost, Image<T3> &imOut,
+                                 double sx, double sy, double sz)
+  {
+    ASSERT_ALLOCATED(&imIn, &imCost, &imOut);
+    ASSERT_SAME_SIZE(&imIn, &imCost, &imOut);
+
+    ImageFreezer freeze(imOut);
+
+    std::vector<float>  dist;
+    FastMarchingFunctor fm(sx, sy, sz);
+    ASSERT(fm.propagate(imIn, imCost, &imCost, dist) == RES_OK);
+
+    fastMarchingToImage(dist, imOut);
+    return RES_OK;
+  }
+} // namespace smil
+
+#endif // _D_MORPHO_FAST_MARCHING_HPP
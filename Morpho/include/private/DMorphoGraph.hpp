@@ -225,63 +225,382 @@ namespace smil
     const Image<T2> *imNodeValues;
   };
 
-  // Generic functions
+  /** @cond */
+  /*
+   * Boundary of two regions seen during the scan of a mosaic : the pair of
+   * labels (a < b), the edge values met along the boundary and the first
+   * pixel pair, ranked by (pixel offset, SE point index), which restores the
+   * raster discovery order of the edges.
+   */
+  template <class T2>
+  struct RagSample {
+    size_t a, b;
+    T2     wMin, wMax;
+    double wSum;
+    size_t count;
+    size_t order;
+    size_t pOffset, qOffset;
+
+    void merge(const RagSample &rhs)
+    {
+      wMin = std::min(wMin, rhs.wMin);
+      wMax = std::max(wMax, rhs.wMax);
+      wSum += rhs.wSum;
+      count += rhs.count;
+      if (rhs.order < order) {
+        order   = rhs.order;
+        pOffset = rhs.pOffset;
+        qOffset = rhs.qOffset;
+      }
+    }
+  };
+
+  template <class T2>
+  struct RagScanOrder {
+    bool operator()(const RagSample<T2> &s1, const RagSample<T2> &s2) const
+    {
+      return s1.order < s2.order;
+    }
+  };
+
+  /*
+   * LSD radix sort on (a, b), 8 bits per pass. Passes where all the samples
+   * fall in the same bucket are skipped, so small labels only cost a few
+   * passes. Samples with the same labels are then merged.
+   */
+  template <class T2>
+  void ragSortAndMerge(std::vector<RagSample<T2>> &samples)
+  {
+    size_t n = samples.size();
+    if (n == 0)
+      return;
+
+    std::vector<RagSample<T2>> buf(n);
+    for (int field = 1; field >= 0; field--)
+      for (size_t shift = 0; shift < 8 * sizeof(size_t); shift += 8) {
+        size_t count[257] = {0};
+        for (size_t i = 0; i < n; i++) {
+          size_t key = field ? samples[i].b : samples[i].a;
+          count[((key >> shift) & 0xFF) + 1]++;
+        }
+        size_t first = field ? samples[0].b : samples[0].a;
+        if (count[((first >> shift) & 0xFF) + 1] == n)
+          continue;
+        for (int k = 0; k < 256; k++)
+          count[k + 1] += count[k];
+        for (size_t i = 0; i < n; i++) {
+          size_t key = field ? samples[i].b : samples[i].a;
+          buf[count[(key >> shift) & 0xFF]++] = samples[i];
+        }
+        samples.swap(buf);
+      }
+
+    size_t last = 0;
+    for (size_t i = 1; i < n; i++) {
+      if (samples[i].a == samples[last].a && samples[i].b == samples[last].b)
+        samples[last].merge(samples[i]);
+      else
+        samples[++last] = samples[i];
+    }
+    samples.resize(last + 1);
+  }
+
+  template <class T1, class T2, class NodeT, class WeightT>
+  RES_T mosaicToCSRGraphImpl(const Image<T1>          &imMosaic,
+                             const Image<T2>          *imEdgeValues,
+                             const Image<T2>          *imNodeValues,
+                             CSRGraph<NodeT, WeightT> &graph,
+                             const std::string &weighting, const StrElt &se)
+  {
+    ASSERT(weighting == "min" || weighting == "mean" || weighting == "max",
+           "Unknown weighting (min, mean or max)", RES_ERR);
+
+    StrElt se2 = se.size > 1 ? se.homothety(se.size) : se;
+
+    size_t S[3];
+    imMosaic.getSize(S);
+    size_t nlines = S[1] * S[2];
+    size_t nPts   = se2.points.size();
+
+    typename ImDtTypes<T1>::lineType labels = imMosaic.getPixels();
+    typename ImDtTypes<T2>::lineType values =
+        imEdgeValues ? imEdgeValues->getPixels() : NULL;
+
+    int nthreads = 1;
+#ifdef USE_OPEN_MP
+    nthreads = Core::getInstance()->getNumberOfThreads();
+    if (size_t(nthreads) > nlines)
+      nthreads = std::max<int>(int(nlines), 1);
+#endif // USE_OPEN_MP
+
+    std::vector<std::vector<RagSample<T2>>> samples(nthreads);
+
+#ifdef USE_OPEN_MP
+#pragma omp parallel num_threads(nthreads)
+#endif // USE_OPEN_MP
+    {
+      int tid = 0;
+#ifdef USE_OPEN_MP
+      tid = omp_get_thread_num();
+#endif // USE_OPEN_MP
+      size_t lBeg = nlines * tid / nthreads;
+      size_t lEnd = nlines * (tid + 1) / nthreads;
+
+      std::vector<RagSample<T2>> &local = samples[tid];
+
+      // Small direct mapped cache of the last samples, most boundary pixels
+      // are merged here instead of being sorted
+      const size_t        cacheSize = 256;
+      std::vector<size_t> cache(cacheSize, 0);
+
+      std::vector<int> dx(nPts);
+      std::vector<int> dOffset(nPts);
+      for (size_t l = lBeg; l < lEnd; l++) {
+        int    y = int(l % S[1]), z = int(l / S[1]);
+        size_t nValid = 0;
+        for (size_t i = 0; i < nPts; i++) {
+          const IntPoint &pt = se2.points[i];
+          int             ny = y + pt.y, nz = z + pt.z;
+          if (ny < 0 || ny >= int(S[1]) || nz < 0 || nz >= int(S[2]))
+            continue;
+          int x = pt.x;
+          if (se2.odd && (y % 2) && ((ny + 1) % 2) != 0)
+            x += 1;
+          dx[nValid]      = x;
+          dOffset[nValid] = x + pt.y * int(S[0]) + pt.z * int(S[0] * S[1]);
+          nValid++;
+        }
+
+        size_t offset = l * S[0];
+        for (size_t px = 0; px < S[0]; px++, offset++) {
+          T1 curVal = labels[offset];
+          for (size_t i = 0; i < nValid; i++) {
+            int nx = int(px) + dx[i];
+            if (nx < 0 || nx >= int(S[0]))
+              continue;
+            size_t nOffset = offset + dOffset[i];
+            T1     val     = labels[nOffset];
+            if (val == curVal)
+              continue;
+
+            RagSample<T2> s;
+            s.a       = std::min(size_t(curVal), size_t(val));
+            s.b       = std::max(size_t(curVal), size_t(val));
+            s.wMin    = values ? values[offset] : T2(0);
+            s.wMax    = s.wMin;
+            s.wSum    = double(s.wMin);
+            s.count   = 1;
+            s.order   = offset * nPts + i;
+            s.pOffset = offset;
+            s.qOffset = nOffset;
+
+            size_t &c = cache[(s.a * 31 + s.b) % cacheSize];
+            if (c < local.size() && local[c].a == s.a && local[c].b == s.b)
+              local[c].merge(s);
+            else {
+              c = local.size();
+              local.push_back(s);
+            }
+          }
+        }
+      }
+
+      ragSortAndMerge(local);
+    }
+
+    std::vector<RagSample<T2>> &all = samples[0];
+    for (int t = 1; t < nthreads; t++) {
+      all.insert(all.end(), samples[t].begin(), samples[t].end());
+      std::vector<RagSample<T2>>().swap(samples[t]);
+    }
+    if (nthreads > 1)
+      ragSortAndMerge(all);
+    std::sort(all.begin(), all.end(), RagScanOrder<T2>());
+
+    bool useMin = weighting == "min", useMax = weighting == "max";
+
+    typename CSRGraph<NodeT, WeightT>::EdgeListType edges(all.size());
+    for (size_t i = 0; i < all.size(); i++) {
+      const RagSample<T2> &s = all[i];
+      WeightT              w;
+      if (useMin)
+        w = WeightT(s.wMin);
+      else if (useMax)
+        w = WeightT(s.wMax);
+      else
+        w = WeightT(s.wSum / double(s.count));
+      edges[i] = typename CSRGraph<NodeT, WeightT>::EdgeType(
+          NodeT(labels[s.pOffset]), NodeT(labels[s.qOffset]), w);
+    }
+    graph.build(edges);
+
+    if (imNodeValues) {
+      // Value of each node at the pixel where its first edge was found
+      typename ImDtTypes<T2>::lineType nValues = imNodeValues->getPixels();
+
+      std::vector<WeightT> nodeValues(graph.getNodeNbr());
+      std::vector<bool>    done(graph.getNodeNbr(), false);
+      for (size_t i = 0; i < all.size(); i++) {
+        size_t pOffsets[2] = {all[i].pOffset, all[i].qOffset};
+        for (int k = 0; k < 2; k++) {
+          size_t n = graph.getNodeIndex(NodeT(labels[pOffsets[k]]));
+          if (!done[n]) {
+            nodeValues[n] = WeightT(nValues[pOffsets[k]]);
+            done[n]       = true;
+          }
+        }
+      }
+      graph.setNodeValues(nodeValues);
+    }
+
+    return RES_OK;
+  }
+  /** @endcond */
+
+  /**
+   * mosaicToCSRGraph() - Region adjacency graph of a mosaic
+   *
+   * Nodes are the labels of @b imMosaic and two labels are linked by an edge
+   * when they are neighbors with respect to @b se. Each pair of a pixel p
+   * and of a neighbor q of the other region gives one sample of the edge,
+   * the value of @b imEdgeValues at p. The edge weight is the minimum, mean
+   * or maximum of its samples, according to @b weighting. With a symmetric
+   * structuring element, pixels on both sides of the boundary are sampled.
+   * Edges are ordered by their first occurrence in a raster scan of the
+   * image.
+   *
+   * @note
+   * The image lines are scanned in parallel. Each thread keeps its own list
+   * of boundary samples, radix sorted and merged by pair of labels before the
+   * lists are joined. The cost is linear with the number of pixels, whatever
+   * the number of edges.
+   *
+   * @param[in] imMosaic : input mosaic (label image)
+   * @param[in] imEdgeValues : values defining the edge weights
+   * @param[in] imNodeValues : values defining the node values (taken where
+   * the first edge of a node is found)
+   * @param[out] graph : output graph
+   * @param[in] weighting : @b min, @b mean or @b max of the edge values on
+   * the boundary
+   * @param[in] se : structuring element
+   */
+  template <class T1, class T2, class NodeT, class WeightT>
+  RES_T mosaicToCSRGraph(const Image<T1>          &imMosaic,
+                         const Image<T2>          &imEdgeValues,
+                         const Image<T2>          &imNodeValues,
+                         CSRGraph<NodeT, WeightT> &graph,
+                         const std::string        &weighting = "min",
+                         const StrElt             &se        = DEFAULT_SE)
+  {
+    ASSERT_ALLOCATED(&imMosaic, &imEdgeValues, &imNodeValues);
+    ASSERT_SAME_SIZE(&imMosaic, &imEdgeValues, &imNodeValues);
+
+    return mosaicToCSRGraphImpl(imMosaic, &imEdgeValues, &imNodeValues, graph,
+                                weighting, se);
+  }
+
+  /**
+   * mosaicToCSRGraph() - Region adjacency graph of a mosaic, without node
+   * values
+   *
+   * @param[in] imMosaic : input mosaic (label image)
+   * @param[in] imEdgeValues : values defining the edge weights
+   * @param[out] graph : output graph
+   * @param[in] weighting : @b min, @b mean or @b max of the edge values on
+   * the boundary
+   * @param[in] se : structuring element
+   */
+  template <class T1, class T2, class NodeT, class WeightT>
+  RES_T mosaicToCSRGraph(const Image<T1>          &imMosaic,
+                         const Image<T2>          &imEdgeValues,
+                         CSRGraph<NodeT, WeightT> &graph,
+                         const std::string        &weighting = "min",
+                         const StrElt             &se        = DEFAULT_SE)
+  {
+    ASSERT_ALLOCATED(&imMosaic, &imEdgeValues);
+    ASSERT_SAME_SIZE(&imMosaic, &imEdgeValues);
+
+    return mosaicToCSRGraphImpl(imMosaic, &imEdgeValues,
+                                (const Image<T2> *) NULL, graph, weighting, se);
+  }
+
+  /**
+   * mosaicToCSRGraph() - Region adjacency graph of a mosaic, with null edge
+   * weights
+   *
+   * @param[in] imMosaic : input mosaic (label image)
+   * @param[out] graph : output graph
+   * @param[in] se : structuring element
+   */
+  template <class T1, class NodeT, class WeightT>
+  RES_T mosaicToCSRGraph(const Image<T1>          &imMosaic,
+                         CSRGraph<NodeT, WeightT> &graph,
+                         const StrElt             &se = DEFAULT_SE)
+  {
+    ASSERT_ALLOCATED(&imMosaic);
+
+    return mosaicToCSRGraphImpl(imMosaic, (const Image<T1> *) NULL,
+                                (const Image<T1> *) NULL, graph, "min", se);
+  }
+
+  // Generic functions : the graph is extracted as a CSRGraph (min weighting)
+  // and copied into the Graph
   template <class T1, class T2, class GT1, class GT2>
   RES_T mosaicToGraph(const Image<T1> &imMosaic, const Image<T2> &imEdgeValues,
                       const Image<T2> &imNodeValues, Graph<GT1, GT2> &graph,
                       const StrElt &se = DEFAULT_SE)
   {
-    typedef Graph<GT1, GT2>            graphT;
-    mosaicToGraphFunct<T1, T2, graphT> f;
-
-    return f(imMosaic, imEdgeValues, imNodeValues, graph, se);
+    CSRGraph<GT1, GT2> csrGraph;
+    ASSERT(mosaicToCSRGraph(imMosaic, imEdgeValues, imNodeValues, csrGraph,
+                            "min", se) == RES_OK);
+    csrGraph.toGraph(graph);
+    return RES_OK;
   }
   template <class T1, class T2>
   Graph<T1, T2>
   mosaicToGraph(const Image<T1> &imMosaic, const Image<T2> &imEdgeValues,
                 const Image<T2> &imNodeValues, const StrElt &se = DEFAULT_SE)
   {
-    typedef Graph<T1, T2>              graphT;
-    mosaicToGraphFunct<T1, T2, graphT> f;
-
-    return f(imMosaic, imEdgeValues, imNodeValues, se);
+    Graph<T1, T2> graph;
+    mosaicToGraph<T1, T2, T1, T2>(imMosaic, imEdgeValues, imNodeValues, graph,
+                                  se);
+    return graph;
   }
   template <class T1, class T2, class GT1, class GT2>
   RES_T mosaicToGraph(const Image<T1> &imMosaic, const Image<T2> &imEdgeValues,
                       Graph<GT1, GT2> &graph, const StrElt &se = DEFAULT_SE)
   {
-    typedef Graph<GT1, GT2>            graphT;
-    mosaicToGraphFunct<T1, T2, graphT> f;
-
-    return f(imMosaic, imEdgeValues, graph, se);
+    CSRGraph<GT1, GT2> csrGraph;
+    ASSERT(mosaicToCSRGraph(imMosaic, imEdgeValues, csrGraph, "min", se) ==
+           RES_OK);
+    csrGraph.toGraph(graph);
+    return RES_OK;
   }
   template <class T1, class T2>
   Graph<T1, T2> mosaicToGraph(const Image<T1> &imMosaic,
                               const Image<T2> &imEdgeValues,
                               const StrElt    &se = DEFAULT_SE)
   {
-    typedef Graph<T1, T2>              graphT;
-    mosaicToGraphFunct<T1, T2, graphT> f;
-
-    return f(imMosaic, imEdgeValues, se);
+    Graph<T1, T2> graph;
+    mosaicToGraph<T1, T2, T1, T2>(imMosaic, imEdgeValues, graph, se);
+    return graph;
   }
   template <class T1, class GT1, class GT2>
   RES_T mosaicToGraph(const Image<T1> &imMosaic, Graph<GT1, GT2> &graph,
                       const StrElt &se = DEFAULT_SE)
   {
-    typedef Graph<GT1, GT2>            graphT;
-    mosaicToGraphFunct<T1, T1, graphT> f;
-
-    return f(imMosaic, graph, se);
+    CSRGraph<GT1, GT2> csrGraph;
+    ASSERT(mosaicToCSRGraph(imMosaic, csrGraph, se) == RES_OK);
+    csrGraph.toGraph(graph);
+    return RES_OK;
   }
   template <class T1>
   Graph<T1, UINT> mosaicToGraph(const Image<T1> &imMosaic,
                                 const StrElt    &se = DEFAULT_SE)
   {
-    typedef Graph<T1, UINT>            graphT;
-    mosaicToGraphFunct<T1, T1, graphT> f;
-
-    return f(imMosaic, se);
+    Graph<T1, UINT> graph;
+    mosaicToGraph<T1, T1, UINT>(imMosaic, graph, se);
+    return graph;
   }
 
 #ifndef SWIG
@@ -36,8 +36,16 @@
 #include "Base/include/private/DImageHistogram.hpp"
 #include "Morpho/include/private/DMorphoMaxTreeCriteria.hpp"
 
+#include <algorithm>
 #include <complex>
+#include <cstring>
+#include <limits>
 #include <math.h>
+#include <vector>
+
+#ifdef USE_OPEN_MP
+#include <omp.h>
+#endif // USE_OPEN_MP
 
 namespace smil
 {
@@ -56,482 +64,759 @@ namespace smil
   typedef size_t Offset_T;
   typedef UINT32 Label_T;
 
-  template <class T, class CriterionT, class Offset_T = size_t,
-            class Label_T = UINT32>
-  class MaxTree2
-  {
-  private:
-    size_t          GRAY_LEVEL_NBR;
-    Image<T> const *img;
-
-    HierarchicalQueue<T, Offset_T> hq;
-
-    std::vector<T>          levels;
-    std::vector<Label_T>    children;
-    std::vector<Label_T>    brothers;
-    std::vector<CriterionT> criteria;
-    std::vector<Label_T>    labels;
-
-    Label_T curLabel;
-
-    bool initialized;
+  /** @cond */
+  template <size_t N>
+  struct RadixKeyType {
+  };
+  template <>
+  struct RadixKeyType<1> {
+    typedef UINT8 type;
+  };
+  template <>
+  struct RadixKeyType<2> {
+    typedef UINT16 type;
+  };
+  template <>
+  struct RadixKeyType<4> {
+    typedef UINT32 type;
+  };
+  template <>
+  struct RadixKeyType<8> {
+    typedef UINT64 type;
+  };
 
-    size_t imWidth;
-    size_t imHeight;
+  /*
+   * Unsigned integer key of a value, ordered as the values themselves :
+   * the sign bit is flipped for signed integers, and all the bits of
+   * negative floating point values.
+   */
+  template <class T>
+  struct RadixKey {
+    typedef typename RadixKeyType<sizeof(T)>::type KeyT;
 
-  public:
-    MaxTree2() : hq(true) // TOTO BMI
+    static inline KeyT get(const T &val)
     {
-      GRAY_LEVEL_NBR = ImDtTypes<T>::max() - ImDtTypes<T>::min() + 1;
-      //  hq.reverse();// change priority order (max first)
-      //  hq =   HierarchicalQueue<T,Offset_T> (true);
+      const KeyT sign = KeyT(KeyT(1) << (8 * sizeof(T) - 1));
+      KeyT       key;
+      std::memcpy(&key, &val, sizeof(T));
+      if (!std::numeric_limits<T>::is_integer)
+        return (key & sign) ? KeyT(~key) : KeyT(key | sign);
+      if (std::numeric_limits<T>::is_signed)
+        return KeyT(key ^ sign);
+      return key;
+    }
+  };
 
-      labels.resize(GRAY_LEVEL_NBR);
+  /*
+   * Stable LSD radix sort of pixel offsets by increasing pixel values, one
+   * byte per pass. Each pass counts and scatters contiguous chunks of the
+   * array in parallel. Passes on a byte which is the same for all values are
+   * skipped. tmp shall hold n elements.
+   */
+  template <class T, class IndexT>
+  void radixSortOffsets(const T *pix, IndexT *offsets, size_t n, IndexT *tmp)
+  {
+    typedef typename RadixKey<T>::KeyT KeyT;
+
+    size_t nChunks = 1;
+#ifdef USE_OPEN_MP
+    int nthreads = Core::getInstance()->getNumberOfThreads();
+    if (n >= 65536)
+      nChunks = nthreads;
+#endif // USE_OPEN_MP
+
+    std::vector<KeyT>   keys(n), keysTmp(n);
+    std::vector<size_t> counts(nChunks * 256);
+    size_t              i;
+
+#ifdef USE_OPEN_MP
+#pragma omp parallel for num_threads(nthreads)
+#endif // USE_OPEN_MP
+    for (i = 0; i < n; i++)
+      keys[i] = RadixKey<T>::get(pix[offsets[i]]);
+
+    KeyT   *kIn = keys.data(), *kOut = keysTmp.data();
+    IndexT *oIn = offsets, *oOut = tmp;
+
+    for (size_t pass = 0; pass < sizeof(KeyT); pass++) {
+      int    shift = 8 * pass;
+      size_t c;
+
+      std::fill(counts.begin(), counts.end(), 0);
+#ifdef USE_OPEN_MP
+#pragma omp parallel for num_threads(nthreads)
+#endif // USE_OPEN_MP
+      for (c = 0; c < nChunks; c++) {
+        size_t *cnt = counts.data() + 256 * c;
+        for (size_t j = n * c / nChunks; j < n * (c + 1) / nChunks; j++)
+          cnt[(kIn[j] >> shift) & 0xFF]++;
+      }
 
-      initialized = false;
+      // Positions of each chunk in each bin, bins first
+      size_t sum = 0, maxBin = 0;
+      for (size_t d = 0; d < 256; d++) {
+        size_t binSize = 0;
+        for (c = 0; c < nChunks; c++) {
+          size_t cnt          = counts[256 * c + d];
+          counts[256 * c + d] = sum;
+          sum += cnt;
+          binSize += cnt;
+        }
+        maxBin = std::max(maxBin, binSize);
+      }
+      if (maxBin == n)
+        continue;
+
+#ifdef USE_OPEN_MP
+#pragma omp parallel for num_threads(nthreads)
+#endif // USE_OPEN_MP
+      for (c = 0; c < nChunks; c++) {
+        size_t *pos = counts.data() + 256 * c;
+        for (size_t j = n * c / nChunks; j < n * (c + 1) / nChunks; j++) {
+          size_t k = pos[(kIn[j] >> shift) & 0xFF]++;
+          kOut[k]  = kIn[j];
+          oOut[k]  = oIn[j];
+        }
+      }
+      std::swap(kIn, kOut);
+      std::swap(oIn, oOut);
     }
 
-    ~MaxTree2()
+    if (oIn != offsets)
+      std::copy(oIn, oIn + n, offsets);
+  }
+
+  template <class T>
+  struct OffsetValueLess {
+    const T *pix;
+
+    OffsetValueLess(const T *p) : pix(p)
     {
-      reset();
     }
 
-    void reset()
+    template <class IndexT>
+    bool operator()(IndexT a, IndexT b) const
     {
-      if (!initialized)
-        return;
-
-      levels.clear();
-      children.clear();
-      brothers.clear();
-      criteria.clear();
-      labels.clear();
+      return pix[a] < pix[b];
     }
+  };
 
-    void allocatePage()
-    {
-      levels.resize(levels.size() + 1024 * 1024);
-      children.resize(children.size() + 1024 * 1024);
-      brothers.resize(brothers.size() + 1024 * 1024);
-      criteria.resize(criteria.size() + 1024 * 1024);
+  /*
+   * Stable sort of pixel offsets by increasing pixel values. Counting sort
+   * for 8 and 16 bits integer types, radix sort for 32 and 64 bits integer
+   * and floating point types. tmp shall hold n elements.
+   */
+  template <class T, class IndexT>
+  void sortOffsetsByValue(const T *pix, IndexT *offsets, size_t n, IndexT *tmp)
+  {
+    if (std::numeric_limits<T>::is_integer && sizeof(T) <= 2) {
+      size_t nbins =
+          size_t(double(ImDtTypes<T>::max()) - double(ImDtTypes<T>::min())) +
+          1;
+      std::vector<size_t> hist(nbins + 1, 0);
+      for (size_t i = 0; i < n; i++)
+        hist[size_t(pix[offsets[i]] - ImDtTypes<T>::min()) + 1]++;
+      for (size_t i = 1; i <= nbins; i++)
+        hist[i] += hist[i - 1];
+      for (size_t i = 0; i < n; i++)
+        tmp[hist[size_t(pix[offsets[i]] - ImDtTypes<T>::min())]++] =
+            offsets[i];
+      std::copy(tmp, tmp + n, offsets);
+      return;
+    }
+    if (sizeof(T) == 4 || sizeof(T) == 8) {
+      radixSortOffsets(pix, offsets, n, tmp);
+      return;
     }
 
-    T initialize(const Image<T> &imIn, Label_T *img_eti, const StrElt &se)
+    std::stable_sort(offsets, offsets + n, OffsetValueLess<T>(pix));
+  }
+
+  /*
+   * Parallel max-tree construction
+   *
+   * The image is split into slabs of lines (2D) or planes (3D), and the tree
+   * of each slab is built independently with the union-find algorithm of
+   * Berger et al. : pixels are processed by decreasing values, each one
+   * becoming the parent of the roots of the already processed neighbor
+   * components. These components are tracked by a union-find forest with
+   * union by rank and path halving, distinct from the tree. Slab trees are
+   * then merged along slab boundaries, as proposed by Wilkinson et al.,
+   * pairs of neighbor slab groups being merged in parallel.
+   *
+   * The result is a parent array : each pixel points to the canonical pixel
+   * of its node, and canonical pixels point to the canonical pixel of the
+   * parent node. Roots point to themselves. The neighborhood is given by
+   * the structuring element, as in the hierarchical queue based flooding.
+   *
+   * With dual set, the order of values is reversed and the min-tree is
+   * built instead. IndexT is the type of pixel offsets in the parent array :
+   * UINT32 halves the memory footprint for images of less than 4G pixels.
+   */
+  template <class T, class IndexT = size_t>
+  class MaxTreeUnionFind
+  {
+  public:
+    MaxTreeUnionFind(const Image<T> &imIn, const StrElt &se,
+                     bool dual = false)
     {
       imIn.getSize(imSize);
+      pixelCount = imIn.getPixelCount();
+      pix        = imIn.getPixels();
+      oddSE      = se.odd;
+      this->dual = dual;
 
-      // BMI BEGIN
-      sePtsNbr = sePts.size();
-      dOffsets.clear();
-      sePts.clear();
-      oddSE = se.odd;
-
-      // set an offset distance for each se point (!=0,0,0)
       for (std::vector<IntPoint>::const_iterator it = se.points.begin();
            it != se.points.end(); it++) {
-        if (it->x != 0 || it->y != 0 || it->z != 0) {
+        if (it->x != 0 || it->y != 0 || it->z != 0)
           sePts.push_back(*it);
-          dOffsets.push_back(it->x + it->y * imSize[0] +
-                             it->z * imSize[0] * imSize[1]);
-        }
       }
+    }
 
-      sePtsNbr = sePts.size();
-      // BMI END
+    void build(std::vector<IndexT> &parent)
+    {
+      parent.resize(pixelCount);
+      zpar.resize(pixelCount);
+      par = parent.data();
+
+      // Slabs along the last dimension, at least as thick as the
+      // structuring element, so that they only touch their neighbors
+      int    axis  = imSize[2] > 1 ? 2 : 1;
+      size_t slice = axis == 2 ? imSize[0] * imSize[1] : imSize[0];
+      size_t thick = 1;
+      for (size_t i = 0; i < sePts.size(); i++) {
+        int d = axis == 2 ? sePts[i].z : sePts[i].y;
+        thick = std::max(thick, size_t(std::abs(d)));
+      }
 
-      if (initialized)
-        reset();
+      size_t nSlabs = 1;
+#ifdef USE_OPEN_MP
+      int nthreads = Core::getInstance()->getNumberOfThreads();
+      nSlabs = std::max(size_t(1), std::min(size_t(nthreads),
+                                            imSize[axis] / thick));
+#endif // USE_OPEN_MP
+
+      bounds.resize(nSlabs + 1);
+      for (size_t i = 0; i <= nSlabs; i++)
+        bounds[i] = (imSize[axis] * i / nSlabs) * slice;
+
+      {
+        std::vector<IndexT> sorted(pixelCount);
+        size_t              i;
+
+        repr.resize(pixelCount);
+        rank.resize(pixelCount);
+
+#ifdef USE_OPEN_MP
+#pragma omp parallel for schedule(dynamic, 1) num_threads(nthreads)
+#endif // USE_OPEN_MP
+        for (i = 0; i < nSlabs; i++)
+          buildSlab(bounds[i], bounds[i + 1], sorted.data());
+
+        repr.clear();
+        repr.shrink_to_fit();
+        rank.clear();
+        rank.shrink_to_fit();
+      }
 
-      this->img                           = &imIn;
-      typename ImDtTypes<T>::lineType pix = img->getPixels();
+      for (size_t step = 1; step < nSlabs; step *= 2) {
+        size_t nMerges = (nSlabs - step + 2 * step - 1) / (2 * step);
+        size_t i;
 
-      T        minValue = ImDtTypes<T>::max();
-      T        tMinV    = ImDtTypes<T>::min();
-      Offset_T minOff   = 0;
-      for (size_t i = 0; i < img->getPixelCount(); i++) {
-        if (pix[i] < minValue) {
-          minValue = pix[i];
-          minOff   = i;
-          if (minValue == tMinV)
-            break;
-        }
+#ifdef USE_OPEN_MP
+#pragma omp parallel for schedule(dynamic, 1) num_threads(nthreads)
+#endif // USE_OPEN_MP
+        for (i = 0; i < nMerges; i++)
+          mergeBoundary(step + 2 * step * i, slice * thick);
       }
 
-      allocatePage();
-
-      curLabel         = 1;
-      levels[curLabel] = minValue;
+      // Final canonicalization : merges may have left chains of pixels at
+      // the same level
+      size_t p;
+#ifdef USE_OPEN_MP
+#pragma omp parallel for num_threads(nthreads)
+#endif // USE_OPEN_MP
+      for (p = 0; p < pixelCount; p++) {
+        IndexT r = canonical(p);
+        if (r != p)
+          zpar[p] = r;
+        else
+          zpar[p] = par[p] == p ? r : canonical(par[p]);
+      }
+      parent.swap(zpar);
 
-      // BMI labels? quel rapport avec img_eti?
-      // memset(old_labels, 0, GRAY_LEVEL_NBR * sizeof(Label_T));
+      zpar.clear();
+      zpar.shrink_to_fit();
+    }
 
-      img_eti[minOff]  = curLabel;
-      labels[minValue] = curLabel;
-      labels[minValue] = curLabel;
+  private:
+    static const IndexT NONE = std::numeric_limits<IndexT>::max();
 
-      hq.initialize(*img);
-      hq.push(minValue, minOff);
+    size_t imSize[3];
+    size_t pixelCount;
+    bool   oddSE;
+    bool   dual;
+
+    typename ImDtTypes<T>::lineType pix;
+    std::vector<IntPoint>           sePts;
+    std::vector<size_t>             bounds;
+    std::vector<IndexT>             zpar;
+    IndexT                         *par;
+
+    // Union-find forest of slab building : tree root of the component of
+    // each forest root, and rank of forest roots
+    std::vector<IndexT> repr;
+    std::vector<UINT8>  rank;
+
+    /*
+     * Neighbors of p with offset in [begin, end). Returns their number.
+     */
+    inline size_t getNeighbors(size_t p, size_t begin, size_t end,
+                               size_t *ngb)
+    {
+      off_t x0 = p % imSize[0];
+      off_t y0 = (p / imSize[0]) % imSize[1];
+      off_t z0 = p / (imSize[0] * imSize[1]);
 
-      size_t x, y, z;
-      img->getCoordsFromOffset(minOff, x, y, z);
-      //  std::cout<<"PUSH:offset="<<minOff<<"(x,y)="<<x<<", "<<y<<",
-      //  val="<<minValue<<"\n";
+      bool   oddLine = oddSE && (y0 % 2);
+      size_t n       = 0;
 
-      //  getCriterion(curLabel).xmin = getCriterion(curLabel).xmax = x;
-      //  // A voir comment on peut melanger des criteres... BMI
-      //  getCriterion(curLabel).ymin = getCriterion(curLabel).ymax = y;
-      //  getCriterion(curLabel).zmin = getCriterion(curLabel).zmax = z;
+      for (size_t i = 0; i < sePts.size(); i++) {
+        const IntPoint &pt = sePts[i];
 
-      getCriterion(curLabel).initialize();
-      curLabel++;
+        off_t x = x0 + pt.x;
+        off_t y = y0 + pt.y;
+        off_t z = z0 + pt.z;
+        if (oddLine)
+          x += (((y + 1) % 2) != 0);
 
-      initialized = true;
+        if (x < 0 || x >= off_t(imSize[0]) || y < 0 ||
+            y >= off_t(imSize[1]) || z < 0 || z >= off_t(imSize[2]))
+          continue;
 
-      imWidth  = img->getWidth();
-      imHeight = img->getHeight();
+        size_t q = x + (y + z * imSize[1]) * imSize[0];
+        if (q >= begin && q < end)
+          ngb[n++] = q;
+      }
+      return n;
+    }
 
-      return minValue;
+    // a is strictly above b in the tree order
+    inline bool above(const T &a, const T &b) const
+    {
+      return dual ? a < b : a > b;
     }
 
-    int nextLowerLabel(T valeur)
+    inline IndexT findRoot(IndexT x)
     {
-      if (curLabel + 256 > levels.size())
-        allocatePage();
-
-      getLevel(curLabel) = valeur;
-      int i;
-      for (i = valeur - 1; labels[i] == 0; i--)
-        ;
-
-      getChild(curLabel)             = getChild(labels[i]);
-      getChild(labels[i])            = curLabel;
-      getBrother(curLabel)           = getBrother(getChild(curLabel));
-      getBrother(getChild(curLabel)) = 0;
-      getCriterion(curLabel).reset();
-      return curLabel++;
+      while (zpar[x] != x) {
+        zpar[x] = zpar[zpar[x]];
+        x       = zpar[x];
+      }
+      return x;
     }
 
-    int nextHigherLabel(T parent_valeur, T valeur)
+    // Canonical pixel of the node of x, read only
+    inline IndexT canonical(IndexT x) const
     {
-      if (curLabel + 256 > levels.size())
-        allocatePage();
-
-      getLevel(curLabel)              = valeur;
-      getBrother(curLabel)            = getChild(labels[parent_valeur]);
-      getChild(labels[parent_valeur]) = curLabel;
-      getCriterion(curLabel).reset();
-      return curLabel++;
+      while (par[x] != x && pix[par[x]] == pix[x])
+        x = par[x];
+      return x;
     }
 
-    bool subFlood(typename ImDtTypes<T>::lineType imgPix, Label_T *img_eti,
-                  Offset_T p, Offset_T p_suiv)
+    // Canonical pixel of the node of x, with path compression
+    inline IndexT levelRoot(IndexT x)
     {
-      Label_T indice;
-
-      if (imgPix[p_suiv] > imgPix[p]) {
-        Label_T j;
-        for (j = imgPix[p] + 1; j < imgPix[p_suiv]; j++)
-          labels[j] = 0;
-        indice = img_eti[p_suiv] = labels[j] =
-            nextHigherLabel(imgPix[p], imgPix[p_suiv]);
-
-      } else if (labels[imgPix[p_suiv]] == 0) {
-        indice = img_eti[p_suiv] = labels[imgPix[p_suiv]] =
-            nextLowerLabel(imgPix[p_suiv]);
-      } else {
-        indice = img_eti[p_suiv] = labels[imgPix[p_suiv]];
+      IndexT r = canonical(x);
+      while (x != r) {
+        IndexT next = par[x];
+        par[x]      = r;
+        x           = next;
       }
+      return r;
+    }
 
-      size_t x, y, z;
-      img->getCoordsFromOffset(p_suiv, x, y, z);
+    void buildSlab(size_t begin, size_t end, IndexT *sorted)
+    {
+      size_t  n = end - begin;
+      IndexT *S = sorted + begin;
 
-      getCriterion(indice).update(x, y, z);
-      hq.push(imgPix[p_suiv], p_suiv);
+      for (size_t i = 0; i < n; i++) {
+        S[i]            = begin + i;
+        zpar[begin + i] = NONE;
+      }
+      // par is not yet used : temporary buffer for the sort
+      sortOffsetsByValue(pix, S, n, par + begin);
+      if (dual)
+        std::reverse(S, S + n);
+
+      std::vector<size_t> ngb(sePts.size());
+      for (size_t i = n; i-- > 0;) {
+        IndexT p = S[i];
+        par[p]   = p;
+        zpar[p]  = p;
+        repr[p]  = p;
+        rank[p]  = 0;
+
+        // Root of the component of p in the forest
+        IndexT zp = p;
+
+        size_t nNgb = getNeighbors(p, begin, end, ngb.data());
+        for (size_t k = 0; k < nNgb; k++) {
+          if (zpar[ngb[k]] == NONE)
+            continue;
+          IndexT r = findRoot(ngb[k]);
+          if (r == zp)
+            continue;
+          par[repr[r]] = p;
+          if (rank[zp] < rank[r])
+            std::swap(zp, r);
+          else if (rank[zp] == rank[r])
+            rank[zp]++;
+          zpar[r]  = zp;
+          repr[zp] = p;
+        }
+      }
 
-      if (imgPix[p_suiv] > imgPix[p]) {
-        hq.push(imgPix[p], p);
-        return true;
+      for (size_t i = 0; i < n; i++) {
+        IndexT p = S[i];
+        IndexT q = par[p];
+        if (pix[par[q]] == pix[q])
+          par[p] = par[q];
       }
-      return false;
     }
 
-    void flood(const Image<T> &img, UINT *img_eti, unsigned int level)
+    /*
+     * Merge the trees on both sides of the boundary between slabs b - 1 and
+     * b, for each pair of neighbor pixels across the boundary.
+     */
+    void mergeBoundary(size_t b, size_t width)
     {
-      Offset_T p;
-
-      typename ImDtTypes<T>::lineType imgPix = img.getPixels();
-      size_t                          x0, y0, z0;
-
-      while ((hq.getHigherLevel() >= level) && !hq.isEmpty()) {
-        p = hq.pop();
-
-        img.getCoordsFromOffset(p, x0, y0, z0);
-
-        bool oddLine = oddSE && ((y0) % 2);
-
-        // not size_t in order to (possibly be negative!)
-        off_t    x, y, z;
-        Offset_T p_suiv;
+      size_t begin = bounds[b];
+      size_t end   = std::min(bounds[b] + width, bounds[b + 1]);
+
+      std::vector<size_t> ngb(sePts.size());
+      for (size_t q = begin; q < end; q++) {
+        size_t nNgb = getNeighbors(q, bounds[b - 1], begin, ngb.data());
+        for (size_t k = 0; k < nNgb; k++)
+          connect(ngb[k], q);
+      }
+    }
 
-        for (UINT i = 0; i < sePtsNbr; i++) {
-          IntPoint &pt = sePts[i];
-          x            = x0 + pt.x;
-          y            = y0 + pt.y;
-          z            = z0 + pt.z;
+    void connect(IndexT x, IndexT y)
+    {
+      x = levelRoot(x);
+      y = levelRoot(y);
+      if (above(pix[y], pix[x]))
+        std::swap(x, y);
+      while (x != y && y != NONE) {
+        IndexT z = par[x] == x ? NONE : levelRoot(par[x]);
+        if (z != NONE && !above(pix[y], pix[z])) {
+          x = z;
+        } else {
+          par[x] = y;
+          x      = y;
+          y      = z;
+        }
+      }
+    }
+  };
+  /** @endcond */
 
-          if (oddLine)
-            x += (((y + 1) % 2) != 0);
+  /*
+   * Max-tree stored as a parent array over nodes
+   *
+   * Nodes are numbered in topological order : the root is 1, and each node
+   * has a greater label than its parent, so that a forward loop over labels
+   * is a top-down traversal and a backward loop a bottom-up one. Node 0 is a
+   * dummy. Levels, parents and attributes are kept in separate arrays, the
+   * criteria being only used while building the tree.
+   */
+  template <class T, class CriterionT, class Offset_T = size_t,
+            class Label_T = UINT32>
+  class MaxTree2
+  {
+  public:
+    typedef typename CriterionT::AttributeType Attr_T;
 
-          if (x >= 0 && x < (int) imSize[0] && y >= 0 && y < (int) imSize[1] &&
-              z >= 0 && z < (int) imSize[2]) {
-            p_suiv = p + dOffsets[i];
-            if (oddLine)
-              p_suiv += (((y + 1) % 2) != 0);
+  private:
+    std::vector<T>       levels;
+    std::vector<Label_T> parents;
+    std::vector<Attr_T>  attributes;
 
-            if (img_eti[p_suiv] == 0) {
-              if (subFlood(imgPix, img_eti, p, p_suiv))
-                break;
-            }
-          }
-        } // for each ngb
+    Label_T curLabel;
 
-      } // while hq.notEmpty
-    } // void flood
+    size_t imWidth;
+    size_t imHeight;
 
-  protected:
-    size_t imSize[3];
+  public:
+    MaxTree2() : curLabel(0), imWidth(0), imHeight(0)
+    {
+    }
 
-    std::vector<IntPoint> sePts;
-    UINT                  sePtsNbr;
-    bool                  oddSE;
-    std::vector<int>      dOffsets;
+    ~MaxTree2()
+    {
+      reset();
+    }
 
-  public:
-    inline CriterionT &getCriterion(const Label_T node)
+    void reset()
     {
-      return criteria[node];
+      levels.clear();
+      parents.clear();
+      attributes.clear();
+      curLabel = 0;
     }
 
-    inline T &getLevel(const Label_T node)
+  public:
+    inline const T &getLevel(const Label_T node) const
     {
       return levels[node];
     }
 
-    inline Label_T &getChild(const Label_T node)
+    inline Label_T getParent(const Label_T node) const
     {
-      return children[node];
+      return parents[node];
     }
 
-    inline Label_T &getBrother(const Label_T node)
+    inline const Attr_T &getAttribute(const Label_T node) const
     {
-      return brothers[node];
+      return attributes[node];
     }
 
-    inline Label_T getLabelMax()
+    inline Label_T getLabelMax() const
     {
       return curLabel;
     }
 
-    inline int getImWidth()
+    inline int getImWidth() const
     {
       return imWidth;
     }
 
-    inline int getImHeight()
+    inline int getImHeight() const
     {
       return imHeight;
     }
 
-    int build(const Image<T> &img, Label_T *img_eti, const StrElt &se)
+    /*
+     * Build the tree and label each pixel (img_eti) with its node. Nodes are
+     * numbered from 1, the root, which holds the first pixel with the
+     * minimum value. Pixels not connected to the root are labeled 0.
+     * With dual set, the min-tree is built instead, the root holding the
+     * first pixel with the maximum value.
+     * Returns the root label.
+     */
+    int build(const Image<T> &img, Label_T *img_eti, const StrElt &se,
+              bool dual = false)
     {
-      T minValue = initialize(img, img_eti, se);
-
-      // BMI: dOffset already contains se information
-      flood(img, img_eti, minValue);
-      updateCriteria(labels[minValue]);
-
-      return labels[minValue];
+      if (img.getPixelCount() < size_t(std::numeric_limits<UINT32>::max()))
+        return buildTree<UINT32>(img, img_eti, se, dual);
+      return buildTree<size_t>(img, img_eti, se, dual);
     }
 
-    // BMI (from Andres)
-    // Update criteria of a given max-tree node
-    // void updateCriteria(const int node);
-
-    // Update criteria on a given max-tree node.// From Andres
-    // template <class T, class CriterionT, class Offset_T, class Label_T>
-    void updateCriteria(const int node)
+  private:
+    template <class IndexT>
+    int buildTree(const Image<T> &img, Label_T *img_eti, const StrElt &se,
+                  bool dual)
     {
-      Label_T child = getChild(node);
-      while (child != 0) {
-        updateCriteria(child);
-        getCriterion(node).merge(&getCriterion(child));
-        child = getBrother(child);
-      }
-    }
-  };
-
-  // END BMI
-
-  // NEW BMI    # ##################################################
-  //(tree, transformee_node, indicatrice_node, child, stopSize, (T)0, 0,
-  // hauteur, tree.getLevel(root), tree.getLevel(root));
-  template <class T, class CriterionT, class Offset_T, class Label_T,
-            class Attr_T>
-  void ComputeDeltaUO(MaxTree2<T, CriterionT, Offset_T, Label_T> &tree,
-                      T *transformee_node, Attr_T *indicatrice_node, int node,
-                      int nParent, T prev_residue, Attr_T stop, UINT delta,
-                      int isPrevMaxT)
-  {
-    // self,node = 1, nParent =0, stop=0, delta = 0, isPrevMaxT = 0):
-    int  child; // index node
-    T    current_residue;
-    UINT cNode, cParent; // attributes
-    T    lNode, lParent; // node levels, the same type than input image
-
-    // ymax-tree.getCriterion(node).ymin+1;
-    // #current criterion
-    cNode = tree.getCriterion(node).getAttributeValue();
-    // #current level
-    lNode = tree.getLevel(node);
-
-    // ymax-tree.getCriterion(nParent).ymin+1;//
-    // #current criterion
-    cParent = tree.getCriterion(nParent).getAttributeValue();
-    // #current level
-    lParent = tree.getLevel(nParent);
-
-    bool flag = false;
-
-    if ((cParent - cNode) <= delta) {
-      flag = true;
-    }
-
-    if (flag) {
-      current_residue = prev_residue + lNode - lParent;
-    } else {
-      current_residue = lNode - lParent;
-    }
+      reset();
 
-    transformee_node[node] = transformee_node[nParent];
-    indicatrice_node[node] = indicatrice_node[nParent];
+      imWidth  = img.getWidth();
+      imHeight = img.getHeight();
 
-    int isMaxT = 0;
+      size_t                          pixelCount = img.getPixelCount();
+      typename ImDtTypes<T>::lineType pix        = img.getPixels();
 
-    if (cNode < stop) {
-      if (current_residue > transformee_node[node]) {
-        //          std::cout<<"UPDATE RES\n";
-        isMaxT                 = 1;
-        transformee_node[node] = current_residue;
-        if (!(isPrevMaxT && flag)) {
-          indicatrice_node[node] = cNode + 1;
+      T extremum =
+          dual ? ImDtTypes<T>::max() : std::numeric_limits<T>::lowest();
+      size_t minOff = 0;
+      for (size_t i = 0; i < pixelCount; i++) {
+        if (dual ? pix[i] > pix[minOff] : pix[i] < pix[minOff]) {
+          minOff = i;
+          if (pix[minOff] == extremum)
+            break;
         }
       }
-    } else {
-      indicatrice_node[node] = 0;
-    }
-    child = tree.getChild(node);
-    while (child != 0) {
-      ComputeDeltaUO(tree, transformee_node, indicatrice_node, child, node,
-                     current_residue, stop, delta, isMaxT);
-      child = tree.getBrother(child);
-    }
-  }
 
-  template <class T1, class T2>
-  void compute_max(MaxTree2<T1, HeightCriterion, size_t, UINT32> &tree,
-                   T1 *transformee_node, T2 *indicatrice_node, UINT32 node,
-                   T2 stop, T1 max_tr, T2 max_in, T2 hauteur_parent,
-                   T1 valeur_parent, T1 previous_value)
-  {
-    T1     m;
-    T1     max_node;
-    T2     max_criterion;
-    UINT32 child;
-    T2     hauteur = tree.getCriterion(node).getAttributeValue();
-    // ymax-tree.getCriterion(node).ymin+1;
-    //  std::cout<<"IN COMPUTE_MAX:"<<"; node="<<node<<"\n";
-    m = (hauteur == hauteur_parent) ? tree.getLevel(node) - previous_value
-                                    : tree.getLevel(node) - valeur_parent;
-    if (hauteur >= stop) {
-      max_node               = max_tr;
-      max_criterion          = 0; // max_in;
-      transformee_node[node] = max_node;
+      std::vector<IndexT> parent;
+      {
+        MaxTreeUnionFind<T, IndexT> uf(img, se, dual);
+        uf.build(parent);
+      }
 
-      indicatrice_node[node] = 0;
-      child                  = tree.getChild(node);
-    } else {
-      if (m > max_tr) {
-        max_node      = m;
-        max_criterion = hauteur;
-      } else {
-        max_node      = max_tr;
-        max_criterion = max_in;
+      // Canonical pixels, parents first
+      std::vector<IndexT> nodes;
+      for (size_t p = 0; p < pixelCount; p++)
+        if (parent[p] == p || pix[parent[p]] != pix[p])
+          nodes.push_back(p);
+      {
+        std::vector<IndexT> tmp(nodes.size());
+        sortOffsetsByValue(pix, nodes.data(), nodes.size(), tmp.data());
       }
-      transformee_node[node] = max_node;
-      indicatrice_node[node] = max_criterion + 1;
-      child                  = tree.getChild(node);
-    }
-    if (hauteur == hauteur_parent) {
-      while (child != 0) {
-        //      if(child > tree.getLabelMax()){
-        //      std::cout<<"ERROR call child:"<<child<<"\n";
-        //      }
-        if (hauteur_parent > stop)
-          compute_max(tree, transformee_node, indicatrice_node, child, stop,
-                      max_node, max_criterion, hauteur, tree.getLevel(node),
-                      previous_value);
+      if (dual)
+        std::reverse(nodes.begin(), nodes.end());
+
+      size_t root = minOff;
+      if (parent[minOff] != minOff && pix[parent[minOff]] == pix[minOff])
+        root = parent[minOff];
+
+      // Label nodes top-down
+      Label_T lbl   = 1;
+      img_eti[root] = lbl++;
+      for (size_t i = 0; i < nodes.size(); i++) {
+        size_t c = nodes[i];
+        if (c == root)
+          continue;
+        if (parent[c] == c || img_eti[parent[c]] == 0)
+          img_eti[c] = 0;
         else
-          compute_max(tree, transformee_node, indicatrice_node, child, stop,
-                      max_node, max_criterion, hauteur,
-                      tree.getLevel(node) /*valeur_parent*/, previous_value);
-        child = tree.getBrother(child);
+          img_eti[c] = lbl++;
       }
-    } else {
-      while (child != 0) {
-        //      if(child > tree.getLabelMax()){
-        //      std::cout<<"ERROR call child:"<<child<<"\n";
-        //}
-
-        compute_max(tree, transformee_node, indicatrice_node, child, stop,
-                    max_node, max_criterion, hauteur, tree.getLevel(node),
-                    valeur_parent);
-        child = tree.getBrother(child);
+      curLabel = lbl;
+
+      levels.assign(curLabel, T(0));
+      parents.assign(curLabel, 0);
+
+      levels[1]  = pix[root];
+      parents[1] = 1;
+      for (size_t i = 0; i < nodes.size(); i++) {
+        size_t  c    = nodes[i];
+        Label_T node = img_eti[c];
+        if (node <= 1)
+          continue;
+        levels[node]  = pix[c];
+        parents[node] = img_eti[parent[c]];
       }
+
+      size_t p;
+#ifdef USE_OPEN_MP
+      int nthreads = Core::getInstance()->getNumberOfThreads();
+#pragma omp parallel for num_threads(nthreads)
+#endif // USE_OPEN_MP
+      for (p = 0; p < pixelCount; p++) {
+        if (parent[p] != p && pix[parent[p]] == pix[p])
+          img_eti[p] = img_eti[parent[p]];
+      }
+      parent.clear();
+      parent.shrink_to_fit();
+      nodes.clear();
+      nodes.shrink_to_fit();
+
+      // Criteria : pixels first, then children into their parents
+      std::vector<CriterionT> criteria(curLabel);
+      criteria[1].initialize();
+      for (Label_T node = 2; node < curLabel; node++)
+        criteria[node].reset();
+
+      size_t s[3];
+      img.getSize(s);
+      p = 0;
+      for (size_t z = 0; z < s[2]; z++)
+        for (size_t y = 0; y < s[1]; y++)
+          for (size_t x = 0; x < s[0]; x++, p++)
+            if (img_eti[p] != 0 && p != minOff)
+              criteria[img_eti[p]].update(x, y, z);
+
+      for (Label_T node = curLabel - 1; node > 1; node--)
+        criteria[parents[node]].merge(&criteria[node]);
+
+      attributes.resize(curLabel);
+      for (Label_T node = 1; node < curLabel; node++)
+        attributes[node] = criteria[node].getAttributeValue();
+
+      return 1;
     }
-  }
+  };
 
+  // END BMI
+
+  /*
+   * Residues of the ultimate opening, nodes being visited top-down.
+   *
+   * Without delta, the residue of a node is its contrast with the first
+   * ancestor of different height. With delta, residues of consecutive nodes
+   * whose heights differ by at most delta are accumulated.
+   */
   template <class T1, class T2>
   void compute_contrast(MaxTree2<T1, HeightCriterion, size_t, UINT32> &tree,
                         T1 *transformee_node, T2 *indicatrice_node, UINT32 root,
                         T2 stopSize, UINT delta = 0)
   {
-    UINT32 child;
-    T2     hauteur;
-    //  std::cout<<"IN compute_contrast\n";
+    UINT32 nbNodes = tree.getLabelMax();
 
     transformee_node[root] = 0;
     indicatrice_node[root] = 0;
 
-    hauteur = tree.getCriterion(root).getAttributeValue();
-    child   = tree.getChild(root);
-    // ymax - tree.getCriterion(root).ymin+1;
     if (delta == 0) {
-      while (child != 0) {
-        compute_max(tree, transformee_node, indicatrice_node, child, stopSize,
-                    (T1) 0, (T2) 0, hauteur, tree.getLevel(root),
-                    tree.getLevel(root));
-        child = tree.getBrother(child);
+      // previous : level passed down as reference for nodes of the same
+      // height as their parent
+      std::vector<T1> previous(nbNodes, T1(0));
+      std::vector<T2> maxCriterion(nbNodes, T2(0));
+      previous[root] = tree.getLevel(root);
+
+      for (UINT32 node = root + 1; node < nbNodes; node++) {
+        UINT32 nParent = tree.getParent(node);
+        T2     hauteur = tree.getAttribute(node);
+        T2     hParent = tree.getAttribute(nParent);
+        T1     m       = (hauteur == hParent)
+                             ? tree.getLevel(node) - previous[nParent]
+                             : tree.getLevel(node) - tree.getLevel(nParent);
+
+        if (hauteur >= stopSize) {
+          transformee_node[node] = transformee_node[nParent];
+          maxCriterion[node]     = 0;
+          indicatrice_node[node] = 0;
+        } else {
+          if (m > transformee_node[nParent]) {
+            transformee_node[node] = m;
+            maxCriterion[node]     = hauteur;
+          } else {
+            transformee_node[node] = transformee_node[nParent];
+            maxCriterion[node]     = maxCriterion[nParent];
+          }
+          indicatrice_node[node] = maxCriterion[node] + 1;
+        }
+        previous[node] = (hauteur == hParent) ? previous[nParent]
+                                              : tree.getLevel(nParent);
       }
     } // END delta == 0
     else {
-      while (child != 0) {
-        ComputeDeltaUO(tree, transformee_node, indicatrice_node, child,
-                       root /*parent*/, (T1) 0 /* prev_residue*/,
-                       stopSize /*stop*/, delta, 0 /*isPrevMaxT*/);
+      std::vector<T1>    residue(nbNodes, T1(0));
+      std::vector<UINT8> isMax(nbNodes, 0);
+
+      for (UINT32 node = root + 1; node < nbNodes; node++) {
+        UINT32 nParent = tree.getParent(node);
+        UINT   cNode   = tree.getAttribute(node);
+        UINT   cParent = tree.getAttribute(nParent);
+        T1     lNode   = tree.getLevel(node);
+        T1     lParent = tree.getLevel(nParent);
+
+        bool flag = (cParent - cNode) <= delta;
 
-        child = tree.getBrother(child);
+        T1 current_residue;
+        if (flag)
+          current_residue = residue[nParent] + lNode - lParent;
+        else
+          current_residue = lNode - lParent;
+
+        transformee_node[node] = transformee_node[nParent];
+        indicatrice_node[node] = indicatrice_node[nParent];
+
+        UINT8 isMaxT = 0;
+        if (cNode < stopSize) {
+          if (current_residue > transformee_node[node]) {
+            isMaxT                 = 1;
+            transformee_node[node] = current_residue;
+            if (!(isMax[nParent] && flag))
+              indicatrice_node[node] = cNode + 1;
+          }
+        } else {
+          indicatrice_node[node] = 0;
+        }
+        residue[node] = current_residue;
+        isMax[node]   = isMaxT;
       }
-    } // END dela != 0
+    } // END delta != 0
   }
 
 #endif // SWIG
@@ -594,15 +879,17 @@ namespace smil
 
 #ifndef SWIG
   // NEW BMI    # ##################################################
-  //(tree, transformee_node, indicatrice_node, child, stopSize, (T)0, 0,
-  // hauteur, tree.getLevel(root), tree.getLevel(root));
+  // Residue of a single node, its parent being already processed. Returns
+  // whether the node residue is a maximum, and sets childAncestor to the
+  // first_ancestor to be used by the children of node.
   template <class T, class CriterionT, class Offset_T, class Label_T,
             class Attr_T>
-  void ComputeDeltaUOMSER(MaxTree2<T, CriterionT, Offset_T, Label_T> &tree,
-                          T *transformee_node, Attr_T *indicatrice_node,
-                          int node, int nParent, int first_ancestor,
-                          Attr_T stop, UINT delta, UINT method, int isPrevMaxT,
-                          UINT minArea = 0, T threshold = 0, T mymax = 0)
+  int ComputeDeltaUOMSER(MaxTree2<T, CriterionT, Offset_T, Label_T> &tree,
+                         T *transformee_node, Attr_T *indicatrice_node,
+                         int node, int nParent, int first_ancestor,
+                         Attr_T stop, UINT delta, UINT method, int isPrevMaxT,
+                         UINT minArea, T threshold, T mymax,
+                         int &childAncestor)
   {
     // method:  1 (MSER), 2 (RGR)
 
@@ -612,8 +899,6 @@ namespace smil
     // computation level(first_ancestor) - level(node) and for area stability
     // computation
 
-    // self,node = 1, nParent =0, stop=0, delta = 0, isPrevMaxT = 0):
-    int    child; // index node
     T      current_residue, stab_residue = 0;
     UINT   hNode, hParent; // attributes
     size_t aNode, aParent, aAncestor;
@@ -621,14 +906,14 @@ namespace smil
     // node levels, the same type than input image
     float stability;
 
-    hNode = tree.getCriterion(node).getAttributeValue().H; // #current criterion
-    aNode = tree.getCriterion(node).getAttributeValue().A;
+    hNode = tree.getAttribute(node).H; // #current criterion
+    aNode = tree.getAttribute(node).A;
     lNode = tree.getLevel(node); // #current level
 
     // #current criterion
-    hParent   = tree.getCriterion(nParent).getAttributeValue().H;
-    aParent   = tree.getCriterion(nParent).getAttributeValue().A;
-    aAncestor = tree.getCriterion(first_ancestor).getAttributeValue().A;
+    hParent   = tree.getAttribute(nParent).H;
+    aParent   = tree.getAttribute(nParent).A;
+    aAncestor = tree.getAttribute(first_ancestor).A;
 
     lParent   = tree.getLevel(nParent);        // #current level
     lAncestor = tree.getLevel(first_ancestor); // #current level
@@ -720,19 +1005,8 @@ namespace smil
     } else {
       indicatrice_node[node] = 0;
     }
-    child = tree.getChild(node);
-    while (child != 0) {
-      if (flag && (hNode < stop)) {
-        ComputeDeltaUOMSER(tree, transformee_node, indicatrice_node, child,
-                           node, first_ancestor, stop, delta, method, isMaxT,
-                           minArea, threshold, mymax);
-      } else {
-        ComputeDeltaUOMSER(tree, transformee_node, indicatrice_node, child,
-                           node, nParent, stop, delta, method, isMaxT, minArea,
-                           threshold, mymax);
-      }
-      child = tree.getBrother(child);
-    }
+    childAncestor = (flag && (hNode < stop)) ? first_ancestor : nParent;
+    return isMaxT;
   }
 
   inline void computeFillAspectRatioFactor(UINT wNode, UINT cNode, UINT area,
@@ -771,14 +1045,14 @@ namespace smil
   }
 
   // NEW BMI    # ##################################################
-  //(tree, transformee_node, indicatrice_node, child, stopSize, (T)0, 0,
-  // hauteur, tree.getLevel(root), tree.getLevel(root));
+  // Same as ComputeDeltaUOMSER, with shape (fill and aspect ratio) factors
   template <class T, class CriterionT, class Offset_T, class Label_T,
             class Attr_T>
-  void ComputeDeltaUOMSERSC(MaxTree2<T, CriterionT, Offset_T, Label_T> &tree,
-                            T *transformee_node, Attr_T *indicatrice_node,
-                            int node, int nParent, int first_ancestor,
-                            Attr_T stop, UINT delta, int isPrevMaxT)
+  int ComputeDeltaUOMSERSC(MaxTree2<T, CriterionT, Offset_T, Label_T> &tree,
+                           T *transformee_node, Attr_T *indicatrice_node,
+                           int node, int nParent, int first_ancestor,
+                           Attr_T stop, UINT delta, int isPrevMaxT,
+                           int &childAncestor)
   {
     // "node": the current node; "nParent": its direct parent (allows
     // attribute comparison for Delta versions); "first_ancestor": the
@@ -786,8 +1060,6 @@ namespace smil
     // computation level(first_ancestor) - level(node) and for area stability
     // computation
 
-    // self,node = 1, nParent =0, stop=0, delta = 0, isPrevMaxT = 0):
-    int    child; // index node
     T      current_residue, stab_residue;
     UINT   hNode, hParent, wNode; // attributes
     size_t aNode, aParent, aAncestor;
@@ -796,18 +1068,18 @@ namespace smil
     // node levels, the same type than input image
     float stability, fillRatio, AspectRatio, fac;
 
-    hNode = tree.getCriterion(node).getAttributeValue().H; // #current criterion
-    wNode = tree.getCriterion(node).getAttributeValue().W; // #width
-    aNode = tree.getCriterion(node).getAttributeValue().A;
+    hNode = tree.getAttribute(node).H; // #current criterion
+    wNode = tree.getAttribute(node).W; // #width
+    aNode = tree.getAttribute(node).A;
     lNode = tree.getLevel(node); // #current level
 
-    hParent = tree.getCriterion(nParent).getAttributeValue().H;
+    hParent = tree.getAttribute(nParent).H;
     // #current criterion
     // wParent =
     // tree.getCriterion(nParent).xmax-tree.getCriterion(nParent).xmin+1;//
     //  #width
-    aParent   = tree.getCriterion(nParent).getAttributeValue().A;
-    aAncestor = tree.getCriterion(first_ancestor).getAttributeValue().A;
+    aParent   = tree.getAttribute(nParent).A;
+    aAncestor = tree.getAttribute(first_ancestor).A;
     lParent   = tree.getLevel(nParent);        // #current level
     lAncestor = tree.getLevel(first_ancestor); // #current level
 
@@ -849,17 +1121,8 @@ namespace smil
     } else
       indicatrice_node[node] = 0;
 
-    child = tree.getChild(node);
-    while (child != 0) {
-      if (flag && (hNode < stop)) {
-        ComputeDeltaUOMSERSC(tree, transformee_node, indicatrice_node, child,
-                             node, first_ancestor, stop, delta, isMaxT);
-      } else {
-        ComputeDeltaUOMSERSC(tree, transformee_node, indicatrice_node, child,
-                             node, nParent, stop, delta, isMaxT);
-      }
-      child = tree.getBrother(child);
-    }
+    childAncestor = (flag && (hNode < stop)) ? first_ancestor : nParent;
+    return isMaxT;
   }
 
   template <class T1, class T2>
@@ -869,17 +1132,11 @@ namespace smil
                              UINT method = 2, UINT minArea = 0,
                              T1 threshold = 0, bool use_textShape = 0)
   {
-    int child;
-    //   UINT hauteur;
+    UINT32 nbNodes = tree.getLabelMax();
 
     transformee_node[root] = 0;
     indicatrice_node[root] = 0;
 
-    //  tree.updateCriteria(root);
-    // already in tree building function
-    //  hauteur = tree.getCriterion(root).ymax - tree.getCriterion(root).ymin+1;
-    child = tree.getChild(root);
-
     // BEGIN COMPUTE DYNAMIC, BMI
 
     UINT32 mynode;
@@ -893,19 +1150,23 @@ namespace smil
     }
     // std::cout << "mymax=" << mymax << "\n";
     // END COMPUTE DYNAMIC, BMI
-    while (child != 0) {
+
+    // Top-down : ancestor holds the first_ancestor of the children of each
+    // node
+    std::vector<int>   ancestor(nbNodes, root);
+    std::vector<UINT8> isMax(nbNodes, 0);
+    for (UINT32 node = root + 1; node < nbNodes; node++) {
+      int nParent = tree.getParent(node);
       if (!use_textShape)
-        ComputeDeltaUOMSER(tree, transformee_node, indicatrice_node, child,
-                           root /*parent*/, root /*first_ancestor*/,
-                           stopSize /*stop*/, delta, method, 0 /*isPrevMaxT*/,
-                           minArea, threshold, mymax);
-
-      else {
-        ComputeDeltaUOMSERSC(tree, transformee_node, indicatrice_node, child,
-                             root /*parent*/, root /*first_ancestor*/,
-                             stopSize /*stop*/, delta, 0 /*isPrevMaxT*/);
-      }
-      child = tree.getBrother(child);
+        isMax[node] = ComputeDeltaUOMSER(
+            tree, transformee_node, indicatrice_node, node, nParent,
+            ancestor[nParent], stopSize /*stop*/, delta, method,
+            isMax[nParent], minArea, threshold, mymax, ancestor[node]);
+      else
+        isMax[node] = ComputeDeltaUOMSERSC(
+            tree, transformee_node, indicatrice_node, node, nParent,
+            ancestor[nParent], stopSize /*stop*/, delta, isMax[nParent],
+            ancestor[node]);
     }
   }
 
@@ -958,62 +1219,27 @@ namespace smil
 
 #ifndef SWIG
 
-  template <class T, class CriterionT, class Offset_T, class Label_T,
-            class Attr_T>
-  void processMaxTree(MaxTree2<T, CriterionT, Offset_T, Label_T> &tree,
-                      Label_T node, T *lut_out, T previousLevel, Attr_T stop)
-  {
-    // MORPHEE_ENTER_FUNCTION("s_OpeningTree::computeMaxTree");
-    Label_T child;
-    T       nodeLevel = tree.getLevel(node);
-
-    T currentLevel = (tree.getCriterion(node).getAttributeValue() < stop)
-                         ? previousLevel
-                         : nodeLevel;
-
-    lut_out[node] = currentLevel;
-
-    child = tree.getChild(node);
-    while (child != 0) {
-      processMaxTree(tree, child, lut_out, currentLevel, stop);
-      child = tree.getBrother(child);
-    }
-  }
-
   template <class T, class CriterionT, class Offset_T, class Label_T,
             class Attr_T>
   void
   compute_AttributeOpening(MaxTree2<T, CriterionT, Offset_T, Label_T> &tree,
                            T *lut_node, Label_T root, Attr_T stopSize)
   {
-    Label_T child;
-
     lut_node[root] = tree.getLevel(root);
 
-    //    tree.updateCriteria(root);
-
-    // DEBUG
-    // Label_T lab;
-
-    // for(lab = 1; lab < tree.getLabelMax(); lab ++){
-    //   std::cout<<"lab="<<lab<<",
-    //   att="<<tree.getCriterion(lab).getAttributeValue()<<"\n";
-    // }
-
-    // END DEBUG
-    child = tree.getChild(root);
-
-    while (child != 0) {
-      processMaxTree(tree, child, lut_node, tree.getLevel(root), stopSize);
-      child = tree.getBrother(child);
+    // Top-down : nodes below the threshold take the level of their parent
+    for (Label_T node = root + 1; node < tree.getLabelMax(); node++) {
+      if (tree.getAttribute(node) < stopSize)
+        lut_node[node] = lut_node[tree.getParent(node)];
+      else
+        lut_node[node] = tree.getLevel(node);
     }
-
   } // compute_AttributeOpening
 
   template <class T, class CriterionT, class Offset_T = size_t,
             class Label_T = UINT32>
   RES_T attributeOpen(const Image<T> &imIn, Image<T> &imOut, size_t stopSize,
-                      const StrElt &se)
+                      const StrElt &se, bool dual = false)
   {
     ASSERT_ALLOCATED(&imIn, &imOut);
     ASSERT_SAME_SIZE(&imIn, &imOut);
@@ -1022,7 +1248,7 @@ namespace smil
     Label_T *img_eti = new Label_T[imSize]();
 
     MaxTree2<T, CriterionT> tree;
-    Label_T                 root = tree.build(imIn, img_eti, se);
+    Label_T                 root = tree.build(imIn, img_eti, se, dual);
 
     // BEGIN BMI, DEBUG
     // for(size_t i=0;i<imSize;i++) {
@@ -1082,17 +1308,8 @@ namespace smil
   RES_T heightClose(const Image<T> &imIn, size_t stopSize, Image<T> &imOut,
                     const StrElt &se = DEFAULT_SE)
   {
-    ASSERT_ALLOCATED(&imIn, &imOut);
-    ASSERT_SAME_SIZE(&imIn, &imOut);
-
-    ImageFreezer freeze(imOut);
-
-    Image<T> tmpIm(imIn);
-    inv(imIn, tmpIm);
-    RES_T res = attributeOpen<T, HeightCriterion>(tmpIm, imOut, stopSize, se);
-    inv(imOut, imOut);
-
-    return res;
+    // Min-tree rather than inversion, which is lossy for floating point types
+    return attributeOpen<T, HeightCriterion>(imIn, imOut, stopSize, se, true);
   } // END heightClose
 
   /**
@@ -1126,17 +1343,7 @@ namespace smil
   RES_T widthClose(const Image<T> &imIn, size_t stopSize, Image<T> &imOut,
                    const StrElt &se = DEFAULT_SE)
   {
-    ASSERT_ALLOCATED(&imIn, &imOut);
-    ASSERT_SAME_SIZE(&imIn, &imOut);
-
-    ImageFreezer freeze(imOut);
-
-    Image<T> tmpIm(imIn);
-    inv(imIn, tmpIm);
-    RES_T res = attributeOpen<T, WidthCriterion>(tmpIm, imOut, stopSize, se);
-    inv(imOut, imOut);
-
-    return res;
+    return attributeOpen<T, WidthCriterion>(imIn, imOut, stopSize, se, true);
   } // END widthClose
 
   /**
@@ -1170,18 +1377,165 @@ namespace smil
   RES_T areaClose(const Image<T> &imIn, size_t stopSize, Image<T> &imOut,
                   const StrElt &se = DEFAULT_SE)
   {
-    ASSERT_ALLOCATED(&imIn, &imOut);
-    ASSERT_SAME_SIZE(&imIn, &imOut);
+    return attributeOpen<T, AreaCriterion>(imIn, imOut, stopSize, se, true);
+  }
+
+#ifndef SWIG
+  /** @cond */
+  /*
+   * Attribute openings (or closings, with dual set) of imIn at all
+   * thresholds, written to outPix[k] for thresholds[k]. The tree is built
+   * once. The filtered levels of the nodes are computed for one threshold at
+   * a time, in a single lookup table, so that memory doesn't grow with the
+   * number of thresholds.
+   */
+  template <class T, class CriterionT>
+  void attributeFilterStack(const Image<T>           &imIn,
+                            const std::vector<size_t> &thresholds,
+                            const StrElt &se, bool dual, T *const *outPix)
+  {
+    size_t nPix = imIn.getPixelCount();
+    size_t nThr = thresholds.size();
+
+    std::vector<Label_T>    img_eti(nPix, 0);
+    MaxTree2<T, CriterionT> tree;
+    Label_T                 root = tree.build(imIn, img_eti.data(), se, dual);
+    Label_T                 nbNodes = tree.getLabelMax();
+
+    // Filtered level of each node, pixels not connected to the root (node
+    // 0) being set to 0 as in attributeOpen()
+    std::vector<T> lut(nbNodes, T(0));
+    for (size_t k = 0; k < nThr; k++) {
+      lut[root] = tree.getLevel(root);
+      for (Label_T node = root + 1; node < nbNodes; node++) {
+        if (tree.getAttribute(node) < thresholds[k])
+          lut[node] = lut[tree.getParent(node)];
+        else
+          lut[node] = tree.getLevel(node);
+      }
+
+      T     *out = outPix[k];
+      size_t p;
+#ifdef USE_OPEN_MP
+      int nthreads = Core::getInstance()->getNumberOfThreads();
+#pragma omp parallel for num_threads(nthreads)
+#endif // USE_OPEN_MP
+      for (p = 0; p < nPix; p++)
+        out[p] = lut[img_eti[p]];
+    }
+  }
 
+  /*
+   * Openings in outPix[0, n), closings in outPix[n, 2n)
+   */
+  template <class T>
+  RES_T attributeProfileStack(const Image<T>            &imIn,
+                              const std::string         &criterion,
+                              const std::vector<size_t> &thresholds,
+                              const StrElt &se, std::vector<T *> &outPix)
+  {
+    size_t nThr = thresholds.size();
+
+    if (criterion == "area") {
+      attributeFilterStack<T, AreaCriterion>(imIn, thresholds, se, false,
+                                             &outPix[0]);
+      attributeFilterStack<T, AreaCriterion>(imIn, thresholds, se, true,
+                                             &outPix[nThr]);
+    } else if (criterion == "height") {
+      attributeFilterStack<T, HeightCriterion>(imIn, thresholds, se, false,
+                                               &outPix[0]);
+      attributeFilterStack<T, HeightCriterion>(imIn, thresholds, se, true,
+                                               &outPix[nThr]);
+    } else if (criterion == "width") {
+      attributeFilterStack<T, WidthCriterion>(imIn, thresholds, se, false,
+                                              &outPix[0]);
+      attributeFilterStack<T, WidthCriterion>(imIn, thresholds, se, true,
+                                              &outPix[nThr]);
+    } else {
+      ERR_MSG("Unknown criterion : " + criterion);
+      return RES_ERR;
+    }
+    return RES_OK;
+  }
+  /** @endcond */
+#endif // SWIG
+
+  /**
+   * Attribute profile : openings and closings at several thresholds
+   *
+   * The max-tree and the min-tree of the image are built only once, instead
+   * of calling areaOpen(), areaClose(), ... for each threshold. Apart from
+   * the output, memory doesn't depend on the number of thresholds.
+   *
+   * @param[in] imIn Input image (2D)
+   * @param[in] criterion Attribute : @b "area", @b "height" or @b "width"
+   * @param[in] thresholds Thresholds (sizes) of the filters
+   * @param[out] imOut 3D image, resized to the size of @b imIn with
+   * <b>2 x thresholds.size()</b> slices. Slice @b k holds the opening at
+   * thresholds[k], and slice <b>thresholds.size() + k</b> the closing.
+   * @param[in] se Structuring element
+   */
+  template <class T>
+  RES_T attributeProfile(const Image<T> &imIn, const std::string &criterion,
+                         const std::vector<size_t> &thresholds,
+                         Image<T> &imOut, const StrElt &se = DEFAULT_SE)
+  {
+    ASSERT_ALLOCATED(&imIn);
+    ASSERT(imIn.getDepth() == 1, "Input image shall be a 2D image", RES_ERR);
+    ASSERT(!thresholds.empty(), "No threshold", RES_ERR);
+
+    size_t nThr  = thresholds.size();
+    size_t slice = imIn.getPixelCount();
+
+    ASSERT(imOut.setSize(imIn.getWidth(), imIn.getHeight(), 2 * nThr) ==
+               RES_OK,
+           RES_ERR_BAD_ALLOCATION);
     ImageFreezer freeze(imOut);
 
-    Image<T> tmpIm(imIn);
-    inv(imIn, tmpIm);
-    RES_T res = attributeOpen<T, AreaCriterion>(tmpIm, imOut, stopSize, se);
-    inv(imOut, imOut);
+    std::vector<T *> outPix(2 * nThr);
+    for (size_t k = 0; k < 2 * nThr; k++)
+      outPix[k] = imOut.getPixels() + k * slice;
+
+    return attributeProfileStack(imIn, criterion, thresholds, se, outPix);
+  }
+
+#ifndef SWIG
+  /**
+   * Attribute profile : openings and closings at several thresholds
+   *
+   * Same as above, with one output image per filter.
+   *
+   * @param[in] imIn Input image
+   * @param[in] criterion Attribute : @b "area", @b "height" or @b "width"
+   * @param[in] thresholds Thresholds (sizes) of the filters
+   * @param[out] imOuts <b>2 x thresholds.size()</b> allocated images of the
+   * size of @b imIn : openings at thresholds[k] first, then closings.
+   * @param[in] se Structuring element
+   */
+  template <class T>
+  RES_T attributeProfile(const Image<T> &imIn, const std::string &criterion,
+                         const std::vector<size_t> &thresholds,
+                         std::vector<Image<T> *>   &imOuts,
+                         const StrElt              &se = DEFAULT_SE)
+  {
+    ASSERT_ALLOCATED(&imIn);
+    ASSERT(!thresholds.empty(), "No threshold", RES_ERR);
+    ASSERT(imOuts.size() == 2 * thresholds.size(),
+           "Expected two output images per threshold", RES_ERR);
+
+    std::vector<T *> outPix(imOuts.size());
+    for (size_t k = 0; k < imOuts.size(); k++) {
+      ASSERT_ALLOCATED(imOuts[k]);
+      ASSERT_SAME_SIZE(&imIn, imOuts[k]);
+      outPix[k] = imOuts[k]->getPixels();
+    }
 
+    RES_T res = attributeProfileStack(imIn, criterion, thresholds, se, outPix);
+    for (size_t k = 0; k < imOuts.size(); k++)
+      imOuts[k]->modified();
     return res;
   }
+#endif // SWIG
 
   /** @} */
 
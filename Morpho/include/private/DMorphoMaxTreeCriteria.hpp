@@ -54,6 +54,8 @@ namespace smil
   class GenericCriterion
   {
   public:
+    typedef Attr_T AttributeType;
+
     GenericCriterion()
     {
     }
@@ -0,0 +1,257 @@
+/* __HEAD__
+ * Copyright (c) 2011-2016, Matthieu FAESSEL and ARMINES
+ * Copyright (c) 2017-2024, Centre de Morphologie Mathematique
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of Matthieu FAESSEL, or ARMINES nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Description :
+ *   Distances between the boundaries of two binary images (Hausdorff,
+ *   percentile Hausdorff and average surface distances)
+ *
+ * History :
+ *   - 19/10/2026
+ *     Moved from Base/DImageCompare.hpp, and based on the Euclidean distance
+ *     transform
+ *
+ * __HEAD__ - Stop here !
+ */
+
+#ifndef _D_MORPHO_SURFACE_DISTANCE_HPP
+#define _D_MORPHO_SURFACE_DISTANCE_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Base/include/private/DImageArith.hpp"
+#include "Base/include/private/DMeasures.hpp"
+#include "DMorphoEuclidean.hpp"
+#include "DMorphoResidues.hpp"
+
+namespace smil
+{
+  /**
+   * @addtogroup Similarity
+   * @{
+   */
+
+#ifndef SWIG
+  /** @cond */
+  /*
+   * Distances from each boundary pixel of imGt to the boundary of imIn, and
+   * from each boundary pixel of imIn to the boundary of imGt. The boundary of
+   * a binary image is the set of its foreground pixels with at least one
+   * background neighbor (in the sense of SquSE).
+   *
+   * Each set of distances is read on the exact Euclidean distance transform
+   * to the other boundary, so the cost is linear in the image size.
+   */
+  template <typename T>
+  RES_T surfaceDistances(const Image<T> &imGt, const Image<T> &imIn,
+                         std::vector<double> &distGt,
+                         std::vector<double> &distIn)
+  {
+    ASSERT_ALLOCATED(&imGt, &imIn);
+    ASSERT_SAME_SIZE(&imGt, &imIn);
+    ASSERT(isBinary(imGt) && isBinary(imIn),
+           "This function is defined only for binary images", RES_ERR);
+
+    Image<T> bGt(imGt);
+    Image<T> bIn(imIn);
+
+    gradient(imGt, bGt, SquSE());
+    inf(imGt, bGt, bGt);
+    gradient(imIn, bIn, SquSE());
+    inf(imIn, bIn, bIn);
+
+    std::vector<size_t> pixGt = nonZeroOffsets(bGt);
+    std::vector<size_t> pixIn = nonZeroOffsets(bIn);
+
+    distGt.clear();
+    distIn.clear();
+    if (pixGt.empty() || pixIn.empty()) {
+      // Distances to an empty boundary are infinite
+      distGt.assign(pixGt.size(), INFINITY);
+      distIn.assign(pixIn.size(), INFINITY);
+      return RES_OK;
+    }
+
+    // Boundary pixels shall be the zeros of the distance transform input
+    Image<T> imt(imGt);
+    fill(imt, T(1));
+    std::vector<double> dist2;
+    EuclideanFunctor    edt;
+
+    for (int pass = 0; pass < 2; pass++) {
+      std::vector<size_t> &src = pass == 0 ? pixIn : pixGt;
+      std::vector<size_t> &dst = pass == 0 ? pixGt : pixIn;
+      std::vector<double> &res = pass == 0 ? distGt : distIn;
+
+      typename ImDtTypes<T>::lineType pixels = imt.getPixels();
+      for (size_t i = 0; i < src.size(); i++)
+        pixels[src[i]] = T(0);
+
+      ASSERT(edt.squaredDistance(imt, dist2) == RES_OK);
+
+      res.resize(dst.size());
+      for (size_t i = 0; i < dst.size(); i++)
+        res[i] = std::sqrt(dist2[dst[i]]);
+
+      for (size_t i = 0; i < src.size(); i++)
+        pixels[src[i]] = T(1);
+    }
+    return RES_OK;
+  }
+
+  /*
+   * Nearest rank percentile of a set of values, in place
+   */
+  inline double _percentileValue(std::vector<double> &v, double percentile)
+  {
+    if (v.empty())
+      return 0.;
+    size_t k = size_t(std::ceil(percentile / 100. * v.size()));
+    k        = std::min(std::max(k, size_t(1)), v.size()) - 1;
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+  }
+  /** @endcond */
+#endif // SWIG
+
+  /**
+   * distanceHausdorff() - Hausdorff distance between the boundaries of two
+   * binary images.
+   *
+   * @f[
+   *  H(imGt, imIn) = \max \left( \max_{a \in \partial imGt} d(a, \partial imIn),
+   *                              \max_{b \in \partial imIn} d(b, \partial imGt)
+   *                  \right)
+   * @f]
+   *
+   * Distances are evaluated with an exact Euclidean distance transform, so
+   * the cost is linear in the image size.
+   *
+   * @see
+   * - Wikipedia : @UrlWikipedia{Hausdorff_distance, Hausdorff distance}
+   * - distanceHausdorffPercentile(), distanceAverageSurface()
+   * @note
+   * - only binary images (two classes)
+   * - if only one of the images is empty, the distance is infinite
+   *
+   * @param[in] imGt : @TI{Ground Truth} image
+   * @param[in] imIn : image to verify
+   * @returns returns @TB{Hausdorff distance} between two images
+   */
+  template <typename T>
+  double distanceHausdorff(const Image<T> &imGt, const Image<T> &imIn)
+  {
+    std::vector<double> distGt, distIn;
+    if (surfaceDistances(imGt, imIn, distGt, distIn) != RES_OK)
+      return 0.;
+
+    double d = 0.;
+    for (size_t i = 0; i < distGt.size(); i++)
+      d = std::max(d, distGt[i]);
+    for (size_t i = 0; i < distIn.size(); i++)
+      d = std::max(d, distIn[i]);
+    return d;
+  }
+
+  /**
+   * distanceHausdorffPercentile() - Percentile Hausdorff distance between the
+   * boundaries of two binary images.
+   *
+   * Same as distanceHausdorff(), but the maximum of the distances from the
+   * boundary of each image to the boundary of the other one is replaced by
+   * their @b percentile (nearest rank). With @b percentile = 95 this is the
+   * usual @TB{HD95}, less sensitive to outliers than the Hausdorff distance.
+   *
+   * @note
+   * - only binary images (two classes)
+   *
+   * @param[in] imGt : @TI{Ground Truth} image
+   * @param[in] imIn : image to verify
+   * @param[in] percentile : percentile, in [0, 100]
+   * @returns returns @TB{percentile Hausdorff distance} between two images
+   */
+  template <typename T>
+  double distanceHausdorffPercentile(const Image<T> &imGt,
+                                     const Image<T> &imIn,
+                                     const double    percentile = 95.)
+  {
+    ASSERT(percentile >= 0. && percentile <= 100.,
+           "Percentile shall be in [0, 100]", 0.);
+
+    std::vector<double> distGt, distIn;
+    if (surfaceDistances(imGt, imIn, distGt, distIn) != RES_OK)
+      return 0.;
+
+    return std::max(_percentileValue(distGt, percentile),
+                    _percentileValue(distIn, percentile));
+  }
+
+  /**
+   * distanceAverageSurface() - Average symmetric surface distance between
+   * two binary images.
+   *
+   * @f[
+   *  ASSD(imGt, imIn) = \dfrac{\sum_{a \in \partial imGt} d(a, \partial imIn)
+   *                          + \sum_{b \in \partial imIn} d(b, \partial imGt)}
+   *                         {|\partial imGt| + |\partial imIn|}
+   * @f]
+   *
+   * @note
+   * - only binary images (two classes)
+   *
+   * @param[in] imGt : @TI{Ground Truth} image
+   * @param[in] imIn : image to verify
+   * @returns returns @TB{average symmetric surface distance} between two
+   * images
+   */
+  template <typename T>
+  double distanceAverageSurface(const Image<T> &imGt, const Image<T> &imIn)
+  {
+    std::vector<double> distGt, distIn;
+    if (surfaceDistances(imGt, imIn, distGt, distIn) != RES_OK)
+      return 0.;
+
+    size_t n = distGt.size() + distIn.size();
+    if (n == 0)
+      return 0.;
+
+    double sum = 0.;
+    for (size_t i = 0; i < distGt.size(); i++)
+      sum += distGt[i];
+    for (size_t i = 0; i < distIn.size(); i++)
+      sum += distIn[i];
+    return sum / n;
+  }
+
+  /** @} */
+
+} // namespace smil
+
+#endif // _D_MORPHO_SURFACE_DISTANCE_HPP
@@ -34,8 +34,13 @@
 #include "DMorphoExtrema.hpp"
 #include "DMorphoLabel.hpp"
 #include "DMorphoResidues.hpp"
+#include "DMorphoGraph.hpp"
 #include "Core/include/DTypes.h"
 
+#include <map>
+#include <string>
+#include <vector>
+
 namespace smil
 {
   /**
@@ -554,29 +559,584 @@ namespace smil
   }
 
   /**
-   * Waterfall
+   * Hierarchies of watershed segmentations, computed on the graph of the
+   * catchment basins.
+   *
+   * The watershed of the gradient, the adjacency graph of its basins and
+   * the minimum spanning tree of this graph are computed once, at build
+   * time. Edges are weighted by the pass value between two basins : the
+   * lowest, along their common boundary, of the highest gradient value met
+   * when crossing it.
+   *
+   * Each hierarchy then gives a saliency to each edge of the tree, computed
+   * on the graph only. Cutting the hierarchy at some threshold merges the
+   * basins linked by edges whose saliency isn't above the threshold. Only
+   * the requested cut is drawn back into an image : the lines of the
+   * watershed still separating two regions.
+   *
+   * Available hierarchies :
+   * - @b waterfall : saliency is the number of waterfall iterations an edge
+   *   survives. At each iteration, each region merges with the neighbors it
+   *   shares its lowest pass with;
+   * - @b dynamics, @b area, @b volume : extinction values of the basins. At
+   *   each pass, in increasing order, the two merging regions are compared
+   *   and the edge gets the smallest value : height of the pass above their
+   *   minimum, their area, or the volume of their lake at the pass level.
+   *   Regions are taken as flat lakes at their minimum level.
    *
+   * @b Example
+   * @code{.py}
+   *   import smilPython as sp
+   *
+   *   im = sp.Image("https://smil.cmm.minesparis.psl.eu/images/barbara.png")
+   *   imGrad = sp.Image(im)
+   *   imOut = sp.Image(im)
+   *   sp.gradient(im, imGrad)
+   *
+   *   hierarchy = sp.WatershedHierarchy(imGrad)
+   *   for level in range(hierarchy.getWaterfallLevelCount()):
+   *     hierarchy.waterfall(level, imOut)
+   *   hierarchy.cut("dynamics", 20, imOut)
+   * @endcode
+   *
+   * @see waterfall(), watershedExtinctionGraph()
    */
   template <class T>
-  RES_T waterfall(const Image<T> &gradIn, UINT nLevel, Image<T> &imWsOut,
-                  const StrElt &se = DEFAULT_SE)
+  class WatershedHierarchy
   {
-    ASSERT_ALLOCATED(&gradIn, &imWsOut);
-    ASSERT_SAME_SIZE(&gradIn, &imWsOut);
+  public:
+    WatershedHierarchy() : labelCount(0), regionCount(0)
+    {
+      imSize[0] = imSize[1] = imSize[2] = 0;
+    }
 
-    ImageFreezer freeze(imWsOut);
+    /**
+     * Build the hierarchy of a gradient image
+     *
+     * @param[in] gradIn : gradient image
+     * @param[in] se : structuring element
+     */
+    WatershedHierarchy(const Image<T> &gradIn, const StrElt &se = DEFAULT_SE)
+        : labelCount(0), regionCount(0)
+    {
+      imSize[0] = imSize[1] = imSize[2] = 0;
+      build(gradIn, se);
+    }
+
+    /**
+     * Build the hierarchy of a gradient image
+     *
+     * @param[in] gradIn : gradient image
+     * @param[in] se : structuring element
+     */
+    RES_T build(const Image<T> &gradIn, const StrElt &se = DEFAULT_SE)
+    {
+      ASSERT_ALLOCATED(&gradIn);
+
+      gradIn.getSize(imSize);
+      size_t pixelCount = gradIn.getPixelCount();
+
+      sePts.clear();
+      for (size_t i = 0; i < se.points.size(); i++) {
+        const IntPoint &pt = se.points[i];
+        if (pt.x != 0 || pt.y != 0 || pt.z != 0)
+          sePts.push_back(pt);
+      }
+      oddSE = se.odd;
+
+      // Watershed of the gradient
+      {
+        Image<UINT> imMarkers(gradIn);
+        imBasins.setSize(gradIn);
+        imLines.setSize(gradIn);
+        ASSERT(minimaLabeled(gradIn, imMarkers, se) == RES_OK);
+        ASSERT(watershed(gradIn, imMarkers, imLines, imBasins, se) == RES_OK);
+      }
+
+      typename ImDtTypes<T>::lineType    grad = gradIn.getPixels();
+      typename ImDtTypes<UINT>::lineType lbl  = imBasins.getPixels();
+
+      labelCount = size_t(maxVal(imBasins)) + 1;
+
+      // Area and minimum of each region
+      regionArea.assign(labelCount, 0.);
+      regionMin.assign(labelCount, double(ImDtTypes<T>::max()));
+      for (size_t p = 0; p < pixelCount; p++) {
+        regionArea[lbl[p]] += 1.;
+        regionMin[lbl[p]] = std::min(regionMin[lbl[p]], double(grad[p]));
+      }
+      regionCount = 0;
+      for (size_t i = 1; i < labelCount; i++)
+        regionCount += regionArea[i] > 0.;
+
+      // Region adjacency graph : lowest pass between each pair of regions.
+      // A watershed line pixel is a pass between all the regions around it.
+      typename ImDtTypes<T>::lineType lines = imLines.getPixels();
+
+      std::vector<GraphEdge> ragEdges;
+      std::vector<size_t>    ngb(sePts.size());
+      std::vector<GraphEdge> around;
+      for (size_t p = 0; p < pixelCount; p++) {
+        size_t nNgb = getNeighbors(p, ngb.data());
+        if (lines[p] == ImDtTypes<T>::min()) {
+          for (size_t i = 0; i < nNgb; i++) {
+            size_t q = ngb[i];
+            if (lines[q] != ImDtTypes<T>::min() || lbl[q] == lbl[p])
+              continue;
+            T w = std::max(grad[p], grad[q]);
+            ragEdges.push_back(GraphEdge(std::min(lbl[p], lbl[q]),
+                                         std::max(lbl[p], lbl[q]), w));
+          }
+          continue;
+        }
 
-    Image<T> tmpGradIm(gradIn, 1); // clone
-    Image<T> tmpGradIm2(gradIn);   // clone
+        // Lowest neighbor of each region around the line pixel
+        around.clear();
+        if (lbl[p] != 0)
+          around.push_back(GraphEdge(lbl[p], 0, grad[p]));
+        for (size_t i = 0; i < nNgb; i++) {
+          size_t q = ngb[i];
+          if (lines[q] == ImDtTypes<T>::min())
+            around.push_back(GraphEdge(lbl[q], 0, std::max(grad[p], grad[q])));
+        }
+        std::sort(around.begin(), around.end(), edgeOrder);
+
+        for (size_t i = 0; i < around.size(); i++) {
+          if (i > 0 && around[i].source == around[i - 1].source)
+            continue;
+          for (size_t j = i + 1; j < around.size(); j++) {
+            if (around[j].source == around[j - 1].source)
+              continue;
+            T w = std::max(around[i].weight, around[j].weight);
+            ragEdges.push_back(
+                GraphEdge(around[i].source, around[j].source, w));
+          }
+        }
+      }
+
+      std::sort(ragEdges.begin(), ragEdges.end(), edgeOrder);
+      ragEdges.erase(std::unique(ragEdges.begin(), ragEdges.end(), sameNodes),
+                     ragEdges.end());
 
-    watershed(gradIn, imWsOut, se);
+      // Minimum spanning tree, edges in Kruskal order
+      typename CSRGraph<UINT, T>::EdgeListType csrEdges(ragEdges.size());
+      for (size_t i = 0; i < ragEdges.size(); i++)
+        csrEdges[i] = typename CSRGraph<UINT, T>::EdgeType(
+            ragEdges[i].source, ragEdges[i].target, ragEdges[i].weight);
 
-    for (UINT i = 0; i < nLevel; i++) {
-      waterfall(tmpGradIm, imWsOut, tmpGradIm2, imWsOut, se);
-      copy(tmpGradIm2, tmpGradIm);
+      CSRGraph<UINT, T> rag;
+      rag.build(csrEdges);
+      std::vector<size_t> mstEdges = graphMSTEdges(rag);
+
+      mst.clear();
+      for (size_t i = 0; i < mstEdges.size(); i++)
+        mst.addEdge(csrEdges[mstEdges[i]], false);
+
+      saliencies.clear();
+
+      return RES_OK;
     }
 
-    return RES_OK;
+    /**
+     * Number of regions of the finest partition (the watershed of the
+     * gradient)
+     */
+    size_t getRegionCount() const
+    {
+      return regionCount;
+    }
+
+    /**
+     * Number of waterfall levels : from the level @b 0 (the watershed of the
+     * gradient) to the first one with a single region
+     */
+    UINT getWaterfallLevelCount()
+    {
+      const std::vector<double> &levels = *saliencyValues("waterfall");
+
+      double nLevels = 0.;
+      for (size_t i = 0; i < levels.size(); i++)
+        nLevels = std::max(nLevels, levels[i]);
+      return UINT(nLevels) + 1;
+    }
+
+    /**
+     * Minimum spanning tree of the region adjacency graph. Nodes are the
+     * labels of the basins, edges are weighted by the pass values.
+     */
+    Graph<UINT, T> getMST() const
+    {
+      return mst;
+    }
+
+    /**
+     * Saliency of the edges of the tree, in the order of getMST() edges
+     *
+     * @param[in] hierarchy : @b waterfall, @b dynamics, @b area or @b volume
+     * @returns an empty vector if the hierarchy is unknown
+     */
+    std::vector<double> getSaliency(const std::string &hierarchy)
+    {
+      const std::vector<double> *values = saliencyValues(hierarchy);
+      if (values == NULL)
+        return std::vector<double>();
+      return *values;
+    }
+
+    /**
+     * Watershed lines of a partition of the hierarchy : regions linked by
+     * edges whose saliency is not above @b threshold are merged.
+     *
+     * @param[in] hierarchy : @b waterfall, @b dynamics, @b area or @b volume
+     * @param[in] threshold : saliency threshold
+     * @param[out] imWsOut : output image, max on the watershed lines
+     */
+    RES_T cut(const std::string &hierarchy, double threshold,
+              Image<T> &imWsOut)
+    {
+      ASSERT_ALLOCATED(&imWsOut);
+      ASSERT(imWsOut.getWidth() == imSize[0] &&
+                 imWsOut.getHeight() == imSize[1] &&
+                 imWsOut.getDepth() == imSize[2],
+             "Output image size differs from the hierarchy image size",
+             RES_ERR);
+
+      const std::vector<double> *values = saliencyValues(hierarchy);
+      ASSERT(values != NULL, "Unknown hierarchy", RES_ERR);
+
+      ImageFreezer freeze(imWsOut);
+
+      // Regions of the partition
+      std::vector<UINT> group(labelCount);
+      for (size_t i = 0; i < labelCount; i++)
+        group[i] = UINT(i);
+
+      size_t nMerges = 0;
+
+      const typename Graph<UINT, T>::EdgeListType &edges = mst.getEdges();
+      for (size_t i = 0; i < edges.size(); i++)
+        if (!((*values)[i] > threshold)) {
+          unite(group, edges[i].source, edges[i].target);
+          nMerges++;
+        }
+      if (nMerges == 0)
+        return copy(imLines, imWsOut);
+
+      for (size_t i = 0; i < labelCount; i++)
+        group[i] = findRoot(group, UINT(i));
+
+      // Watershed lines still separating two regions. Each line pixel is
+      // first given the region of its side of the line : the one of its
+      // neighbors out of the lines, or its own if there is none. It stays on
+      // a line if its neighbors out of the lines are in several regions, or
+      // if its side differs from the one of a neighbor (thick lines).
+      typename ImDtTypes<T>::lineType    lines  = imLines.getPixels();
+      typename ImDtTypes<UINT>::lineType lbl    = imBasins.getPixels();
+      typename ImDtTypes<T>::lineType    pixOut = imWsOut.getPixels();
+
+      size_t              pixelCount = imWsOut.getPixelCount();
+      std::vector<UINT>   side(pixelCount);
+      std::vector<UINT8>  between(pixelCount, 0);
+      size_t              p;
+
+#ifdef USE_OPEN_MP
+      int nthreads = Core::getInstance()->getNumberOfThreads();
+#pragma omp parallel num_threads(nthreads)
+#endif // USE_OPEN_MP
+      {
+        std::vector<size_t> ngb(sePts.size());
+
+#ifdef USE_OPEN_MP
+#pragma omp for
+#endif // USE_OPEN_MP
+        for (p = 0; p < pixelCount; p++) {
+          side[p] = lbl[p] ? group[lbl[p]] : 0;
+          if (lines[p] == ImDtTypes<T>::min())
+            continue;
+
+          UINT   g    = 0;
+          size_t nNgb = getNeighbors(p, ngb.data());
+          for (size_t i = 0; i < nNgb && !between[p]; i++) {
+            UINT l = lbl[ngb[i]];
+            if (l == 0 || lines[ngb[i]] != ImDtTypes<T>::min())
+              continue;
+            if (g == 0)
+              g = group[l];
+            else
+              between[p] = group[l] != g;
+          }
+          if (g != 0 && !between[p])
+            side[p] = g;
+        }
+
+#ifdef USE_OPEN_MP
+#pragma omp for
+#endif // USE_OPEN_MP
+        for (p = 0; p < pixelCount; p++) {
+          bool isLine = between[p] != 0;
+          if (!isLine && lines[p] != ImDtTypes<T>::min() && side[p] != 0) {
+            size_t nNgb = getNeighbors(p, ngb.data());
+            for (size_t i = 0; i < nNgb && !isLine; i++) {
+              size_t q = ngb[i];
+              isLine   = !between[q] && side[q] != 0 && side[q] != side[p];
+            }
+          }
+          pixOut[p] = isLine ? ImDtTypes<T>::max() : ImDtTypes<T>::min();
+        }
+      }
+
+      return RES_OK;
+    }
+
+    /**
+     * Watershed lines of a waterfall level
+     *
+     * @param[in] level : waterfall level, @b 0 being the watershed of the
+     * gradient
+     * @param[out] imWsOut : output image, max on the watershed lines
+     */
+    RES_T waterfall(UINT level, Image<T> &imWsOut)
+    {
+      return cut("waterfall", double(level), imWsOut);
+    }
+
+  private:
+    struct GraphEdge {
+      UINT source, target;
+      T    weight;
+      GraphEdge(UINT s, UINT t, T w) : source(s), target(t), weight(w)
+      {
+      }
+    };
+
+    static bool edgeOrder(const GraphEdge &a, const GraphEdge &b)
+    {
+      if (a.source != b.source)
+        return a.source < b.source;
+      if (a.target != b.target)
+        return a.target < b.target;
+      return a.weight < b.weight;
+    }
+
+    static bool sameNodes(const GraphEdge &a, const GraphEdge &b)
+    {
+      return a.source == b.source && a.target == b.target;
+    }
+
+    size_t                imSize[3];
+    std::vector<IntPoint> sePts;
+    bool                  oddSE;
+
+    Image<UINT> imBasins;
+    Image<T>    imLines;
+    size_t      labelCount;
+    size_t      regionCount;
+
+    std::vector<double> regionArea;
+    std::vector<double> regionMin;
+
+    Graph<UINT, T> mst;
+
+    std::map<std::string, std::vector<double>> saliencies;
+
+    /*
+     * Neighbors of p, with the odd line convention of the flooding. Returns
+     * their number.
+     */
+    size_t getNeighbors(size_t p, size_t *ngb) const
+    {
+      off_t x0 = p % imSize[0];
+      off_t y0 = (p / imSize[0]) % imSize[1];
+      off_t z0 = p / (imSize[0] * imSize[1]);
+
+      bool   oddLine = oddSE && (y0 % 2);
+      size_t n       = 0;
+
+      for (size_t i = 0; i < sePts.size(); i++) {
+        off_t x = x0 + sePts[i].x;
+        off_t y = y0 + sePts[i].y;
+        off_t z = z0 + sePts[i].z;
+        if (oddLine)
+          x += (((y + 1) % 2) != 0);
+
+        if (x < 0 || x >= off_t(imSize[0]) || y < 0 ||
+            y >= off_t(imSize[1]) || z < 0 || z >= off_t(imSize[2]))
+          continue;
+        ngb[n++] = x + (y + z * imSize[1]) * imSize[0];
+      }
+      return n;
+    }
+
+    static UINT findRoot(std::vector<UINT> &parent, UINT x)
+    {
+      while (parent[x] != x) {
+        parent[x] = parent[parent[x]];
+        x         = parent[x];
+      }
+      return x;
+    }
+
+    static void unite(std::vector<UINT> &parent, UINT a, UINT b)
+    {
+      a = findRoot(parent, a);
+      b = findRoot(parent, b);
+      if (a < b)
+        parent[b] = a;
+      else if (b < a)
+        parent[a] = b;
+    }
+
+    /*
+     * Cached saliencies, computed on first request
+     */
+    const std::vector<double> *saliencyValues(const std::string &name)
+    {
+      typename std::map<std::string, std::vector<double>>::iterator it =
+          saliencies.find(name);
+      if (it != saliencies.end())
+        return &it->second;
+
+      std::vector<double> values;
+      if (name == "waterfall")
+        computeWaterfall(values);
+      else if (name == "dynamics" || name == "area" || name == "volume")
+        computeExtinction(name, values);
+      else
+        return NULL;
+
+      std::vector<double> &stored = saliencies[name];
+      stored.swap(values);
+      return &stored;
+    }
+
+    /*
+     * Waterfall iterations on the tree : each region merges along its
+     * lowest edges. Contracting edges of the tree gives the tree of the
+     * merged regions, and each iteration at least halves the number of
+     * regions.
+     */
+    void computeWaterfall(std::vector<double> &levels)
+    {
+      const typename Graph<UINT, T>::EdgeListType &edges = mst.getEdges();
+
+      size_t nEdges = edges.size();
+      levels.assign(nEdges, 0.);
+
+      std::vector<UINT> parent(labelCount);
+      for (size_t i = 0; i < labelCount; i++)
+        parent[i] = UINT(i);
+      std::vector<T> lowest(labelCount, ImDtTypes<T>::max());
+
+      std::vector<size_t> active(nEdges), remaining;
+      std::vector<UINT>   src(nEdges), trg(nEdges);
+      for (size_t i = 0; i < nEdges; i++)
+        active[i] = i;
+
+      for (UINT level = 1; !active.empty(); level++) {
+        for (size_t k = 0; k < active.size(); k++) {
+          const Edge<UINT, T> &e = edges[active[k]];
+          UINT                 a = findRoot(parent, e.source);
+          UINT                 b = findRoot(parent, e.target);
+          src[active[k]]         = a;
+          trg[active[k]]         = b;
+          lowest[a]              = std::min(lowest[a], e.weight);
+          lowest[b]              = std::min(lowest[b], e.weight);
+        }
+
+        remaining.clear();
+        for (size_t k = 0; k < active.size(); k++) {
+          size_t i = active[k];
+          if (edges[i].weight == lowest[src[i]] ||
+              edges[i].weight == lowest[trg[i]])
+            levels[i] = double(level);
+          else
+            remaining.push_back(i);
+        }
+
+        for (size_t k = 0; k < active.size(); k++) {
+          size_t i          = active[k];
+          lowest[src[i]]    = ImDtTypes<T>::max();
+          lowest[trg[i]]    = ImDtTypes<T>::max();
+          if (levels[i] == double(level))
+            unite(parent, src[i], trg[i]);
+        }
+        active.swap(remaining);
+      }
+    }
+
+    /*
+     * Extinction values : edges of the tree processed by increasing weight,
+     * the smallest attribute of the two merging regions going to the edge.
+     */
+    void computeExtinction(const std::string &name, std::vector<double> &ext)
+    {
+      const typename Graph<UINT, T>::EdgeListType &edges = mst.getEdges();
+
+      size_t nEdges = edges.size();
+      ext.assign(nEdges, 0.);
+
+      std::vector<std::pair<T, size_t>> order(nEdges);
+      for (size_t i = 0; i < nEdges; i++)
+        order[i] = std::make_pair(edges[i].weight, i);
+      std::sort(order.begin(), order.end());
+
+      // Area, minimum, volume and level of the lake of each region
+      std::vector<UINT>   parent(labelCount);
+      std::vector<double> area(regionArea), minLevel(regionMin);
+      std::vector<double> volume(labelCount, 0.), level(regionMin);
+      for (size_t i = 0; i < labelCount; i++)
+        parent[i] = UINT(i);
+
+      for (size_t k = 0; k < nEdges; k++) {
+        size_t i = order[k].second;
+        double w = double(order[k].first);
+        UINT   a = findRoot(parent, edges[i].source);
+        UINT   b = findRoot(parent, edges[i].target);
+
+        double volA = volume[a] + area[a] * (w - level[a]);
+        double volB = volume[b] + area[b] * (w - level[b]);
+
+        if (name == "dynamics")
+          ext[i] = w - std::max(minLevel[a], minLevel[b]);
+        else if (name == "area")
+          ext[i] = std::min(area[a], area[b]);
+        else
+          ext[i] = std::min(volA, volB);
+
+        unite(parent, a, b);
+        UINT r      = findRoot(parent, a);
+        area[r]     = area[a] + area[b];
+        minLevel[r] = std::min(minLevel[a], minLevel[b]);
+        volume[r]   = volA + volB;
+        level[r]    = w;
+      }
+    }
+  };
+
+  /**
+   * Waterfall
+   *
+   * @note
+   * The levels are computed by a WatershedHierarchy : a single watershed,
+   * then merges of regions on the minimum spanning tree of their adjacency
+   * graph. To get several levels, build the hierarchy once and call
+   * WatershedHierarchy::waterfall() for each level.
+   *
+   * @param[in] gradIn : gradient image
+   * @param[in] nLevel : waterfall level, @b 0 being the watershed of the
+   * gradient
+   * @param[out] imWsOut : output image, max on the watershed lines
+   * @param[in] se : structuring element
+   */
+  template <class T>
+  RES_T waterfall(const Image<T> &gradIn, UINT nLevel, Image<T> &imWsOut,
+                  const StrElt &se = DEFAULT_SE)
+  {
+    ASSERT_ALLOCATED(&gradIn, &imWsOut);
+    ASSERT_SAME_SIZE(&gradIn, &imWsOut);
+
+    WatershedHierarchy<T> hierarchy(gradIn, se);
+    return hierarchy.waterfall(nLevel, imWsOut);
   }
 
   /** @}*/
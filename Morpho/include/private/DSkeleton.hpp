@@ -81,9 +81,44 @@ namespace smil
     return RES_OK;
   }
 
+  /** @cond */
+  /*
+   * Bounding box [box[0], box[3]) x [box[1], box[4]) x [box[2], box[5]) of the
+   * pixels of imIn above min. Returns false if there is none.
+   */
+  template <class T>
+  bool skelNonMinBox(const Image<T> &imIn, size_t box[6])
+  {
+    size_t S[3];
+    imIn.getSize(S);
+
+    box[0] = S[0], box[1] = S[1], box[2] = S[2];
+    box[3] = box[4] = box[5] = 0;
+
+    typename ImDtTypes<T>::lineType pixels = imIn.getPixels();
+
+    size_t o = 0;
+    for (size_t z = 0; z < S[2]; z++)
+      for (size_t y = 0; y < S[1]; y++)
+        for (size_t x = 0; x < S[0]; x++, o++) {
+          if (pixels[o] == ImDtTypes<T>::min())
+            continue;
+          box[0] = std::min(box[0], x), box[3] = std::max(box[3], x + 1);
+          box[1] = std::min(box[1], y), box[4] = std::max(box[4], y + 1);
+          box[2] = std::min(box[2], z), box[5] = std::max(box[5], z + 1);
+        }
+    return box[3] > 0;
+  }
+  /** @endcond */
+
   /**
    * skeleton() - Morphological skeleton
    *
+   * @note
+   * Each iteration only processes the bounding box of the current erosion,
+   * grown by the size of the structuring element. The work done thus follows
+   * the shrinking of the input set, instead of the size of the image.
+   *
    * @param[in] imIn : input image
    * @param[out] imOut : output image
    * @param[in] se : structuring element
@@ -98,20 +133,77 @@ namespace smil
     ImageFreezer freezer(imOut);
 
     Image<T> imEro(imIn);
-    Image<T> imTemp(imIn);
 
     copy(imIn, imEro);
     fill(imOut, ImDtTypes<T>::min());
 
-    bool idempt = false;
+    size_t S[3];
+    imIn.getSize(S);
+
+    // Reach of the SE along each axis. When the SE doesn't contain its
+    // center, erosions may grow and the whole image is processed.
+    size_t margin[3] = {0, 0, 0};
+    bool   centered  = false;
+    for (size_t i = 0; i < se.points.size(); i++) {
+      const IntPoint &pt = se.points[i];
+      if (pt.x == 0 && pt.y == 0 && pt.z == 0)
+        centered = true;
+      margin[0] = std::max(margin[0], size_t(std::abs(pt.x) + se.odd));
+      margin[1] = std::max(margin[1], size_t(std::abs(pt.y)));
+      margin[2] = std::max(margin[2], size_t(std::abs(pt.z)));
+    }
+    for (int i = 0; i < 3; i++)
+      margin[i] *= std::max(se.size, UINT(1));
+
+    size_t box[6] = {0, 0, 0, S[0], S[1], S[2]};
+    if (centered && !skelNonMinBox(imEro, box))
+      return RES_OK;
+
+    Image<T> imTemp, imEroBox, imOutBox;
+    bool     idempt = false;
 
     do {
-      erode(imEro, imEro, se);
-      open(imEro, imTemp, se);
-      sub(imEro, imTemp, imTemp);
-      sup(imOut, imTemp, imTemp);
-      idempt = equ(imTemp, imOut);
-      copy(imTemp, imOut);
+      // Crop around the non empty part of the erosion. Pixels outside it
+      // stay at min through the erosion, so do their residues. Odd SEs need
+      // crops starting on even lines and slices.
+      size_t start[3], size[3];
+      for (int i = 0; i < 3; i++) {
+        start[i] = box[i] > margin[i] ? box[i] - margin[i] : 0;
+        if (se.odd && i > 0)
+          start[i] -= start[i] % 2;
+        size[i] = std::min(box[i + 3] + margin[i], S[i]) - start[i];
+      }
+
+      bool      whole = size[0] == S[0] && size[1] == S[1] && size[2] == S[2];
+      Image<T> &ero   = whole ? imEro : imEroBox;
+      Image<T> &out   = whole ? imOut : imOutBox;
+      if (!whole) {
+        crop(imEro, start[0], start[1], start[2], size[0], size[1], size[2],
+             imEroBox);
+        crop(imOut, start[0], start[1], start[2], size[0], size[1], size[2],
+             imOutBox);
+      }
+      imTemp.setSize(ero);
+
+      erode(ero, ero, se);
+      open(ero, imTemp, se);
+      sub(ero, imTemp, imTemp);
+      sup(out, imTemp, imTemp);
+      idempt = equ(imTemp, out);
+
+      copy(imTemp, imOut, start[0], start[1], start[2]);
+      if (!whole)
+        copy(imEroBox, imEro, start[0], start[1], start[2]);
+
+      if (centered && !idempt) {
+        // The next erosion can only be smaller
+        if (!skelNonMinBox(ero, box))
+          break;
+        for (int i = 0; i < 3; i++) {
+          box[i] += start[i];
+          box[i + 3] += start[i];
+        }
+      }
     } while (!idempt);
 
     return RES_OK;
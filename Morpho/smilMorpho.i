@@ -48,8 +48,10 @@ SMIL_MODULE(smilMorpho)
 #include "DSkeleton.hpp"
 #include "DMorphoInstance.h"
 #include "DMorphoMaxTree.hpp"
+#include "DMorphoComponentTree.hpp"
 #include "DMorphoGraph.hpp"
 #include "DMorphoMeasures.hpp"
+#include "DMorphoSurfaceDistance.hpp"
 %}
 
 
@@ -122,12 +124,20 @@ TEMPLATE_WRAP_FUNC(levelPics);
 TEMPLATE_WRAP_FUNC_2T_CROSS(distance);
 TEMPLATE_WRAP_FUNC_2T_CROSS(distanceEuclideanOld);
 TEMPLATE_WRAP_FUNC_2T_CROSS(distanceEuclidean);
+TEMPLATE_WRAP_FUNC_2T_CROSS(distanceEuclideanFeature);
 TEMPLATE_WRAP_FUNC_2T_CROSS(distanceGeodesic);
+TEMPLATE_WRAP_FUNC_2T_CROSS(distanceGeodesicEuclidean);
+TEMPLATE_WRAP_FUNC_3T_CROSS(distanceGeodesicWeighted);
 
 TEMPLATE_WRAP_FUNC_2T_CROSS(dist);
 TEMPLATE_WRAP_FUNC_2T_CROSS(distEuclidean);
 TEMPLATE_WRAP_FUNC_2T_CROSS(distGeodesic);
 
+%include "Morpho/include/private/DMorphoSurfaceDistance.hpp"
+TEMPLATE_WRAP_FUNC(distanceHausdorff);
+TEMPLATE_WRAP_FUNC(distanceHausdorffPercentile);
+TEMPLATE_WRAP_FUNC(distanceAverageSurface);
+
 %include "Morpho/include/private/DMorphoExtrema.hpp"
 TEMPLATE_WRAP_FUNC(hMinima);
 TEMPLATE_WRAP_FUNC(hMaxima);
@@ -160,6 +170,7 @@ TEMPLATE_WRAP_FUNC(lblSkiz);
 TEMPLATE_WRAP_FUNC_2T_CROSS(inflBasins);
 TEMPLATE_WRAP_FUNC(inflZones);
 TEMPLATE_WRAP_FUNC(waterfall);
+TEMPLATE_WRAP_CLASS(WatershedHierarchy, WatershedHierarchy);
 %feature("director") BaseFlooding;
 TEMPLATE_WRAP_CLASS_2T_CROSS(BaseFlooding, BaseFlooding);
 %feature("director") WatershedFlooding;
@@ -227,6 +238,11 @@ TEMPLATE_WRAP_FUNC(widthClose);
 TEMPLATE_WRAP_FUNC(areaOpen);
 TEMPLATE_WRAP_FUNC(areaClose);
 
+TEMPLATE_WRAP_FUNC(attributeProfile);
+
+%include "Morpho/include/private/DMorphoComponentTree.hpp"
+TEMPLATE_WRAP_CLASS(ComponentTree, ComponentTree);
+
 %include "Morpho/include/private/DMorphoGraph.hpp"
 %feature("director") mosaicToGraphFunct;
 TEMPLATE_WRAP_CLASS_2T_CROSS(mosaicToGraphFunct, mosaicToGraphFunct);
@@ -29,6 +29,9 @@
 
 #include "Core/include/DCore.h"
 #include "DMorphoMaxTree.hpp"
+#include "DMorphoComponentTree.hpp"
+#include "DMorphoLabel.hpp"
+#include "DMorphImageOperations.hxx"
 
 using namespace smil;
 
@@ -428,6 +431,377 @@ class Test_AttributeOpening : public TestCase
   }
 };
 
+class Test_ComponentTree : public TestCase
+{
+  virtual void run()
+  {
+      typedef UINT8 dataType;
+      typedef Image<dataType> imType;
+      
+      imType im1(8,8);
+      imType im2(im1);
+      imType im3(im1);
+      
+      dataType vec1[] = 
+      {
+        1,   1,   1,   1,   1,   1,   1,   1,
+        1,  10,  10,  10,  10,  10,  10,   1,
+        1,  10,  40,  40,  40,  40,  10,   1,
+        1,  10,  40,  50,  50,  50,  10,   1,
+        1,  10,  40,  50,  60,  50,  10,   1,
+        1,  10,  40,  50,  50,  50,  10,   1,
+        1,  10,  10,  10,  10,  10,  10,   1,
+        1,   1,   1,   1,   1,   1,   1,   1,
+      };
+      
+      im1 << vec1;
+      
+      ComponentTree<dataType> tree(im1, true, CrossSE());
+      TEST_ASSERT(tree.getNodeCount() == 5);
+      
+      vector<double> area = tree.getAttribute("area");
+      TEST_ASSERT(area.size() == 5 && area[0] == 64 && area[4] == 1);
+      vector<double> contrast = tree.getAttribute("contrast");
+      TEST_ASSERT(contrast[0] == 59 && contrast[1] == 59 && contrast[4] == 10);
+      vector<double> volume = tree.getAttribute("volume");
+      TEST_ASSERT(volume[4] == 10 && volume[3] == 9 * 10 + 10);
+      
+      // Unfiltered tree gives back the image
+      tree.reconstruct(im2);
+      TEST_ASSERT(im2==im1);
+      
+      // Same as the max-tree based openings, at several thresholds
+      bool ok = true;
+      for (size_t size = 1; size < 70; size += 4)
+      {
+        tree.filter("area", size);
+        tree.reconstruct(im2);
+        areaOpen(im1, size, im3, CrossSE());
+        ok = ok && im2 == im3;
+        
+        tree.filter("height", size % 9);
+        tree.reconstruct(im2);
+        heightOpen(im1, size % 9, im3, CrossSE());
+        ok = ok && im2 == im3;
+        
+        tree.filter("width", size % 9, "min");
+        tree.reconstruct(im2);
+        widthOpen(im1, size % 9, im3, CrossSE());
+        ok = ok && im2 == im3;
+      }
+      TEST_ASSERT(ok);
+      
+      tree.filter("contrast", 15);
+      tree.reconstruct(im2);
+      TEST_ASSERT(im2.getPixel(4, 4) == 50 && im2.getPixel(3, 3) == 50);
+      
+      // Min-tree
+      ComponentTree<dataType> minTree(im1, false, CrossSE());
+      TEST_ASSERT(!minTree.isMaxTree() && minTree.getNodeCount() == 5);
+      minTree.filter("area", 40);
+      minTree.reconstruct(im2);
+      areaClose(im1, 40, im3, CrossSE());
+      TEST_ASSERT(im2 == im3);
+      TEST_ASSERT(im2.getPixel(0, 0) == 10 && im2.getPixel(4, 4) == 60);
+      
+      TEST_ASSERT(tree.filter("unknown", 1) == RES_ERR);
+  }
+};
+
+
+class Test_MaxTree_WideTypes : public TestCase
+{
+  virtual void run()
+  {
+      // Same results on UINT8, UINT32 and float images with the same order
+      Image<UINT8>  im8(32, 24), out8(im8);
+      Image<UINT32> im32(im8), out32(im8);
+      Image<float>  imF(im8), outF(im8);
+      
+      UINT32 seed = 12345;
+      for (size_t i = 0; i < im8.getPixelCount(); i++)
+      {
+        seed = seed * 1103515245 + 12345;
+        UINT8 v = (seed >> 16) % 8 * 32;
+        im8.getPixels()[i] = v;
+        im32.getPixels()[i] = UINT32(v) * 1000003;
+        imF.getPixels()[i] = v * 0.25f - 20.f;
+      }
+      
+      // Radix sort of floats, negative values included
+      vector<size_t> offsets(imF.getPixelCount()), tmp(offsets.size());
+      for (size_t i = 0; i < offsets.size(); i++)
+        offsets[i] = i;
+      vector<size_t> expected(offsets);
+      sortOffsetsByValue(imF.getPixels(), offsets.data(), offsets.size(),
+                         tmp.data());
+      stable_sort(expected.begin(), expected.end(),
+                  OffsetValueLess<float>(imF.getPixels()));
+      TEST_ASSERT(offsets == expected);
+      
+      bool ok = true;
+      for (int op = 0; op < 4; op++)
+      {
+        size_t size = 3 + 5 * op;
+        switch (op)
+        {
+          case 0:
+            areaOpen(im8, size, out8);
+            areaOpen(im32, size, out32);
+            areaOpen(imF, size, outF);
+            break;
+          case 1:
+            areaClose(im8, size, out8);
+            areaClose(im32, size, out32);
+            areaClose(imF, size, outF);
+            break;
+          case 2:
+            heightClose(im8, size, out8);
+            heightClose(im32, size, out32);
+            heightClose(imF, size, outF);
+            break;
+          default:
+            widthOpen(im8, size, out8);
+            widthOpen(im32, size, out32);
+            widthOpen(imF, size, outF);
+        }
+        for (size_t i = 0; i < im8.getPixelCount(); i++)
+        {
+          UINT8 v = out8.getPixels()[i];
+          ok = ok && out32.getPixels()[i] == UINT32(v) * 1000003;
+          ok = ok && outF.getPixels()[i] == v * 0.25f - 20.f;
+        }
+      }
+      TEST_ASSERT(ok);
+      
+      // Volume filter, volumes being scaled by 0.25
+      ComponentTree<UINT8> tree8(im8);
+      ComponentTree<float> treeF(imF);
+      tree8.filter("volume", 400);
+      tree8.reconstruct(out8);
+      treeF.filter("volume", 100.);
+      treeF.reconstruct(outF);
+      ok = true;
+      for (size_t i = 0; i < im8.getPixelCount(); i++)
+        ok = ok && outF.getPixels()[i] == out8.getPixels()[i] * 0.25f - 20.f;
+      TEST_ASSERT(ok);
+  }
+};
+
+
+class Test_AttributeProfile : public TestCase
+{
+  virtual void run()
+  {
+      Image<UINT8> imIn(40, 30), im1(imIn), im2(imIn);
+      
+      UINT32 seed = 4321;
+      for (size_t i = 0; i < imIn.getPixelCount(); i++)
+      {
+        seed = seed * 1103515245 + 12345;
+        imIn.getPixels()[i] = (seed >> 16) % 16 * 16;
+      }
+      
+      vector<size_t> thresholds;
+      thresholds.push_back(2);
+      thresholds.push_back(7);
+      thresholds.push_back(30);
+      size_t nThr = thresholds.size();
+      
+      const char *criteria[] = { "area", "height", "width" };
+      bool ok = true;
+      for (int c = 0; c < 3; c++)
+      {
+        Image<UINT8> imStack;
+        TEST_ASSERT(attributeProfile(imIn, criteria[c], thresholds, imStack,
+                                     SquSE()) == RES_OK);
+        TEST_ASSERT(imStack.getDepth() == 2 * nThr);
+        
+        for (size_t k = 0; k < nThr; k++)
+        {
+          if (c == 0)
+          {
+            areaOpen(imIn, thresholds[k], im1, SquSE());
+            areaClose(imIn, thresholds[k], im2, SquSE());
+          }
+          else if (c == 1)
+          {
+            heightOpen(imIn, thresholds[k], im1, SquSE());
+            heightClose(imIn, thresholds[k], im2, SquSE());
+          }
+          else
+          {
+            widthOpen(imIn, thresholds[k], im1, SquSE());
+            widthClose(imIn, thresholds[k], im2, SquSE());
+          }
+          UINT8 *open = imStack.getPixels() + k * imIn.getPixelCount();
+          UINT8 *close = open + nThr * imIn.getPixelCount();
+          for (size_t i = 0; i < imIn.getPixelCount(); i++)
+            ok = ok && open[i] == im1.getPixels()[i]
+                    && close[i] == im2.getPixels()[i];
+        }
+      }
+      TEST_ASSERT(ok);
+      
+      // One image per filter
+      vector<Image<UINT8> *> imOuts;
+      for (size_t k = 0; k < 2 * nThr; k++)
+        imOuts.push_back(new Image<UINT8>(imIn));
+      TEST_ASSERT(attributeProfile(imIn, "area", thresholds, imOuts,
+                                   SquSE()) == RES_OK);
+      areaOpen(imIn, 7, im1, SquSE());
+      areaClose(imIn, 30, im2, SquSE());
+      TEST_ASSERT(*imOuts[1] == im1 && *imOuts[5] == im2);
+      for (size_t k = 0; k < imOuts.size(); k++)
+        delete imOuts[k];
+  }
+};
+
+/*
+ * Reference attribute opening, by threshold decomposition : each pixel takes
+ * the highest level at which its connected component of the upper threshold
+ * set has an attribute ("area", "height" or "width") not lower than size.
+ */
+template <class T>
+void attributeOpenRef(const Image<T> &imIn, const char *criterion,
+                      size_t size, const StrElt &se, Image<T> &imOut)
+{
+  size_t w = imIn.getWidth(), h = imIn.getHeight();
+  size_t n = imIn.getPixelCount();
+  const T *in = imIn.getPixels();
+  T *out = imOut.getPixels();
+
+  vector<T> levels(in, in + n);
+  sort(levels.begin(), levels.end());
+  levels.erase(unique(levels.begin(), levels.end()), levels.end());
+
+  Image<UINT8>  imBin(imIn);
+  Image<UINT32> imLbl(imIn);
+  for (size_t i = 0; i < n; i++)
+    out[i] = levels[0];
+
+  for (size_t k = 1; k < levels.size(); k++)
+  {
+    compare(imIn, ">=", levels[k], UINT8(1), UINT8(0), imBin);
+    size_t nLbl = label(imBin, imLbl, se);
+    const UINT32 *lbl = imLbl.getPixels();
+
+    vector<size_t> area(nLbl + 1, 0);
+    vector<size_t> xmin(nLbl + 1, w), xmax(nLbl + 1, 0);
+    vector<size_t> ymin(nLbl + 1, h), ymax(nLbl + 1, 0);
+    for (size_t i = 0; i < n; i++)
+    {
+      UINT32 l = lbl[i];
+      size_t x = i % w, y = (i / w) % h;
+      area[l]++;
+      xmin[l] = min(xmin[l], x);
+      xmax[l] = max(xmax[l], x);
+      ymin[l] = min(ymin[l], y);
+      ymax[l] = max(ymax[l], y);
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+      UINT32 l = lbl[i];
+      if (l == 0)
+        continue;
+      size_t attr = area[l];
+      if (string(criterion) == "height")
+        attr = ymax[l] - ymin[l] + 1;
+      else if (string(criterion) == "width")
+        attr = xmax[l] - xmin[l] + 1;
+      if (attr >= size)
+        out[i] = levels[k];
+    }
+  }
+}
+
+template <class T>
+void randomTiesImage(Image<T> &im, UINT32 seed, T step)
+{
+  for (size_t i = 0; i < im.getPixelCount(); i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    im.getPixels()[i] = T((seed >> 16) % 6) * step;
+  }
+}
+
+template <class T>
+bool checkAttributeOpenings(const Image<T> &imIn, const StrElt &se)
+{
+  Image<T> im1(imIn), im2(imIn);
+  Core    *core     = Core::getInstance();
+  UINT     nthreads = core->getNumberOfThreads();
+  UINT     threads[2] = { 1, core->getMaxNumberOfThreads() };
+  bool     ok = true;
+
+  for (int t = 0; t < 2; t++)
+  {
+    core->setNumberOfThreads(threads[t]);
+    size_t sizes[] = { 1, 2, 3, 5, 9, 17, 40 };
+    for (int s = 0; s < 7; s++)
+    {
+      areaOpen(imIn, sizes[s], im1, se);
+      attributeOpenRef(imIn, "area", sizes[s], se, im2);
+      ok = ok && im1 == im2;
+
+      heightOpen(imIn, sizes[s] % 11, im1, se);
+      attributeOpenRef(imIn, "height", sizes[s] % 11, se, im2);
+      ok = ok && im1 == im2;
+
+      widthOpen(imIn, sizes[s] % 11, im1, se);
+      attributeOpenRef(imIn, "width", sizes[s] % 11, se, im2);
+      ok = ok && im1 == im2;
+    }
+  }
+  core->setNumberOfThreads(nthreads);
+  return ok;
+}
+
+/*
+ * The max-tree is built on slabs, one per thread, merged along their
+ * boundaries : results shall not depend on the number of threads, and
+ * match a threshold decomposition on images with many plateaus.
+ */
+class Test_MaxTree_Slabs : public TestCase
+{
+  virtual void run()
+  {
+      Image<UINT8> im8(37, 29);
+      randomTiesImage(im8, 17, UINT8(40));
+      TEST_ASSERT(checkAttributeOpenings(im8, CrossSE()));
+      TEST_ASSERT(checkAttributeOpenings(im8, SquSE()));
+
+      // Values on both bytes
+      Image<UINT16> im16(31, 26);
+      randomTiesImage(im16, 23, UINT16(4099));
+      TEST_ASSERT(checkAttributeOpenings(im16, CrossSE()));
+
+      Image<UINT8> im3D(13, 11, 9);
+      randomTiesImage(im3D, 29, UINT8(40));
+      TEST_ASSERT(checkAttributeOpenings(im3D, Cross3DSE()));
+
+      // Ultimate opening, 2D and 3D
+      Core  *core     = Core::getInstance();
+      UINT   nthreads = core->getNumberOfThreads();
+      bool   ok       = true;
+      Image<UINT8> *ims[2] = { &im8, &im3D };
+      for (int i = 0; i < 2; i++)
+      {
+        Image<UINT8>  tr1(*ims[i]), tr2(*ims[i]);
+        Image<UINT16> ind1(*ims[i]), ind2(*ims[i]);
+        StrElt se = i == 0 ? StrElt(CrossSE()) : StrElt(Cross3DSE());
+
+        core->setNumberOfThreads(1);
+        ultimateOpen(*ims[i], tr1, ind1, se);
+        core->setNumberOfThreads(core->getMaxNumberOfThreads());
+        ultimateOpen(*ims[i], tr2, ind2, se);
+        ok = ok && tr1 == tr2 && ind1 == ind2;
+      }
+      core->setNumberOfThreads(nthreads);
+      TEST_ASSERT(ok);
+  }
+};
+
 
 int main()
 {
@@ -437,6 +811,10 @@ int main()
       ADD_TEST(ts, Test_DeltaUO);
       ADD_TEST(ts, Test_UO_MSER);
       ADD_TEST(ts, Test_AttributeOpening);
+      ADD_TEST(ts, Test_ComponentTree);
+      ADD_TEST(ts, Test_MaxTree_WideTypes);
+      ADD_TEST(ts, Test_AttributeProfile);
+      ADD_TEST(ts, Test_MaxTree_Slabs);
       
       return ts.run();
 }
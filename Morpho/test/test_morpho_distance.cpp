@@ -119,11 +119,230 @@ class TestDistanceCross : public TestCase
 };
 
 
+class TestDistanceEuclidean : public TestCase
+{
+  virtual void run()
+  {
+    Image<UINT8>  imIn(23, 17, 9);
+    Image<UINT16> imOut(imIn);
+    Image<UINT32> imFeature(imIn);
+
+    UINT8 *pixels = imIn.getPixels();
+    srand(12);
+    for (size_t i = 0; i < imIn.getPixelCount(); i++)
+      pixels[i] = (rand() % 40) == 0 ? 0 : 255;
+
+    double sx = 5., sy = 5., sz = 12.;
+    TEST_ASSERT(distanceEuclideanFeature(imIn, imOut, imFeature, sx, sy,
+                                         sz) == RES_OK);
+
+    UINT16 *out = imOut.getPixels();
+    UINT32 *ft  = imFeature.getPixels();
+    size_t  w = imIn.getWidth(), h = imIn.getHeight();
+
+    bool ok = true;
+    for (size_t p = 0; p < imIn.getPixelCount() && ok; p++) {
+      double px = p % w, py = (p / w) % h, pz = p / (w * h);
+      double best = 1e30;
+      for (size_t q = 0; q < imIn.getPixelCount(); q++) {
+        if (pixels[q] != 0)
+          continue;
+        double dx = sx * (px - double(q % w));
+        double dy = sy * (py - double((q / w) % h));
+        double dz = sz * (pz - double(q / (w * h)));
+        best      = std::min(best, dx * dx + dy * dy + dz * dz);
+      }
+      UINT32 f = ft[p];
+      double dx = sx * (px - double(f % w));
+      double dy = sy * (py - double((f / w) % h));
+      double dz = sz * (pz - double(f / (w * h)));
+      ok        = out[p] == UINT16(std::sqrt(best)) && pixels[f] == 0 &&
+           std::fabs(dx * dx + dy * dy + dz * dz - best) < 1e-6;
+    }
+    TEST_ASSERT(ok);
+
+    // Isotropic 2D
+    Image<UINT8> im2(10, 10);
+    Image<UINT8> imD(im2);
+    fill(im2, UINT8(255));
+    im2.setPixel(2, 3, UINT8(0));
+    distanceEuclidean(im2, imD);
+    TEST_ASSERT(imD.getPixel(2, 3) == 0);
+    TEST_ASSERT(imD.getPixel(5, 7) == 5);
+    TEST_ASSERT(imD.getPixel(9, 3) == 7);
+    TEST_ASSERT(imD.getPixel(3, 4) == 1);
+  }
+};
+
+class TestDistanceGeodesicEuclidean : public TestCase
+{
+  virtual void run()
+  {
+    Image<UINT8> imIn(20, 20);
+    Image<UINT8> imMask(imIn);
+    Image<float> imOut(imIn);
+
+    // Two components of the mask, separated by a vertical wall. The second
+    // one has no zero pixel in imIn
+    fill(imIn, UINT8(255));
+    fill(imMask, UINT8(255));
+    for (size_t y = 0; y < 20; y++)
+      imMask.setPixel(12, y, UINT8(0));
+    imIn.setPixel(2, 5, UINT8(0));
+
+    distanceGeodesicEuclidean(imIn, imMask, imOut);
+    TEST_ASSERT(imOut.getPixel(2, 5) == 0.);
+    TEST_ASSERT(std::fabs(imOut.getPixel(9, 5) - 7.) < 1e-4);
+    TEST_ASSERT(std::fabs(imOut.getPixel(2, 17) - 12.) < 1e-4);
+    // First order scheme : diagonal distances are slightly overestimated
+    double d = imOut.getPixel(8, 11);
+    TEST_ASSERT(d >= 6. * std::sqrt(2.) - 1e-4 && d < 6. * std::sqrt(2.) + 1.);
+    TEST_ASSERT(imOut.getPixel(12, 5) == 0.);
+    TEST_ASSERT(imOut.getPixel(15, 5) == ImDtTypes<float>::max());
+
+    // Anisotropic spacing
+    distanceGeodesicEuclidean(imIn, imMask, imOut, 2., 1.);
+    TEST_ASSERT(std::fabs(imOut.getPixel(9, 5) - 14.) < 1e-4);
+    TEST_ASSERT(std::fabs(imOut.getPixel(2, 17) - 12.) < 1e-4);
+
+    // Uniform cost doubles the distance, a zero cost blocks the paths
+    Image<UINT8> imCost(imIn);
+    Image<float> imOut2(imIn);
+    fill(imCost, UINT8(2));
+    for (size_t y = 0; y < 20; y++)
+      imCost.setPixel(12, y, UINT8(0));
+    distanceGeodesicEuclidean(imIn, imMask, imOut);
+    distanceGeodesicWeighted(imIn, imCost, imOut2);
+    bool ok = true;
+    for (size_t i = 0; i < imOut.getPixelCount() && ok; i++) {
+      float a = imOut.getPixels()[i], b = imOut2.getPixels()[i];
+      ok      = a == ImDtTypes<float>::max()
+                    ? b == a
+                    : std::fabs(2. * a - b) < 1e-3 * (1. + a);
+    }
+    TEST_ASSERT(ok);
+
+    // The cost image type is independent of the seed image type
+    Image<float> imCostF(imIn);
+    Image<float> imOut3(imIn);
+    copy(imCost, imCostF);
+    mul(imCostF, 0.5f, imCostF);
+    distanceGeodesicWeighted(imIn, imCostF, imOut3);
+    ok = true;
+    for (size_t i = 0; i < imOut.getPixelCount() && ok; i++) {
+      float a = imOut.getPixels()[i], b = imOut3.getPixels()[i];
+      ok      = a == ImDtTypes<float>::max()
+                    ? b == a
+                    : std::fabs(a - b) < 1e-3 * (1. + a);
+    }
+    TEST_ASSERT(ok);
+
+    // Integer output is truncated
+    Image<UINT16> imOut16(imIn);
+    distanceGeodesicEuclidean(imIn, imMask, imOut16);
+    TEST_ASSERT(imOut16.getPixel(9, 5) == 7);
+    TEST_ASSERT(imOut16.getPixel(15, 5) == ImDtTypes<UINT16>::max());
+  }
+};
+
+/*
+ * Two overlapping squares, shifted along the diagonal
+ */
+static void surfaceTestImages(Image<UINT8> &imGt, Image<UINT8> &imIn)
+{
+  const size_t dim = 256;
+
+  imGt.setSize(dim, dim);
+  imIn.setSize(dim, dim);
+  fill(imGt, UINT8(0));
+  fill(imIn, UINT8(0));
+  for (size_t j = dim / 8; j < 5 * dim / 8; j++)
+    for (size_t i = dim / 8; i < 5 * dim / 8; i++)
+      imGt.setPixel(i, j, UINT8(255));
+  for (size_t j = 2 * dim / 8; j < 7 * dim / 8; j++)
+    for (size_t i = 2 * dim / 8; i < 7 * dim / 8; i++)
+      imIn.setPixel(i, j, UINT8(255));
+}
+
+class TestDistanceHausdorff : public TestCase
+{
+  virtual void run()
+  {
+    Image<UINT8> imGt, imIn;
+    surfaceTestImages(imGt, imIn);
+
+    double rExpect = 90.510;
+
+    double r = distanceHausdorff(imGt, imIn);
+
+    bool ok = abs(r - rExpect) < 0.001;
+    TEST_ASSERT(ok);
+    if (!ok)
+      cout << "\n\t distanceHausdorff \t" << rExpect << "\t" << r << endl;
+  }
+};
+
+class TestSurfaceDistances : public TestCase
+{
+  virtual void run()
+  {
+    Image<UINT8> imGt, imIn;
+    surfaceTestImages(imGt, imIn);
+
+    // Brute force reference on the boundary pixels
+    Image<UINT8> bGt(imGt), bIn(imIn);
+    gradient(imGt, bGt, SquSE());
+    inf(imGt, bGt, bGt);
+    gradient(imIn, bIn, SquSE());
+    inf(imIn, bIn, bIn);
+    vector<size_t> pGt = nonZeroOffsets(bGt);
+    vector<size_t> pIn = nonZeroOffsets(bIn);
+
+    size_t Size[3];
+    imGt.getSize(Size);
+    ImageBox box(Size);
+
+    vector<double> dGt(pGt.size(), 1e30), dIn(pIn.size(), 1e30);
+    for (size_t i = 0; i < pGt.size(); i++)
+      for (size_t j = 0; j < pIn.size(); j++) {
+        double d = box.getDistance(pGt[i], pIn[j]);
+        dGt[i]   = std::min(dGt[i], d);
+        dIn[j]   = std::min(dIn[j], d);
+      }
+
+    double sum = 0.;
+    for (size_t i = 0; i < dGt.size(); i++)
+      sum += dGt[i];
+    for (size_t j = 0; j < dIn.size(); j++)
+      sum += dIn[j];
+    double rExpect = sum / (dGt.size() + dIn.size());
+    double r       = distanceAverageSurface(imGt, imIn);
+    TEST_ASSERT(abs(r - rExpect) < 1e-6);
+
+    sort(dGt.begin(), dGt.end());
+    sort(dIn.begin(), dIn.end());
+    size_t kGt = size_t(ceil(0.95 * dGt.size())) - 1;
+    size_t kIn = size_t(ceil(0.95 * dIn.size())) - 1;
+    rExpect    = std::max(dGt[kGt], dIn[kIn]);
+    r          = distanceHausdorffPercentile(imGt, imIn, 95.);
+    TEST_ASSERT(abs(r - rExpect) < 1e-6);
+
+    r = distanceHausdorffPercentile(imGt, imIn, 100.);
+    TEST_ASSERT(abs(r - distanceHausdorff(imGt, imIn)) < 1e-6);
+
+    TEST_ASSERT(distanceHausdorff(imGt, imGt) == 0.);
+  }
+};
+
 int main()
 {
   TestSuite ts;
   ADD_TEST(ts, TestDistanceSquare);
   ADD_TEST(ts, TestDistanceCross);      
+  ADD_TEST(ts, TestDistanceEuclidean);
+  ADD_TEST(ts, TestDistanceGeodesicEuclidean);
+  ADD_TEST(ts, TestDistanceHausdorff);
+  ADD_TEST(ts, TestSurfaceDistances);
   return ts.run();     
 }
 
@@ -169,12 +169,67 @@ class Test_HMinMax : public TestCase
   }
 };
 
+class Test_HExtremaTree : public TestCase
+{
+  virtual void run()
+  {
+      typedef UINT8 dataType;
+      typedef Image<dataType> imType;
+
+      imType im1(7,7);
+      imType im2(im1);
+      imType imTruth(im1);
+
+      dataType vec1[] = {
+        114, 133,  74, 160,  57,  25,  37,
+         23,  73,   9, 196, 118,  23, 110,
+        154, 248, 165, 159, 210,  47,  58,
+        213,  74,   8, 163,   3, 240, 213,
+        158,  67,  52, 103, 163, 158,   9,
+         85,  36, 124,  12,   7,  56, 253,
+        214, 148,  20, 200,  53,  10,  58
+      };
+
+      im1 << vec1;
+
+      // One tree for all heights, checked against the reconstruction
+      ComponentTree<dataType> minTree(im1, false, sSE());
+      ComponentTree<dataType> maxTree(im1, true, sSE());
+      dataType heights[] = { 0, 1, 20, 50, 100, 250, 255 };
+
+      for (int i = 0; i < 7; i++)
+      {
+          hDualBuild(im1, heights[i], imTruth, sSE());
+          minima(imTruth, imTruth, sSE());
+          minTree.hExtrema(heights[i], im2);
+          TEST_ASSERT(im2==imTruth);
+
+          hBuild(im1, heights[i], imTruth, sSE());
+          maxima(imTruth, imTruth, sSE());
+          maxTree.hExtrema(heights[i], im2);
+          TEST_ASSERT(im2==imTruth);
+      }
+
+      // A branch lasts at least up to the parent of each of its nodes
+      std::vector<double> dyn = minTree.getAttribute("dynamics");
+      std::vector<double> contrast = minTree.getAttribute("contrast");
+      TEST_ASSERT(dyn.size()==minTree.getNodeCount());
+      TEST_ASSERT(dyn[0]==255.);
+      for (size_t i = 0; i < dyn.size(); i++)
+        TEST_ASSERT(dyn[i]>=contrast[i]);
+
+      if (retVal!=RES_OK)
+        im2.printSelf(1);
+  }
+};
+
 
 int main()
 {
       TestSuite ts;
       ADD_TEST(ts, Test_MinMax);
       ADD_TEST(ts, Test_HMinMax);
+      ADD_TEST(ts, Test_HExtremaTree);
       
       return ts.run();
     
@@ -132,6 +132,75 @@ class Test_MosaicToGraph : public TestCase
 };
 
 
+class Test_MosaicToCSRGraph : public TestCase
+{
+  virtual void run()
+  {
+      typedef UINT16 dataType1;
+      typedef UINT8 dataType2;
+      typedef Image<dataType1> imType1;
+      typedef Image<dataType2> imType2;
+      
+      imType1 im1(7,7);
+      imType2 im2(im1);
+      
+      dataType1 vec1[] = {
+        0, 0, 0, 0, 0, 0, 1, 
+        0, 0, 0, 0, 1, 1, 1, 
+        0, 2, 0, 0, 1, 1, 1, 
+        2, 2, 0, 0, 0, 1, 0, 
+        2, 0, 3, 0, 0, 4, 0, 
+        2, 0, 3, 0, 0, 4, 0, 
+        0, 0, 3, 0, 4, 4, 0
+      };
+      im1 << vec1;
+      
+      dataType2 vec2[] = {
+        0, 0, 0, 10, 20, 20, 60, 
+        0, 0, 0, 10, 10, 10, 10, 
+        0, 2, 0, 7, 20, 10, 10, 
+        2, 2, 0, 10, 10, 10, 10, 
+        2, 0, 3, 0, 10, 4, 10, 
+        2, 0, 3, 0, 0, 4, 0, 
+        0, 0, 3, 0, 4, 4, 0
+      };
+      im2 << vec2;
+      
+      CSRGraph<UINT, double> gMin, gMean, gMax;
+      TEST_ASSERT(mosaicToCSRGraph(im1, im2, gMin, "min")==RES_OK);
+      TEST_ASSERT(mosaicToCSRGraph(im1, im2, gMean, "mean")==RES_OK);
+      TEST_ASSERT(mosaicToCSRGraph(im1, im2, gMax, "max")==RES_OK);
+      
+      vector<Edge<UINT, double> > trueEdges;
+      trueEdges.push_back(Edge<UINT, double>(1,0,7));
+      trueEdges.push_back(Edge<UINT, double>(2,0,0));
+      trueEdges.push_back(Edge<UINT, double>(3,2,2));
+      trueEdges.push_back(Edge<UINT, double>(3,0,0));
+      trueEdges.push_back(Edge<UINT, double>(4,0,0));
+      trueEdges.push_back(Edge<UINT, double>(4,1,4));
+      
+      TEST_ASSERT(trueEdges==gMin.getEdges());
+      if (retVal!=RES_OK)
+          gMin.printSelf();
+      
+      // Edge (1,0) : 60 is the highest value on the boundary
+      TEST_ASSERT(gMax.getEdges()[0].weight==60);
+      for (size_t i=0;i<gMin.getEdgeNbr();i++)
+      {
+          TEST_ASSERT(gMin.getEdges()[i].weight<=gMean.getEdges()[i].weight);
+          TEST_ASSERT(gMean.getEdges()[i].weight<=gMax.getEdges()[i].weight);
+      }
+      
+      TEST_ASSERT(gMin.getNodeNbr()==5);
+      TEST_ASSERT(gMin.getDegree(gMin.getNodeIndex(0))==4);
+      TEST_ASSERT(gMin.getDegree(gMin.getNodeIndex(3))==2);
+      TEST_ASSERT(gMin.getNodeIndex(5)==gMin.getNodeNbr());
+      
+      TEST_ASSERT(mosaicToCSRGraph(im1, im2, gMin, "median")==RES_ERR);
+  }
+};
+
+
 class Test_DrawGraph : public TestCase
 {
   virtual void run()
@@ -186,6 +255,7 @@ int main()
 {
       TestSuite ts;
       ADD_TEST(ts, Test_MosaicToGraph);
+      ADD_TEST(ts, Test_MosaicToCSRGraph);
       ADD_TEST(ts, Test_DrawGraph);
       
       return ts.run();
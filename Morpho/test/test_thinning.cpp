@@ -28,8 +28,10 @@
 
 
 #include "Core/include/DCore.h"
+#include "Base/include/DBase.h"
 #include "DCompositeSE.h"
 #include "DHitOrMiss.hpp"
+#include "DMorpho.h"
 
 using namespace smil;
 
@@ -227,12 +229,137 @@ class Test_LineJunc : public TestCase
   }
 };
 
+class Test_FullThinActive : public TestCase
+{
+  virtual void run()
+  {
+    typedef UINT8           dataType;
+    typedef Image<dataType> imType;
+
+    // Whole image iterations, as a reference
+    imType im2D(64, 48), im3D(24, 20, 12);
+    imType imEdge2D(37, 29), imEdge3D(15, 13, 7);
+    imType *ims[] = {&im2D, &im3D, &imEdge2D, &imEdge3D};
+
+    fill(im2D, dataType(0));
+    drawRectangle(im2D, 5, 4, 30, 20, dataType(255), true);
+    drawDisc(im2D, 44, 30, 12, dataType(255));
+    drawRectangle(im2D, 14, 30, 8, 14, dataType(255), true);
+
+    fill(im3D, dataType(0));
+    drawRectangle(im3D, 3, 2, 14, 12, dataType(255), true);
+    drawRectangle(im3D, 12, 8, 10, 10, dataType(255), true);
+    for (size_t z = 1; z < 11; z++) {
+      copy(im3D, 0, 0, 0, 24, 20, 1, im3D, 0, 0, z);
+    }
+
+    // Shapes touching every edge and corner of the image
+    fill(imEdge2D, dataType(255));
+    drawDisc(imEdge2D, 10, 9, 5, dataType(0));
+    drawDisc(imEdge2D, 25, 18, 6, dataType(0));
+    drawRectangle(imEdge2D, 3, 20, 12, 5, dataType(0), true);
+    drawLine(imEdge2D, 0, 14, 36, 14, dataType(0));
+    drawLine(imEdge2D, 18, 0, 18, 28, dataType(0));
+    drawLine(imEdge2D, 30, 0, 36, 6, dataType(0));
+
+    fill(imEdge3D, dataType(255));
+    drawRectangle(imEdge3D, 3, 3, 6, 5, dataType(0), true);
+    drawLine(imEdge3D, 0, 10, 14, 10, dataType(0));
+    for (size_t z = 2; z < 5; z++) {
+      copy(imEdge3D, 0, 0, 0, 15, 13, 1, imEdge3D, 0, 0, z);
+    }
+    drawRectangle(imEdge3D, 10, 0, 5, 6, dataType(0), true);
+
+    CompStrEltList sel = HMT_sL1(4) | HMT_sL2(4);
+
+    for (int i = 0; i < 4; i++) {
+      imType &im1 = *ims[i];
+      imType  im2(im1), im3(im1), im4(im1);
+
+      copy(im1, im3);
+      do {
+        copy(im3, im4);
+        thin(im4, sel, im3);
+      } while (!equ(im3, im4));
+      fullThin(im1, sel, im2);
+      TEST_ASSERT(im2 == im3);
+
+      copy(im1, im3);
+      do {
+        copy(im3, im4);
+        thick(im4, HMT_hD(6), im3);
+      } while (!equ(im3, im4));
+      fullThick(im1, HMT_hD(6), im2);
+      TEST_ASSERT(im2 == im3);
+
+      StrElt se = i % 2 == 0 ? StrElt(HexSE()) : StrElt(CubeSE());
+      imType imEro(im1, true), imTmp(im1);
+      fill(im3, dataType(0));
+      do {
+        copy(im3, im4);
+        erode(imEro, imEro, se);
+        open(imEro, imTmp, se);
+        sub(imEro, imTmp, imTmp);
+        sup(im3, imTmp, im3);
+      } while (!equ(im3, im4));
+      skeleton(im1, im2, se);
+      TEST_ASSERT(im2 == im3);
+    }
+  }
+};
+
+class Test_HitOrMissLUT : public TestCase
+{
+  virtual void run()
+  {
+    typedef UINT8           dataType;
+    typedef Image<dataType> imType;
+
+    imType im2D(31, 22), im3D(17, 13, 6);
+    imType *ims[] = {&im2D, &im3D};
+
+    fill(im2D, dataType(0));
+    drawRectangle(im2D, 3, 2, 12, 9, dataType(255), true);
+    drawDisc(im2D, 21, 13, 7, dataType(255));
+    drawLine(im2D, 0, 21, 30, 0, dataType(255));
+
+    fill(im3D, dataType(0));
+    drawRectangle(im3D, 2, 1, 9, 8, dataType(255), true, 1);
+    drawRectangle(im3D, 6, 4, 11, 9, dataType(255), true, 2);
+    drawRectangle(im3D, 0, 3, 5, 10, dataType(255), true, 3);
+
+    CompStrEltList sel = HMT_sL1(8) | HMT_hM(6);
+    dataType       borders[] = {0, 255};
+
+    for (int i = 0; i < 2; i++) {
+      imType &im1 = *ims[i];
+      imType  im2(im1), im3(im1), im4(im1), im5(im1);
+
+      for (int b = 0; b < 2; b++) {
+        // Two erosions for each composite SE
+        fill(im3, dataType(0));
+        inv(im1, im5);
+        for (UINT k = 0; k < sel.compSeList.size(); k++) {
+          erode(im5, im4, sel[k].bgSE, borders[b]);
+          erode(im1, im2, sel[k].fgSE, borders[b]);
+          inf(im2, im4, im4);
+          sup(im3, im4, im3);
+        }
+        hitOrMiss(im1, sel, im2, borders[b]);
+        TEST_ASSERT(im2 == im3);
+      }
+    }
+  }
+};
+
 int main()
 {
       TestSuite ts;
       ADD_TEST(ts, Test_Thin);
       ADD_TEST(ts, Test_FullThin);
       ADD_TEST(ts, Test_LineJunc);
+      ADD_TEST(ts, Test_HitOrMissLUT);
+      ADD_TEST(ts, Test_FullThinActive);
       
       return ts.run();
 }
@@ -479,6 +479,183 @@ class Test_Watershed_Indempotence : public TestCase
 };
 
 
+class Test_WatershedHierarchy : public TestCase
+{
+  virtual void run()
+  {
+      UINT8 vecIn[] = {
+          98,   81,   45,  233,  166,  112,  100,   20,  176,   79,
+              4,   11,   57,  246,  137,   90,   69,  212,   16,  219,
+          131,  165,   20,    4,  201,  100,  166,   57,  144,  104,
+            143,  242,  185,  188,  221,   97,   46,   66,  117,  222,
+          146,  121,  234,  204,  113,  116,   40,  183,   74,   56,
+            147,  205,  221,  168,  210,  168,   14,  122,  226,  158,
+          226,  114,  146,  157,   48,  112,  254,   94,  179,  117,
+              61,   71,  238,   40,   20,   97,  157,   60,   25,  231,
+          116,  173,  181,   83,   86,  137,  252,  100,    4,  223,
+              4,  231,   83,  150,  133,  131,    8,  133,  226,  187,
+      };
+
+      Image<UINT8> imIn(10,10);
+      Image<UINT8> imWs(imIn);
+      Image<UINT8> imTruth(imIn);
+
+      imIn << vecIn;
+
+      WatershedHierarchy<UINT8> hierarchy(imIn, hSE());
+
+      // Level 0 is the watershed itself
+      watershed(imIn, imTruth, hSE());
+      hierarchy.waterfall(0, imWs);
+      TEST_ASSERT(imWs==imTruth);
+
+      // Each waterfall level at least halves the number of regions
+      UINT nLevels = hierarchy.getWaterfallLevelCount();
+      std::vector<double> levels = hierarchy.getSaliency("waterfall");
+      size_t nRegions = hierarchy.getRegionCount();
+      TEST_ASSERT(levels.size()==nRegions-1);
+      for (UINT l = 1; l < nLevels; l++)
+      {
+          size_t merged = 0;
+          for (size_t i = 0; i < levels.size(); i++)
+            merged += levels[i] <= l;
+          TEST_ASSERT(2*(hierarchy.getRegionCount()-merged) <= nRegions);
+          nRegions = hierarchy.getRegionCount()-merged;
+      }
+      TEST_ASSERT(nRegions==1);
+
+      // A single region left : no more lines
+      hierarchy.waterfall(nLevels-1, imWs);
+      TEST_ASSERT(maxVal(imWs)==0);
+
+      waterfall(imIn, nLevels-1, imWs, hSE());
+      TEST_ASSERT(maxVal(imWs)==0);
+
+      // Lines of coarser cuts are on the lines of finer ones
+      Image<UINT8> imWs2(imIn);
+      hierarchy.cut("dynamics", 20, imWs);
+      hierarchy.cut("dynamics", 80, imWs2);
+      TEST_ASSERT(hierarchy.getSaliency("dynamics").size()==levels.size());
+      sup(imWs, imWs2, imTruth);
+      TEST_ASSERT(imTruth==imWs);
+
+      if (retVal!=RES_OK)
+      {
+          imWs.printSelf(1, true);
+          imWs2.printSelf(1, true);
+      }
+  }
+};
+
+
+/*
+ * Hand-checked hierarchy : five vertical basins A..E separated by single
+ * column walls. Along x :
+ *
+ *   x     :  0  1  2  3  4  5  6  7  8  9 10 11
+ *   grad  :  1  1  9  2  4  0  0  0  7  3  5  1
+ *   basin :  A  A  |  B  |  C  C  C  |  D  |  E
+ *
+ * The tree is the chain A-B-C-D-E with passes 9, 4, 7 and 5. At the first
+ * waterfall iteration, A and B merge along their lowest pass, B and C along
+ * 4, D and E along 5 : only the line between C and D is left.
+ *
+ * Line pixels count in the area of the basin they were flooded from : here
+ * the one on their right, giving areas of 6, 6, 12, 6 and 6 pixels.
+ */
+class Test_WatershedHierarchy_Truth : public TestCase
+{
+  virtual void run()
+  {
+      UINT8 vecIn[] = {
+          1,  1,  9,  2,  4,  0,  0,  0,  7,  3,  5,  1,
+          1,  1,  9,  2,  4,  0,  0,  0,  7,  3,  5,  1,
+          1,  1,  9,  2,  4,  0,  0,  0,  7,  3,  5,  1,
+      };
+      UINT8 vecWs0[] = {
+          0,  0,255,  0,255,  0,  0,  0,255,  0,255,  0,
+          0,  0,255,  0,255,  0,  0,  0,255,  0,255,  0,
+          0,  0,255,  0,255,  0,  0,  0,255,  0,255,  0,
+      };
+      UINT8 vecWs1[] = {
+          0,  0,  0,  0,  0,  0,  0,  0,255,  0,  0,  0,
+          0,  0,  0,  0,  0,  0,  0,  0,255,  0,  0,  0,
+          0,  0,  0,  0,  0,  0,  0,  0,255,  0,  0,  0,
+      };
+      UINT8 vecDyn2[] = {
+          0,  0,255,  0,  0,  0,  0,  0,255,  0,  0,  0,
+          0,  0,255,  0,  0,  0,  0,  0,255,  0,  0,  0,
+          0,  0,255,  0,  0,  0,  0,  0,255,  0,  0,  0,
+      };
+
+      Image<UINT8> imIn(12,3);
+      Image<UINT8> imWs(imIn);
+      Image<UINT8> imTruth(imIn);
+
+      imIn << vecIn;
+
+      WatershedHierarchy<UINT8> hierarchy(imIn, sSE());
+      TEST_ASSERT(hierarchy.getRegionCount()==5);
+      TEST_ASSERT(hierarchy.getWaterfallLevelCount()==3);
+
+      hierarchy.waterfall(0, imWs);
+      imTruth << vecWs0;
+      TEST_ASSERT(imWs==imTruth);
+
+      hierarchy.waterfall(1, imWs);
+      imTruth << vecWs1;
+      TEST_ASSERT(imWs==imTruth);
+
+      waterfall(imIn, 1, imWs, sSE());
+      TEST_ASSERT(imWs==imTruth);
+
+      hierarchy.waterfall(2, imWs);
+      TEST_ASSERT(maxVal(imWs)==0);
+
+      // Saliencies, edges being identified by their pass value :
+      //           A-B  B-C  C-D  D-E
+      // waterfall   1    1    2    1
+      // dynamics    8    2    6    2
+      // area        6    6   12    6
+      // volume     48   12   60   12
+      const UINT8  passes[]    = { 9, 4, 7, 5 };
+      const double waterfall[] = { 1, 1, 2, 1 };
+      const double dynamics[]  = { 8, 2, 6, 2 };
+      const double area[]      = { 6, 6, 12, 6 };
+      const double volume[]    = { 48, 12, 60, 12 };
+
+      Graph<UINT, UINT8> mst = hierarchy.getMST();
+      const Graph<UINT, UINT8>::EdgeListType &edges = mst.getEdges();
+      std::vector<double> wf = hierarchy.getSaliency("waterfall");
+      std::vector<double> dyn = hierarchy.getSaliency("dynamics");
+      std::vector<double> ar = hierarchy.getSaliency("area");
+      std::vector<double> vol = hierarchy.getSaliency("volume");
+      TEST_ASSERT(edges.size()==4);
+      TEST_ASSERT(wf.size()==4 && dyn.size()==4);
+      TEST_ASSERT(ar.size()==4 && vol.size()==4);
+      for (size_t i = 0; i < edges.size() && retVal==RES_OK; i++)
+      {
+          size_t j = 0;
+          while (j < 4 && passes[j]!=edges[i].weight)
+            j++;
+          TEST_ASSERT(j < 4);
+          if (j==4)
+            break;
+          TEST_ASSERT(wf[i]==waterfall[j]);
+          TEST_ASSERT(dyn[i]==dynamics[j]);
+          TEST_ASSERT(ar[i]==area[j]);
+          TEST_ASSERT(vol[i]==volume[j]);
+      }
+
+      hierarchy.cut("dynamics", 2, imWs);
+      imTruth << vecDyn2;
+      TEST_ASSERT(imWs==imTruth);
+
+      if (retVal!=RES_OK)
+        imWs.printSelf(1, true);
+  }
+};
+
 
 int main()
 {
@@ -496,6 +673,9 @@ int main()
       ADD_TEST(ts, Test_Watershed_Plateaus);
 
       ADD_TEST(ts, Test_Watershed_Indempotence);
+
+      ADD_TEST(ts, Test_WatershedHierarchy);
+      ADD_TEST(ts, Test_WatershedHierarchy_Truth);
       
       return ts.run();
       